@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2006-2024 RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Soft I2C bus whose SCL/SDA edges are generated by FlexIO shifters and
+ * timers instead of GPIO toggling around udelay(). It registers through
+ * rt_i2c_bit_add_bus(): the FlexIO engine is installed as the bit ops xfer
+ * hook, so the thread only queues bytes and sleeps until the FlexIO
+ * completion interrupt. Every FlexIO transfer ends with a STOP, so only a
+ * single message or a short index write followed by a read of the same
+ * device (sent as one repeated-START transfer) go through FlexIO. Other
+ * multi-message sequences and what FlexIO cannot express at all (10-bit
+ * address, NO_START, ignored NACK...) fall back to bit-banging on the same
+ * pins, which keeps the repeated-START semantics of rt_i2c_transfer().
+ */
+
+#include <rtdevice.h>
+#include "fsl_port.h"
+#include "fsl_flexio_i2c_master.h"
+
+#ifdef BSP_USING_FLEXIO_I2C
+
+#define FLEXIO_I2C_TIMEOUT_MARGIN_MS    10
+#define FLEXIO_I2C_RECOVER_DELAY_US     5
+
+struct flexio_i2c_bus
+{
+    struct rt_i2c_bus_device    parent;
+    struct rt_i2c_bit_ops       ops;
+
+    FLEXIO_I2C_Type             dev;
+    flexio_i2c_master_handle_t  handle;
+    uint32_t                    baud;
+    char                        *name;
+
+    /* Same pads as GPIO (port * 32 + pin) for bit-bang fallback and bus recovery */
+    rt_base_t                   scl_pin;
+    rt_base_t                   sda_pin;
+    port_mux_t                  mux;
+    uint32_t                    scl_pcr;
+    uint32_t                    sda_pcr;
+    rt_bool_t                   gpio_mode;
+
+    struct rt_semaphore         sem;
+    volatile status_t           status;
+};
+
+static struct flexio_i2c_bus flexio_i2c_obj =
+{
+    .dev =
+    {
+        .flexioBase = FLEXIO0,
+        .SCLPinIndex = BSP_FLEXIO_I2C_SCL_FXIO,
+        .SDAPinIndex = BSP_FLEXIO_I2C_SDA_FXIO,
+        .shifterIndex = {0, 1},
+        .timerIndex = {0, 1},
+    },
+    .baud = BSP_FLEXIO_I2C_BAUDRATE,
+    .name = BSP_FLEXIO_I2C_BUS_NAME,
+    .scl_pin = BSP_FLEXIO_I2C_SCL_PIN,
+    .sda_pin = BSP_FLEXIO_I2C_SDA_PIN,
+    .mux = (port_mux_t)BSP_FLEXIO_I2C_PIN_MUX,
+};
+
+static PORT_Type *const flexio_i2c_ports[] = PORT_BASE_PTRS;
+
+#define PIN_PCR(pin)    (flexio_i2c_ports[(pin) / 32]->PCR[(pin) % 32])
+
+/* Hand the pads to FlexIO, restoring the pull-ups set up at init */
+static void flexio_i2c_pins_flexio(struct flexio_i2c_bus *bus)
+{
+    if (!bus->gpio_mode)
+    {
+        return;
+    }
+    PIN_PCR(bus->scl_pin) = bus->scl_pcr;
+    PIN_PCR(bus->sda_pin) = bus->sda_pcr;
+    bus->gpio_mode = RT_FALSE;
+}
+
+/* Take the pads as open-drain GPIO, both lines released */
+static void flexio_i2c_pins_gpio(struct flexio_i2c_bus *bus)
+{
+    if (bus->gpio_mode)
+    {
+        return;
+    }
+    rt_pin_mode(bus->scl_pin, PIN_MODE_OUTPUT_OD);
+    rt_pin_mode(bus->sda_pin, PIN_MODE_OUTPUT_OD);
+    rt_pin_write(bus->scl_pin, PIN_HIGH);
+    rt_pin_write(bus->sda_pin, PIN_HIGH);
+    bus->gpio_mode = RT_TRUE;
+}
+
+static void flexio_i2c_set_sda(void *data, rt_int32_t state)
+{
+    rt_pin_write(((struct flexio_i2c_bus *)data)->sda_pin, state ? PIN_HIGH : PIN_LOW);
+}
+
+static void flexio_i2c_set_scl(void *data, rt_int32_t state)
+{
+    rt_pin_write(((struct flexio_i2c_bus *)data)->scl_pin, state ? PIN_HIGH : PIN_LOW);
+}
+
+static rt_int32_t flexio_i2c_get_sda(void *data)
+{
+    return rt_pin_read(((struct flexio_i2c_bus *)data)->sda_pin);
+}
+
+static rt_int32_t flexio_i2c_get_scl(void *data)
+{
+    return rt_pin_read(((struct flexio_i2c_bus *)data)->scl_pin);
+}
+
+static void flexio_i2c_master_init(struct flexio_i2c_bus *bus)
+{
+    flexio_i2c_master_config_t config;
+
+    FLEXIO_I2C_MasterGetDefaultConfig(&config);
+    config.baudRate_Bps = bus->baud;
+    FLEXIO_I2C_MasterInit(&bus->dev, &config, CLOCK_GetFreq(kCLOCK_FroHfDiv));
+}
+
+/* Clock a slave that holds SDA low free (at most 9 clocks), then STOP */
+static void flexio_i2c_bus_recover(struct flexio_i2c_bus *bus)
+{
+    int i;
+
+    flexio_i2c_pins_gpio(bus);
+    rt_hw_us_delay(FLEXIO_I2C_RECOVER_DELAY_US);
+
+    for (i = 0; i < 9 && rt_pin_read(bus->sda_pin) == PIN_LOW; i++)
+    {
+        rt_pin_write(bus->scl_pin, PIN_LOW);
+        rt_hw_us_delay(FLEXIO_I2C_RECOVER_DELAY_US);
+        rt_pin_write(bus->scl_pin, PIN_HIGH);
+        rt_hw_us_delay(FLEXIO_I2C_RECOVER_DELAY_US);
+    }
+
+    rt_pin_write(bus->scl_pin, PIN_LOW);
+    rt_pin_write(bus->sda_pin, PIN_LOW);
+    rt_hw_us_delay(FLEXIO_I2C_RECOVER_DELAY_US);
+    rt_pin_write(bus->scl_pin, PIN_HIGH);
+    rt_hw_us_delay(FLEXIO_I2C_RECOVER_DELAY_US);
+    rt_pin_write(bus->sda_pin, PIN_HIGH);
+
+    flexio_i2c_master_init(bus);
+}
+
+static void flexio_i2c_callback(FLEXIO_I2C_Type *base, flexio_i2c_master_handle_t *handle, status_t status, void *userData)
+{
+    struct flexio_i2c_bus *bus = (struct flexio_i2c_bus *)userData;
+
+    bus->status = status;
+    rt_sem_release(&bus->sem);
+}
+
+static status_t flexio_i2c_transfer(struct flexio_i2c_bus *bus, flexio_i2c_master_transfer_t *xfer)
+{
+    /* 9 clocks per byte, plus address and sub-address */
+    rt_uint32_t wire_ms = (xfer->dataSize + xfer->subaddressSize + 2) * 9 * 1000 / bus->baud;
+    status_t status;
+
+    rt_sem_control(&bus->sem, RT_IPC_CMD_RESET, RT_NULL);
+
+    status = FLEXIO_I2C_MasterTransferNonBlocking(&bus->dev, &bus->handle, xfer);
+    if (status != kStatus_Success)
+    {
+        return status;
+    }
+
+    if (rt_sem_take(&bus->sem, rt_tick_from_millisecond(wire_ms + FLEXIO_I2C_TIMEOUT_MARGIN_MS)) != RT_EOK)
+    {
+        FLEXIO_I2C_MasterTransferAbort(&bus->dev, &bus->handle);
+        return kStatus_FLEXIO_I2C_Timeout;
+    }
+
+    return bus->status;
+}
+
+/* index write of up to 4 bytes then a read of the same device: one subaddress transfer */
+static rt_bool_t flexio_i2c_mergeable(const struct rt_i2c_msg msgs[], rt_uint32_t num)
+{
+    return num == 2 && !(msgs[0].flags & RT_I2C_RD) && (msgs[1].flags & RT_I2C_RD) &&
+           msgs[1].addr == msgs[0].addr && msgs[0].len <= 4;
+}
+
+/**
+ * Bit ops engine hook. FlexIO always ends a transfer with STOP and can only
+ * produce a repeated START through its sub-address phase. It therefore takes
+ * a single message, or a short index write followed by a read of the same
+ * device merged into one transfer. Any other sequence returns -RT_ENOSYS so
+ * the bit-banged path sends it with real repeated STARTs.
+ */
+static rt_ssize_t flexio_i2c_xfer(void *data, struct rt_i2c_msg msgs[], rt_uint32_t num)
+{
+    const rt_uint16_t unsupported = RT_I2C_ADDR_10BIT | RT_I2C_NO_START | RT_I2C_IGNORE_NACK |
+                                    RT_I2C_NO_READ_ACK | RT_I2C_NO_STOP;
+    struct flexio_i2c_bus *bus = (struct flexio_i2c_bus *)data;
+    flexio_i2c_master_transfer_t xfer;
+    struct rt_i2c_msg *msg = &msgs[0];
+    rt_uint32_t i, n;
+    status_t status;
+
+    for (i = 0; i < num; i++)
+    {
+        if ((msgs[i].flags & unsupported) || msgs[i].len == 0)
+        {
+            break;
+        }
+    }
+    if (num == 0 || i < num || (num > 1 && !flexio_i2c_mergeable(msgs, num)))
+    {
+        /* the bit-banged path drives the pads as GPIO */
+        flexio_i2c_pins_gpio(bus);
+        return -RT_ENOSYS;
+    }
+
+    flexio_i2c_pins_flexio(bus);
+
+    rt_memset(&xfer, 0, sizeof(xfer));
+    xfer.slaveAddress = msg->addr;
+    if (num == 2)
+    {
+        for (n = 0; n < msg->len; n++)
+        {
+            xfer.subaddress = (xfer.subaddress << 8) | msg->buf[n];
+        }
+        xfer.subaddressSize = msg->len;
+        msg = &msgs[1];
+    }
+    xfer.direction = (msg->flags & RT_I2C_RD) ? kFLEXIO_I2C_Read : kFLEXIO_I2C_Write;
+    xfer.data = msg->buf;
+    xfer.dataSize = msg->len;
+
+    status = flexio_i2c_transfer(bus, &xfer);
+    if (status != kStatus_Success)
+    {
+        if (status != kStatus_FLEXIO_I2C_Nak)
+        {
+            flexio_i2c_bus_recover(bus);
+        }
+        return 0;
+    }
+
+    return num;
+}
+
+int rt_hw_flexio_i2c_init(void)
+{
+    struct flexio_i2c_bus *bus = &flexio_i2c_obj;
+
+    CLOCK_SetClockDiv(kCLOCK_DivFLEXIO0, 1u);
+    CLOCK_AttachClk(kFRO_HF_DIV_to_FLEXIO0);
+    RESET_ReleasePeripheralReset(kFLEXIO0_RST_SHIFT_RSTn);
+
+    /* FlexIO drives the pads open-drain itself, the PORT only adds pull-ups */
+    PORT_SetPinMux(flexio_i2c_ports[bus->scl_pin / 32], bus->scl_pin % 32, bus->mux);
+    PORT_SetPinMux(flexio_i2c_ports[bus->sda_pin / 32], bus->sda_pin % 32, bus->mux);
+    PIN_PCR(bus->scl_pin) |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK | PORT_PCR_IBE_MASK;
+    PIN_PCR(bus->sda_pin) |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK | PORT_PCR_IBE_MASK;
+    bus->scl_pcr = PIN_PCR(bus->scl_pin);
+    bus->sda_pcr = PIN_PCR(bus->sda_pin);
+
+    flexio_i2c_master_init(bus);
+    rt_sem_init(&bus->sem, "sem_fxi2c", 0, RT_IPC_FLAG_FIFO);
+    FLEXIO_I2C_MasterTransferCreateHandle(&bus->dev, &bus->handle, flexio_i2c_callback, bus);
+
+    bus->ops.data = bus;
+    bus->ops.set_sda = flexio_i2c_set_sda;
+    bus->ops.set_scl = flexio_i2c_set_scl;
+    bus->ops.get_sda = flexio_i2c_get_sda;
+    bus->ops.get_scl = flexio_i2c_get_scl;
+    bus->ops.udelay = rt_hw_us_delay;
+    bus->ops.delay_us = 500000 / bus->baud + 1;
+    bus->ops.timeout = rt_tick_from_millisecond(FLEXIO_I2C_TIMEOUT_MARGIN_MS);
+    bus->ops.xfer = flexio_i2c_xfer;
+    bus->parent.priv = &bus->ops;
+
+    return rt_i2c_bit_add_bus(&bus->parent, bus->name);
+}
+INIT_DEVICE_EXPORT(rt_hw_flexio_i2c_init);
+
+#endif /* BSP_USING_FLEXIO_I2C */
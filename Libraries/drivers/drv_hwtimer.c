@@ -17,6 +17,11 @@
 #include <rtdevice.h>
 #include "fsl_ctimer.h"
 
+#ifdef BSP_USING_KTIME
+#include <rthw.h>
+#include "ktime.h"
+#endif
+
 enum
 {
 #ifdef BSP_USING_CTIMER0
@@ -151,14 +156,16 @@ static void mcxa_ctimer_init(rt_hwtimer_t *timer, rt_uint32_t state)
     if(hwtimer_dev == CTIMER1)  CLOCK_AttachClk(kFRO_HF_to_CTIMER1);
     if(hwtimer_dev == CTIMER2)  CLOCK_AttachClk(kFRO_HF_to_CTIMER2);
 
-    CTIMER_Init(hwtimer_dev, &cfg);
-
     if (state == 1)
     {
         NVIC_Configuration();
         CTIMER_GetDefaultConfig(&cfg);
         CTIMER_Init(hwtimer_dev, &cfg);
     }
+    else
+    {
+        CTIMER_Deinit(hwtimer_dev);
+    }
 }
 
 static rt_err_t mcxa_ctimer_start(rt_hwtimer_t *timer, rt_uint32_t cnt, rt_hwtimer_mode_t mode)
@@ -282,5 +289,266 @@ void CTIMER2_IRQHandler(void)
 }
 #endif /* BSP_USING_HWTIMER2 */
 
+#ifdef BSP_USING_KTIME
+/*
+ * ktime port: CTIMER2 runs free at 1 MHz and backs the cputimer, the boottime
+ * clock and the hrtimer. Match channel 0 raises hrtimer timeouts, match
+ * channel 1 wakes the core from tickless idle, match channel 2 fires every
+ * half counter range to keep the 64-bit extension current.
+ */
+#ifdef BSP_USING_CTIMER2
+#error "CTIMER2 is reserved for ktime, disable BSP_USING_CTIMER2"
+#endif
+
+#define KTIME_CTIMER            CTIMER2
+#define KTIME_CTIMER_IRQn       CTIMER2_IRQn
+#define KTIME_FREQ              1000000UL
+#define KTIME_MATCH_HRTIMER     kCTIMER_Match_0
+#define KTIME_MATCH_TICKLESS    kCTIMER_Match_1
+#define KTIME_MATCH_EPOCH       kCTIMER_Match_2
+#define KTIME_EPOCH_STEP        0x80000000UL
+
+static rt_uint32_t ktime_high;      /* software extension of the 32-bit counter */
+static rt_uint32_t ktime_last;
+
+rt_inline rt_uint32_t ktime_count(void)
+{
+    return KTIME_CTIMER->TC;
+}
+
+/*
+ * 64-bit microsecond count. The counter wraps every ~71 minutes; the epoch
+ * match calls this every half wrap from the interrupt, so ktime_last is never
+ * more than one wrap behind even when nothing reads the boottime clock.
+ */
+static rt_uint64_t ktime_count64(void)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    rt_uint32_t now = ktime_count();
+
+    if (now < ktime_last)
+    {
+        ktime_high++;
+    }
+    ktime_last = now;
+    rt_uint64_t count = ((rt_uint64_t)ktime_high << 32) | now;
+    rt_hw_interrupt_enable(level);
+
+    return count;
+}
+
+rt_uint64_t rt_ktime_cputimer_getres(void)
+{
+    return ((1000ULL * 1000 * 1000) * RT_KTIME_RESMUL) / KTIME_FREQ;
+}
+
+unsigned long rt_ktime_cputimer_getfrq(void)
+{
+    return KTIME_FREQ;
+}
+
+unsigned long rt_ktime_cputimer_getcnt(void)
+{
+    return ktime_count();
+}
+
+rt_uint64_t rt_ktime_hrtimer_getres(void)
+{
+    return ((1000ULL * 1000 * 1000) * RT_KTIME_RESMUL) / KTIME_FREQ;
+}
+
+unsigned long rt_ktime_hrtimer_getfrq(void)
+{
+    return KTIME_FREQ;
+}
+
+unsigned long rt_ktime_hrtimer_getcnt(void)
+{
+    return ktime_count();
+}
+
+rt_err_t rt_ktime_hrtimer_settimeout(unsigned long cnt)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    rt_uint32_t match = ktime_count() + cnt;
+
+    KTIME_CTIMER->MR[KTIME_MATCH_HRTIMER] = match;
+    CTIMER_ClearStatusFlags(KTIME_CTIMER, kCTIMER_Match0Flag);
+    CTIMER_EnableInterrupts(KTIME_CTIMER, kCTIMER_Match0InterruptEnable);
+    /* the match may already have passed while it was written */
+    if ((rt_int32_t)(ktime_count() - match) >= 0)
+    {
+        NVIC_SetPendingIRQ(KTIME_CTIMER_IRQn);
+    }
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+/* boottime from the extended count, so it does not wrap with the 32-bit counter */
+rt_err_t rt_ktime_boottime_get_us(struct timeval *tv)
+{
+    rt_uint64_t us = ktime_count64();
+
+    tv->tv_sec  = us / KTIME_FREQ;
+    tv->tv_usec = us % KTIME_FREQ;
+    return RT_EOK;
+}
+
+rt_err_t rt_ktime_boottime_get_s(time_t *t)
+{
+    *t = ktime_count64() / KTIME_FREQ;
+    return RT_EOK;
+}
+
+rt_err_t rt_ktime_boottime_get_ns(struct timespec *ts)
+{
+    rt_uint64_t us = ktime_count64();
+
+    ts->tv_sec  = us / KTIME_FREQ;
+    ts->tv_nsec = (us % KTIME_FREQ) * 1000;
+    return RT_EOK;
+}
+
+void CTIMER2_IRQHandler(void)
+{
+    rt_interrupt_enter();
+    uint32_t int_stat = CTIMER_GetStatusFlags(KTIME_CTIMER);
+    CTIMER_ClearStatusFlags(KTIME_CTIMER, int_stat);
+
+    if (int_stat & kCTIMER_Match2Flag)
+    {
+        KTIME_CTIMER->MR[KTIME_MATCH_EPOCH] += KTIME_EPOCH_STEP;
+        ktime_count64();
+    }
+
+    /* the tickless match only wakes the core, the idle hook accounts the time */
+    if ((KTIME_CTIMER->MCR & kCTIMER_Match0InterruptEnable) &&
+        (rt_int32_t)(ktime_count() - KTIME_CTIMER->MR[KTIME_MATCH_HRTIMER]) >= 0)
+    {
+        CTIMER_DisableInterrupts(KTIME_CTIMER, kCTIMER_Match0InterruptEnable);
+        rt_ktime_hrtimer_process();
+    }
+    rt_interrupt_leave();
+}
+
+#ifdef BSP_USING_TICKLESS
+/*
+ * Tickless idle: when the next soft-timer deadline is at least
+ * BSP_TICKLESS_THRESHOLD ticks away, SysTick is stopped and the core sleeps
+ * until the CTIMER match or any other interrupt. The elapsed time is read from
+ * the free-running counter and credited to the tick in one step before the
+ * waking interrupt runs, then SysTick restarts in phase with the remainder.
+ */
+#define TICKLESS_US_PER_TICK    (1000000UL / RT_TICK_PER_SECOND)
+#define TICKLESS_MAX_TICKS      (60 * RT_TICK_PER_SECOND)
+
+static struct tickless_stats
+{
+    rt_uint32_t sleeps;         /* tickless sleeps entered */
+    rt_uint32_t skipped;        /* SysTick interrupts avoided */
+} tickless_stat;
+
+static void tickless_idle_hook(void)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    rt_tick_t next = rt_timer_next_timeout_tick();
+    rt_tick_t sleep = TICKLESS_MAX_TICKS;
+
+    /* RT_TICK_MAX means no timer is running */
+    if (next != RT_TICK_MAX)
+    {
+        sleep = next - rt_tick_get();
+        if (sleep > RT_TICK_MAX / 2)
+        {
+            sleep = 0;      /* already expired, the tick handler is about to run it */
+        }
+        else if (sleep > TICKLESS_MAX_TICKS)
+        {
+            sleep = TICKLESS_MAX_TICKS;
+        }
+    }
+    if (sleep < BSP_TICKLESS_THRESHOLD)
+    {
+        __DSB();
+        __WFI();
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+
+    /* stop SysTick and note how far into the current tick we are */
+    rt_uint32_t load = SysTick->LOAD + 1;
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    rt_uint32_t part_us = (rt_uint32_t)((rt_uint64_t)(load - SysTick->VAL) * TICKLESS_US_PER_TICK / load);
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        /* a tick is already due, let it be handled normally */
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+
+    rt_uint32_t start = ktime_count();
+    KTIME_CTIMER->MR[KTIME_MATCH_TICKLESS] = start + sleep * TICKLESS_US_PER_TICK - part_us;
+    CTIMER_ClearStatusFlags(KTIME_CTIMER, kCTIMER_Match1Flag);
+    CTIMER_EnableInterrupts(KTIME_CTIMER, kCTIMER_Match1InterruptEnable);
+
+    /* PRIMASK is set: a pending interrupt still ends WFI but its handler runs only after the tick is fixed up */
+    __DSB();
+    __WFI();
+    __ISB();
+
+    CTIMER_DisableInterrupts(KTIME_CTIMER, kCTIMER_Match1InterruptEnable);
+    ktime_count64();
+    rt_uint32_t elapsed_us = ktime_count() - start + part_us;
+    rt_tick_t ticks = elapsed_us / TICKLESS_US_PER_TICK;
+    rt_uint32_t rem_us = elapsed_us % TICKLESS_US_PER_TICK;
+
+    /* restart SysTick so the next tick lands on the original tick grid */
+    SysTick->LOAD = (TICKLESS_US_PER_TICK - rem_us) * (load / TICKLESS_US_PER_TICK) - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = load - 1;
+
+    if (ticks > 0)
+    {
+        tickless_stat.sleeps++;
+        tickless_stat.skipped += ticks;
+        rt_interrupt_enter();
+        rt_tick_increase_tick(ticks);
+        rt_interrupt_leave();
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+static int tickless(void)
+{
+    rt_kprintf("tickless sleeps: %u, ticks skipped: %u, uptime: %u ms\n",
+               tickless_stat.sleeps, tickless_stat.skipped, rt_tick_get() * 1000 / RT_TICK_PER_SECOND);
+    return 0;
+}
+MSH_CMD_EXPORT(tickless, show tickless idle statistics);
+#endif /* BSP_USING_TICKLESS */
+
+static int rt_hw_ktime_init(void)
+{
+    ctimer_config_t cfg;
+
+    CLOCK_AttachClk(kFRO_HF_to_CTIMER2);
+    CTIMER_GetDefaultConfig(&cfg);
+    cfg.prescale = CLOCK_GetCTimerClkFreq(2U) / KTIME_FREQ - 1;
+    CTIMER_Init(KTIME_CTIMER, &cfg);
+    KTIME_CTIMER->MR[KTIME_MATCH_EPOCH] = KTIME_EPOCH_STEP;
+    CTIMER_EnableInterrupts(KTIME_CTIMER, kCTIMER_Match2InterruptEnable);
+    EnableIRQ(KTIME_CTIMER_IRQn);
+    CTIMER_StartTimer(KTIME_CTIMER);
+
+#ifdef BSP_USING_TICKLESS
+    rt_thread_idle_sethook(tickless_idle_hook);
+#endif
+    return RT_EOK;
+}
+INIT_BOARD_EXPORT(rt_hw_ktime_init);
+#endif /* BSP_USING_KTIME */
 
 #endif /* BSP_USING_HWTIMER */
@@ -32,6 +32,27 @@ enum
 
 #define i2c_dbg                 rt_kprintf
 
+#define I2C_NO_DMA              0xff
+/* Messages shorter than this go through the interrupt path, DMA setup would cost more */
+#define I2C_DMA_THRESHOLD       16
+/* Slack added to the computed wire time before a transfer is considered hung */
+#define I2C_TIMEOUT_MARGIN_MS   10
+/* SCL/SDA held low longer than this is reported as kStatus_LPI2C_PinLowTimeout */
+#define I2C_PIN_LOW_TIMEOUT_NS  (10 * 1000 * 1000)
+#define I2C_GLITCH_FILTER_NS    50
+/* Half period of the recovery clock, about 100kHz */
+#define I2C_RECOVER_DELAY_US    5
+
+#ifndef BSP_I2C0_BAUDRATE
+#define BSP_I2C0_BAUDRATE       400000
+#endif
+#ifndef BSP_I2C2_BAUDRATE
+#define BSP_I2C2_BAUDRATE       400000
+#endif
+#ifndef BSP_I2C3_BAUDRATE
+#define BSP_I2C3_BAUDRATE       400000
+#endif
+
 struct lpc_i2c_bus
 {
     struct rt_i2c_bus_device    parent;
@@ -41,98 +62,293 @@ struct lpc_i2c_bus
     clock_name_t                clock_src;
     uint32_t                    baud;
     char                        *name;
+
+    /* Pins (port * 32 + pin) used to clock a stuck slave free, -1 if unknown */
+    rt_base_t                   scl_pin;
+    rt_base_t                   sda_pin;
+
+    /* Interrupt transactional handle, always available */
+    lpi2c_master_handle_t       handle;
+
+    /* eDMA channels, I2C_NO_DMA if the bus has none */
+    uint8_t                     tx_dma_chl;
+    uint8_t                     rx_dma_chl;
+    dma_request_source_t        tx_dma_request;
+    dma_request_source_t        rx_dma_request;
+    edma_handle_t               dma_tx_handle;
+    edma_handle_t               dma_rx_handle;
+    lpi2c_master_edma_handle_t  edma_handle;
+    /* which of the two handles currently owns the LPI2C interrupt */
+    rt_bool_t                   dma_mode;
+
+    /*
+     * The caller sleeps here until the transfer completes. Callers of the same
+     * bus are already queued on the bus mutex of the I2C core.
+     */
+    struct rt_semaphore         sem;
+    volatile status_t           status;
 };
 
 
+/*
+ * eDMA channels 0-3 belong to LPSPI0/1 and 4/5 to the console. The OLED bus
+ * moves 1 KiB per frame and takes the last pair, the other buses use interrupts.
+ */
 struct lpc_i2c_bus lpc_obj[] =
 {
 #ifdef BSP_USING_I2C0
         {
             .I2C = LPI2C0,
-            .baud = 100000U,
-            .clock_attach_id = kFRO12M_to_LPI2C0,
+            .baud = BSP_I2C0_BAUDRATE,
+            .clock_attach_id = kFRO_HF_DIV_to_LPI2C0,
             .clock_div_name = kCLOCK_DivLPI2C0,
-            .clock_src = kCLOCK_Fro12M,
+            .clock_src = kCLOCK_FroHfDiv,
             .name = "i2c0",
+            .scl_pin = -1,
+            .sda_pin = -1,
+            .tx_dma_chl = I2C_NO_DMA,
+            .rx_dma_chl = I2C_NO_DMA,
         },
 #endif
 #ifdef BSP_USING_I2C2
         {
             .I2C = LPI2C2,
-            .baud = 100000U,
-            .clock_attach_id = kFRO12M_to_LPI2C2,
+            .baud = BSP_I2C2_BAUDRATE,
+            .clock_attach_id = kFRO_HF_DIV_to_LPI2C2,
             .clock_div_name = kCLOCK_DivLPI2C2,
-            .clock_src = kCLOCK_Fro12M,
+            .clock_src = kCLOCK_FroHfDiv,
             .name = "i2c2",
+            .scl_pin = 1 * 32 + 9,
+            .sda_pin = 1 * 32 + 8,
+            .tx_dma_chl = 6,
+            .rx_dma_chl = 7,
+            .tx_dma_request = kDma0RequestLPI2C2Tx,
+            .rx_dma_request = kDma0RequestLPI2C2Rx,
         },
 #endif
 #ifdef BSP_USING_I2C3
         {
             .I2C = LPI2C3,
-            .baud = 100000U,
-            .clock_attach_id = kFRO12M_to_LPI2C3,
+            .baud = BSP_I2C3_BAUDRATE,
+            .clock_attach_id = kFRO_HF_DIV_to_LPI2C3,
             .clock_div_name = kCLOCK_DivLPI2C3,
-            .clock_src = kCLOCK_Fro12M,
+            .clock_src = kCLOCK_FroHfDiv,
             .name = "i2c3",
+            .scl_pin = 3 * 32 + 27,
+            .sda_pin = 3 * 32 + 28,
+            .tx_dma_chl = I2C_NO_DMA,
+            .rx_dma_chl = I2C_NO_DMA,
         },
 #endif
 };
 
+static void lpc_i2c_master_init(struct lpc_i2c_bus *lpc_i2c)
+{
+    lpi2c_master_config_t masterConfig;
+
+    LPI2C_MasterGetDefaultConfig(&masterConfig);
+    masterConfig.baudRate_Hz = lpc_i2c->baud;
+    masterConfig.pinLowTimeout_ns = I2C_PIN_LOW_TIMEOUT_NS;
+    masterConfig.sdaGlitchFilterWidth_ns = I2C_GLITCH_FILTER_NS;
+    masterConfig.sclGlitchFilterWidth_ns = I2C_GLITCH_FILTER_NS;
+
+    LPI2C_MasterInit(lpc_i2c->I2C, &masterConfig, CLOCK_GetFreq(lpc_i2c->clock_src));
+}
+
+/**
+ * A slave reset or a master abort in the middle of a read can leave the slave
+ * holding SDA low, and every later START then fails. Take the pins as GPIO,
+ * clock SCL until the slave releases SDA (at most 9 clocks), send a STOP and
+ * hand the pins back to the LPI2C.
+ */
+static void lpc_i2c_bus_recover(struct lpc_i2c_bus *lpc_i2c)
+{
+    static PORT_Type *const ports[] = PORT_BASE_PTRS;
+    PORT_Type *scl_port, *sda_port;
+    uint32_t scl_pcr, sda_pcr;
+    int i;
+
+    if (lpc_i2c->scl_pin < 0 || lpc_i2c->sda_pin < 0)
+    {
+        return;
+    }
+
+    scl_port = ports[lpc_i2c->scl_pin / 32];
+    sda_port = ports[lpc_i2c->sda_pin / 32];
+    scl_pcr = scl_port->PCR[lpc_i2c->scl_pin % 32];
+    sda_pcr = sda_port->PCR[lpc_i2c->sda_pin % 32];
+
+    rt_pin_mode(lpc_i2c->sda_pin, PIN_MODE_INPUT_PULLUP);
+    rt_pin_mode(lpc_i2c->scl_pin, PIN_MODE_OUTPUT_OD);
+    rt_pin_write(lpc_i2c->scl_pin, PIN_HIGH);
+    rt_hw_us_delay(I2C_RECOVER_DELAY_US);
+
+    for (i = 0; i < 9 && rt_pin_read(lpc_i2c->sda_pin) == PIN_LOW; i++)
+    {
+        rt_pin_write(lpc_i2c->scl_pin, PIN_LOW);
+        rt_hw_us_delay(I2C_RECOVER_DELAY_US);
+        rt_pin_write(lpc_i2c->scl_pin, PIN_HIGH);
+        rt_hw_us_delay(I2C_RECOVER_DELAY_US);
+    }
+
+    /* STOP: SDA rises while SCL is high */
+    rt_pin_write(lpc_i2c->scl_pin, PIN_LOW);
+    rt_hw_us_delay(I2C_RECOVER_DELAY_US);
+    rt_pin_mode(lpc_i2c->sda_pin, PIN_MODE_OUTPUT_OD);
+    rt_pin_write(lpc_i2c->sda_pin, PIN_LOW);
+    rt_hw_us_delay(I2C_RECOVER_DELAY_US);
+    rt_pin_write(lpc_i2c->scl_pin, PIN_HIGH);
+    rt_hw_us_delay(I2C_RECOVER_DELAY_US);
+    rt_pin_write(lpc_i2c->sda_pin, PIN_HIGH);
+    rt_hw_us_delay(I2C_RECOVER_DELAY_US);
+
+    scl_port->PCR[lpc_i2c->scl_pin % 32] = scl_pcr;
+    sda_port->PCR[lpc_i2c->sda_pin % 32] = sda_pcr;
+
+    if (i > 0)
+    {
+        i2c_dbg("%s: bus recovered after %d clocks\n", lpc_i2c->name, i);
+    }
+
+    /* also clears a master left in the busy state by the failed transfer */
+    lpc_i2c_master_init(lpc_i2c);
+}
+
+static void lpc_i2c_callback(LPI2C_Type *base, lpi2c_master_handle_t *handle, status_t status, void *userData)
+{
+    struct lpc_i2c_bus *lpc_i2c = (struct lpc_i2c_bus *)userData;
+
+    lpc_i2c->status = status;
+    rt_sem_release(&lpc_i2c->sem);
+}
+
+static void lpc_i2c_edma_callback(LPI2C_Type *base, lpi2c_master_edma_handle_t *handle, status_t status, void *userData)
+{
+    struct lpc_i2c_bus *lpc_i2c = (struct lpc_i2c_bus *)userData;
+
+    lpc_i2c->status = status;
+    rt_sem_release(&lpc_i2c->sem);
+}
+
+/**
+ * Start one message on the bus and sleep until the interrupt or eDMA
+ * completion callback fires, or the wire time plus a margin runs out.
+ */
+static status_t lpc_i2c_transfer(struct lpc_i2c_bus *lpc_i2c, lpi2c_master_transfer_t *xfer)
+{
+    rt_bool_t use_dma = lpc_i2c->tx_dma_chl != I2C_NO_DMA && xfer->dataSize >= I2C_DMA_THRESHOLD;
+    /* 9 clocks per byte plus address */
+    rt_uint32_t wire_ms = (xfer->dataSize + 1) * 9 * 1000 / lpc_i2c->baud;
+    status_t status;
+
+    rt_sem_control(&lpc_i2c->sem, RT_IPC_CMD_RESET, RT_NULL);
+
+    /* The SDK dispatches the LPI2C interrupt to the handle created last */
+    if (use_dma != lpc_i2c->dma_mode)
+    {
+        if (use_dma)
+        {
+            LPI2C_MasterCreateEDMAHandle(lpc_i2c->I2C, &lpc_i2c->edma_handle, &lpc_i2c->dma_rx_handle,
+                                         &lpc_i2c->dma_tx_handle, lpc_i2c_edma_callback, lpc_i2c);
+        }
+        else
+        {
+            LPI2C_MasterTransferCreateHandle(lpc_i2c->I2C, &lpc_i2c->handle, lpc_i2c_callback, lpc_i2c);
+        }
+        lpc_i2c->dma_mode = use_dma;
+    }
+
+    if (use_dma)
+    {
+        status = LPI2C_MasterTransferEDMA(lpc_i2c->I2C, &lpc_i2c->edma_handle, xfer);
+    }
+    else
+    {
+        status = LPI2C_MasterTransferNonBlocking(lpc_i2c->I2C, &lpc_i2c->handle, xfer);
+    }
+    if (status != kStatus_Success)
+    {
+        return status;
+    }
+
+    if (rt_sem_take(&lpc_i2c->sem, rt_tick_from_millisecond(wire_ms + I2C_TIMEOUT_MARGIN_MS)) != RT_EOK)
+    {
+        if (use_dma)
+        {
+            LPI2C_MasterTransferAbortEDMA(lpc_i2c->I2C, &lpc_i2c->edma_handle);
+        }
+        else
+        {
+            LPI2C_MasterTransferAbort(lpc_i2c->I2C, &lpc_i2c->handle);
+        }
+        return kStatus_LPI2C_Timeout;
+    }
+
+    return lpc_i2c->status;
+}
+
+/* A short register index write directly followed by a read of the same device */
+static rt_bool_t lpc_i2c_is_reg_read(struct rt_i2c_msg *wr, struct rt_i2c_msg *rd)
+{
+    return !(wr->flags & RT_I2C_RD) && (rd->flags & RT_I2C_RD) && wr->addr == rd->addr
+           && wr->len > 0 && wr->len <= 4;
+}
+
 static rt_ssize_t lpc_i2c_xfer(struct rt_i2c_bus_device *bus, struct rt_i2c_msg msgs[], rt_uint32_t num)
 {
     struct rt_i2c_msg *msg;
     lpi2c_master_transfer_t xfer = {0};
-    rt_uint32_t i;
-    rt_ssize_t ret = 0;
+    rt_uint32_t i, n, used;
+    status_t status;
 
     struct lpc_i2c_bus *lpc_i2c = (struct lpc_i2c_bus *)bus;
 
-    for (i = 0; i < num; i++)
+    for (i = 0; i < num; i += used)
     {
         msg = &msgs[i];
+        used = 1;
+
+        xfer.slaveAddress = msg->addr;
+        xfer.subaddress = 0;
+        xfer.subaddressSize = 0;
 
-        if (msg->flags & RT_I2C_RD)
+        if (i + 1 < num && lpc_i2c_is_reg_read(msg, &msgs[i + 1]))
         {
-            xfer.slaveAddress = msg->addr;
-            xfer.direction = kLPI2C_Read;
-            xfer.subaddress = 0;
-            xfer.subaddressSize = 0;
-            xfer.data = msg->buf;
-            xfer.dataSize = msg->len;
-            if(i != 0)
-                xfer.flags = kLPI2C_TransferRepeatedStartFlag;
-            else
-                xfer.flags = kLPI2C_TransferDefaultFlag;
-
-            if (LPI2C_MasterTransferBlocking(lpc_i2c->I2C, &xfer) != kStatus_Success)
+            /*
+             * Let the LPI2C send START+W, the index, repeated START+R and the
+             * data as one command sequence, so nothing can separate the
+             * write from the read.
+             */
+            for (n = 0; n < msg->len; n++)
             {
-                i2c_dbg("i2c bus read failed!\n");
-                return i;
+                xfer.subaddress = (xfer.subaddress << 8) | msg->buf[n];
             }
+            xfer.subaddressSize = msg->len;
+            msg = &msgs[i + 1];
+            used = 2;
         }
-        else
+
+        xfer.direction = (msg->flags & RT_I2C_RD) ? kLPI2C_Read : kLPI2C_Write;
+        xfer.data = msg->buf;
+        xfer.dataSize = msg->len;
+        /* STOP only after the last message, the ones before end in a repeated START */
+        xfer.flags = (i + used < num) ? kLPI2C_TransferNoStopFlag : kLPI2C_TransferDefaultFlag;
+
+        status = lpc_i2c_transfer(lpc_i2c, &xfer);
+        if (status != kStatus_Success)
         {
-            xfer.slaveAddress = msg->addr;
-            xfer.direction = kLPI2C_Write;
-            xfer.subaddress = 0;
-            xfer.subaddressSize = 0;
-            xfer.data = msg->buf;
-            xfer.dataSize = msg->len;
-            if(i == 0)
-                xfer.flags = kLPI2C_TransferNoStopFlag;
-            else
-                xfer.flags = kLPI2C_TransferDefaultFlag;
-
-            if (LPI2C_MasterTransferBlocking(lpc_i2c->I2C, &xfer) != kStatus_Success)
+            i2c_dbg("%s: %s 0x%02x failed (%d)!\n", lpc_i2c->name,
+                    (msg->flags & RT_I2C_RD) ? "read" : "write", msg->addr, status);
+            /* A NAK is an answer from the slave, anything else may have left the bus stuck */
+            if (status != kStatus_LPI2C_Nak)
             {
-                i2c_dbg("i2c bus write failed!\n");
-                return i;
+                lpc_i2c_bus_recover(lpc_i2c);
             }
+            return i;
         }
     }
-    ret = i;
 
-    return ret;
+    return i;
 }
 
 static const struct rt_i2c_bus_device_ops i2c_ops =
@@ -145,17 +361,26 @@ static const struct rt_i2c_bus_device_ops i2c_ops =
 int rt_hw_i2c_init(void)
 {
     int i;
-    lpi2c_master_config_t masterConfig;
 
     for(i=0; i<ARRAY_SIZE(lpc_obj); i++)
     {
         CLOCK_SetClockDiv(lpc_obj[i].clock_div_name, 1u);
         CLOCK_AttachClk(lpc_obj[i].clock_attach_id);
 
-        LPI2C_MasterGetDefaultConfig(&masterConfig);
-        masterConfig.baudRate_Hz = lpc_obj[i].baud;
+        /* a slave may still be mid-transfer from before the reset */
+        lpc_i2c_master_init(&lpc_obj[i]);
+        lpc_i2c_bus_recover(&lpc_obj[i]);
+
+        rt_sem_init(&lpc_obj[i].sem, "sem_i2c", 0, RT_IPC_FLAG_FIFO);
+        LPI2C_MasterTransferCreateHandle(lpc_obj[i].I2C, &lpc_obj[i].handle, lpc_i2c_callback, &lpc_obj[i]);
 
-        LPI2C_MasterInit(lpc_obj[i].I2C, &masterConfig, CLOCK_GetFreq(lpc_obj[i].clock_src));
+        if (lpc_obj[i].tx_dma_chl != I2C_NO_DMA)
+        {
+            EDMA_CreateHandle(&lpc_obj[i].dma_tx_handle, DMA0, lpc_obj[i].tx_dma_chl);
+            EDMA_CreateHandle(&lpc_obj[i].dma_rx_handle, DMA0, lpc_obj[i].rx_dma_chl);
+            EDMA_SetChannelMux(DMA0, lpc_obj[i].tx_dma_chl, lpc_obj[i].tx_dma_request);
+            EDMA_SetChannelMux(DMA0, lpc_obj[i].rx_dma_chl, lpc_obj[i].rx_dma_request);
+        }
 
         lpc_obj[i].parent.ops = &i2c_ops;
 
@@ -167,6 +392,3 @@ int rt_hw_i2c_init(void)
 INIT_DEVICE_EXPORT(rt_hw_i2c_init);
 
 #endif /* RT_USING_I2C */
-
-
-
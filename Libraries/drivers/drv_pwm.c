@@ -27,6 +27,8 @@ typedef struct
     pwm_channels_t channel;
     pwm_clock_prescale_t prescale;
     char *name;
+    rt_uint32_t period;     /* configured period in ns, 0 until the first PWM_CMD_SET */
+    rt_uint32_t modulo;     /* counter ticks per period for the configured period */
 } mcx_pwm_obj_t;
 
 static mcx_pwm_obj_t mcx_pwm_list[]=
@@ -65,24 +67,87 @@ static rt_err_t mcx_drv_pwm_get(mcx_pwm_obj_t *pwm, struct rt_pwm_configuration
     return RT_EOK;
 }
 
+/*
+ * Duty-only update: convert the pulse to counter ticks and write the
+ * signed center-aligned edge registers of the channel directly, then
+ * let LDOK load them at the next full-cycle reload.
+ */
+static rt_err_t mcx_drv_pwm_set_pulse(mcx_pwm_obj_t *pwm, struct rt_pwm_configuration *configuration)
+{
+    PWM_Type *base = BOARD_PWM_BASEADDR;
+    uint32_t count;
+    uint16_t half;
+
+    if (pwm->period == 0)
+    {
+        return -RT_ERROR;
+    }
+
+    if (configuration->pulse >= pwm->period)
+    {
+        count = pwm->modulo;
+    }
+    else
+    {
+        count = (uint32_t)(((uint64_t)configuration->pulse * pwm->modulo) / pwm->period);
+    }
+    half = (uint16_t)(count / 2U);
+
+    /* Buffered registers can not be written while LDOK is still set */
+    PWM_SetPwmLdok(base, pwm->control, false);
+    if (pwm->channel == kPWM_PwmA)
+    {
+        base->SM[pwm->submodule].VAL2 = (uint16_t)(-(int16_t)half);
+        base->SM[pwm->submodule].VAL3 = half;
+    }
+    else
+    {
+        base->SM[pwm->submodule].VAL4 = (uint16_t)(-(int16_t)half);
+        base->SM[pwm->submodule].VAL5 = half;
+    }
+    PWM_SetPwmLdok(base, pwm->control, true);
+
+    return RT_EOK;
+}
+
 static rt_err_t mcx_drv_pwm_set(mcx_pwm_obj_t *pwm, struct rt_pwm_configuration *configuration)
 {
-    uint8_t dutyCyclePercent = configuration->pulse * 100 / configuration->period;
     pwm_signal_param_t pwmSignal[1];
-    uint32_t pwmFrequencyInHz = 1000000000 / configuration->period;
+    uint32_t pwmFrequencyInHz;
+
+    if (configuration->period == 0)
+    {
+        return -RT_EINVAL;
+    }
+
+    /* Same period as before, only the duty cycle needs to change */
+    if (configuration->period == pwm->period)
+    {
+        return mcx_drv_pwm_set_pulse(pwm, configuration);
+    }
+
+    pwmFrequencyInHz = 1000000000 / configuration->period;
 
     pwmSignal[0].pwmChannel       = pwm->channel;
     pwmSignal[0].level            = kPWM_HighTrue;
-    pwmSignal[0].dutyCyclePercent = dutyCyclePercent;
+    pwmSignal[0].dutyCyclePercent = 0;
     pwmSignal[0].deadtimeValue    = 0;
     pwmSignal[0].faultState       = kPWM_PwmFaultState0;
     pwmSignal[0].pwmchannelenable = true;
 
-    PWM_SetupPwm(BOARD_PWM_BASEADDR, pwm->submodule, pwmSignal, 1, kPWM_SignedCenterAligned, pwmFrequencyInHz, PWM_SRC_CLK_FREQ);
-    PWM_UpdatePwmDutycycle(BOARD_PWM_BASEADDR, pwm->submodule, pwm->channel, kPWM_SignedCenterAligned, dutyCyclePercent);
-    PWM_SetPwmLdok(BOARD_PWM_BASEADDR, pwm->control, true);
+    PWM_SetPwmLdok(BOARD_PWM_BASEADDR, pwm->control, false);
+    if (PWM_SetupPwm(BOARD_PWM_BASEADDR, pwm->submodule, pwmSignal, 1, kPWM_SignedCenterAligned,
+                     pwmFrequencyInHz, PWM_SRC_CLK_FREQ) != kStatus_Success)
+    {
+        pwm->period = 0;
+        return -RT_ERROR;
+    }
+
+    /* Signed center-aligned mode counts from INIT = -modulo/2 up to VAL1 = modulo/2 - 1 */
+    pwm->modulo = ((uint32_t)BOARD_PWM_BASEADDR->SM[pwm->submodule].VAL1 + 1U) * 2U;
+    pwm->period = configuration->period;
 
-    return 0;
+    return mcx_drv_pwm_set_pulse(pwm, configuration);
 }
 
 static rt_err_t mcx_drv_pwm_enable(mcx_pwm_obj_t *pwm, struct rt_pwm_configuration *configuration)
@@ -113,6 +178,9 @@ static rt_err_t mcx_drv_pwm_control(struct rt_device_pwm *device, int cmd, void
     case PWM_CMD_SET:
         return mcx_drv_pwm_set(pwm, configuration);
 
+    case PWM_CMD_SET_PULSE:
+        return mcx_drv_pwm_set_pulse(pwm, configuration);
+
     case PWM_CMD_GET:
         return mcx_drv_pwm_get(pwm, configuration);
 
@@ -10,9 +10,18 @@
 #include "rtdevice.h"
 #include "drv_spi.h"
 #include "fsl_lpspi.h"
-#include "fsl_lpspi_edma.h"
+#include "fsl_edma.h"
 
-#define DMA_MAX_TRANSFER_SIZE (32767)
+/* Max major loop count of one TCD (CITER is 15 bits without minor loop linking) */
+#define DMA_MAX_TRANSFER_SIZE   (32767)
+/*
+ * TCDs per channel. A message longer than one TCD is sent as a linked
+ * scatter-gather chain; longer than the whole pool it is sent in several chains.
+ */
+#define SPI_DMA_TCD_NUM         (4)
+
+/* LPSPI SCK can run at most at half of the functional clock */
+#define SPI_SCK_DIVIDER_MIN     (2)
 
 enum
 {
@@ -39,20 +48,31 @@ struct lpc_spi
     edma_handle_t               dma_rx_handle;
     dma_request_source_t        tx_dma_request;
     dma_request_source_t        rx_dma_request;
-    lpspi_master_edma_handle_t  spi_dma_handle;
+    /* TCD memory must be 32-byte aligned for scatter-gather */
+    SDK_ALIGN(edma_tcd_t        tx_tcd[SPI_DMA_TCD_NUM], 32);
+    SDK_ALIGN(edma_tcd_t        rx_tcd[SPI_DMA_TCD_NUM], 32);
+
+    /* current bus setting, the controller is re-initialized only when it changes */
+    rt_uint32_t                 max_hz;
+    rt_uint8_t                  mode;
+    rt_uint8_t                  data_width;
 
-    rt_sem_t                    sem;
+    struct rt_semaphore         sem;
     char                        *name;
 };
 
+/*
+ * Each bus owns its own pair of eDMA channels so that both buses can be
+ * enabled at the same time. Channels 4 and up are left for other drivers.
+ */
 static struct lpc_spi lpc_obj[] =
 {
 #ifdef BSP_USING_SPI0
     {
         .LPSPIx = LPSPI0,
-        .clock_attach_id = kFRO12M_to_LPSPI0,
+        .clock_attach_id = kFRO_HF_DIV_to_LPSPI0,
         .clock_div_name = kCLOCK_DivLPSPI0,
-        .clock_name = kCLOCK_Fro12M,
+        .clock_name = kCLOCK_FroHfDiv,
         .tx_dma_request = kDma0RequestLPSPI0Tx,
         .rx_dma_request = kDma0RequestLPSPI0Rx,
         .DMAx = DMA0,
@@ -64,85 +84,196 @@ static struct lpc_spi lpc_obj[] =
 #ifdef BSP_USING_SPI1
     {
         .LPSPIx = LPSPI1,
-        .clock_attach_id = kFRO12M_to_LPSPI1,
+        .clock_attach_id = kFRO_HF_DIV_to_LPSPI1,
         .clock_div_name = kCLOCK_DivLPSPI1,
-        .clock_name = kCLOCK_Fro12M,
+        .clock_name = kCLOCK_FroHfDiv,
         .tx_dma_request = kDma0RequestLPSPI1Tx,
         .rx_dma_request = kDma0RequestLPSPI1Rx,
         .DMAx = DMA0,
-        .tx_dma_chl = 0,
-        .rx_dma_chl = 1,
+        .tx_dma_chl = 2,
+        .rx_dma_chl = 3,
         .name = "spi1",
     },
 #endif
 };
 
+/* Source of TX data when send_buf is NULL, and sink of RX data when recv_buf is NULL */
+static uint32_t spi_dummy_tx = 0;
+static uint32_t spi_dummy_rx;
+
+/* Devices attached through rt_hw_spi_device_attach() are placed at link time, not on the heap */
+#define SPI_DEVICE_POOL_SIZE    2
+static struct rt_spi_device spi_device_pool[SPI_DEVICE_POOL_SIZE];
+static rt_uint8_t spi_device_used;
+
 rt_err_t rt_hw_spi_device_attach(const char *bus_name, const char *device_name, rt_uint32_t pin)
 {
-    struct rt_spi_device *spi_device = rt_malloc(sizeof(struct rt_spi_device));
-    if (!spi_device)
+    if (spi_device_used >= SPI_DEVICE_POOL_SIZE)
     {
-        return -RT_ENOMEM;
+        return -RT_EFULL;
     }
 
-    return rt_spi_bus_attach_device_cspin(spi_device, device_name, bus_name, pin, NULL);
+    rt_err_t ret = rt_spi_bus_attach_device_cspin(&spi_device_pool[spi_device_used], device_name, bus_name, pin, NULL);
+    if (ret == RT_EOK)
+    {
+        spi_device_used++;
+    }
+    return ret;
 }
 
 static rt_err_t spi_configure(struct rt_spi_device *device, struct rt_spi_configuration *cfg)
 {
+    lpspi_master_config_t masterConfig;
+    rt_uint32_t src_hz, baud;
+
+    RT_ASSERT(device != RT_NULL);
+    RT_ASSERT(cfg != RT_NULL);
+
+    struct lpc_spi *spi = device->bus->parent.user_data;
+
+    if (cfg->data_width != 8 && cfg->data_width != 16 && cfg->data_width != 32)
+    {
+        return -RT_EINVAL;
+    }
+
+    if (cfg->max_hz == spi->max_hz && (cfg->mode & RT_SPI_MODE_MASK) == spi->mode
+        && cfg->data_width == spi->data_width)
+    {
+        return RT_EOK;
+    }
+
+    src_hz = CLOCK_GetFreq(spi->clock_name);
+    baud = cfg->max_hz;
+    if (baud == 0 || baud > src_hz / SPI_SCK_DIVIDER_MIN)
+    {
+        baud = src_hz / SPI_SCK_DIVIDER_MIN;
+    }
+
+    LPSPI_MasterGetDefaultConfig(&masterConfig);
+    masterConfig.baudRate     = baud;
+    masterConfig.bitsPerFrame = cfg->data_width;
+    masterConfig.cpol = (cfg->mode & RT_SPI_CPOL) ? kLPSPI_ClockPolarityActiveLow : kLPSPI_ClockPolarityActiveHigh;
+    masterConfig.cpha = (cfg->mode & RT_SPI_CPHA) ? kLPSPI_ClockPhaseSecondEdge : kLPSPI_ClockPhaseFirstEdge;
+    masterConfig.direction = (cfg->mode & RT_SPI_MSB) ? kLPSPI_MsbFirst : kLPSPI_LsbFirst;
+    /* CS is a GPIO, the LPSPI delays only need to cover one SCK period */
+    masterConfig.pcsToSckDelayInNanoSec        = 1000000000U / baud;
+    masterConfig.lastSckToPcsDelayInNanoSec    = 1000000000U / baud;
+    masterConfig.betweenTransferDelayInNanoSec = 1000000000U / baud;
+
+    LPSPI_Deinit(spi->LPSPIx);
+    LPSPI_MasterInit(spi->LPSPIx, &masterConfig, src_hz);
+
+    spi->max_hz = cfg->max_hz;
+    spi->mode = cfg->mode & RT_SPI_MODE_MASK;
+    spi->data_width = cfg->data_width;
+
     return RT_EOK;
 }
 
-static void LPSPI_MasterUserCallback(LPSPI_Type *base, lpspi_master_edma_handle_t *handle, status_t status, void *userData)
+static void spi_dma_rx_callback(edma_handle_t *handle, void *userData, bool transferDone, uint32_t tcds)
 {
     struct lpc_spi *spi = (struct lpc_spi *)userData;
-    rt_sem_release(spi->sem);
 
+    /* RX finishes after TX, so the last RX TCD marks the end of the whole chain */
+    if (transferDone)
+    {
+        rt_sem_release(&spi->sem);
+    }
 }
 
-static rt_ssize_t spixfer(struct rt_spi_device *device, struct rt_spi_message *message)
+/**
+ * Queue one descriptor chain covering at most SPI_DMA_TCD_NUM TCDs per channel,
+ * start it and wait for the single completion of the RX chain.
+ * Returns the number of bytes transferred.
+ */
+static rt_size_t spi_dma_chain(struct lpc_spi *spi, const uint8_t *tx, uint8_t *rx, rt_size_t bytes, uint32_t width)
 {
-    int i;
-    lpspi_transfer_t transfer = {0};
+    edma_transfer_config_t config;
+    uint32_t tx_addr = LPSPI_MasterGetTxRegisterAddress(spi->LPSPIx);
+    uint32_t rx_addr = LPSPI_GetRxRegisterAddress(spi->LPSPIx);
+    rt_size_t done = 0;
+    int n;
+
+    EDMA_InstallTCDMemory(&spi->dma_tx_handle, spi->tx_tcd, SPI_DMA_TCD_NUM);
+    EDMA_InstallTCDMemory(&spi->dma_rx_handle, spi->rx_tcd, SPI_DMA_TCD_NUM);
+
+    for (n = 0; n < SPI_DMA_TCD_NUM && done < bytes; n++)
+    {
+        rt_size_t chunk = bytes - done;
+        if (chunk > DMA_MAX_TRANSFER_SIZE * width)
+        {
+            chunk = DMA_MAX_TRANSFER_SIZE * width;
+        }
+
+        if (rx)
+        {
+            EDMA_PrepareTransferConfig(&config, (void *)rx_addr, width, 0, rx + done, width, width, width, chunk);
+        }
+        else
+        {
+            EDMA_PrepareTransferConfig(&config, (void *)rx_addr, width, 0, &spi_dummy_rx, width, 0, width, chunk);
+        }
+        EDMA_SubmitTransfer(&spi->dma_rx_handle, &config);
+
+        if (tx)
+        {
+            EDMA_PrepareTransferConfig(&config, (void *)(tx + done), width, width, (void *)tx_addr, width, 0, width, chunk);
+        }
+        else
+        {
+            EDMA_PrepareTransferConfig(&config, &spi_dummy_tx, width, 0, (void *)tx_addr, width, 0, width, chunk);
+        }
+        EDMA_SubmitTransfer(&spi->dma_tx_handle, &config);
+
+        done += chunk;
+    }
+
+    EDMA_StartTransfer(&spi->dma_rx_handle);
+    EDMA_StartTransfer(&spi->dma_tx_handle);
+    LPSPI_EnableDMA(spi->LPSPIx, kLPSPI_TxDmaEnable | kLPSPI_RxDmaEnable);
+
+    rt_sem_take(&spi->sem, RT_WAITING_FOREVER);
+
+    LPSPI_DisableDMA(spi->LPSPIx, kLPSPI_TxDmaEnable | kLPSPI_RxDmaEnable);
+
+    return done;
+}
 
+static rt_ssize_t spixfer(struct rt_spi_device *device, struct rt_spi_message *message)
+{
     RT_ASSERT(device != RT_NULL);
     RT_ASSERT(device->bus != RT_NULL);
     RT_ASSERT(device->bus->parent.user_data != RT_NULL);
 
     struct lpc_spi *spi = device->bus->parent.user_data;
+    uint32_t width = spi->data_width / 8;
+    rt_size_t bytes = message->length * width;
+    const uint8_t *tx = message->send_buf;
+    uint8_t *rx = message->recv_buf;
+    rt_size_t done = 0;
 
     if (message->cs_take)
     {
         rt_pin_write(device->cs_pin, PIN_LOW);
     }
 
-    transfer.dataSize = message->length;
-    transfer.rxData   = (uint8_t *)(message->recv_buf);
-    transfer.txData   = (uint8_t *)(message->send_buf);
-
-    /*  if(message->length < MAX_DMA_TRANSFER_SIZE)*/
-    uint32_t block, remain;
-    block = message->length / DMA_MAX_TRANSFER_SIZE;
-    remain = message->length % DMA_MAX_TRANSFER_SIZE;
-
-    for (i = 0; i < block; i++)
+    if (bytes)
     {
-        transfer.dataSize = DMA_MAX_TRANSFER_SIZE;
-        if (message->recv_buf) transfer.rxData   = (uint8_t *)(message->recv_buf + i *DMA_MAX_TRANSFER_SIZE);
-        if (message->send_buf) transfer.txData   = (uint8_t *)(message->send_buf + i *DMA_MAX_TRANSFER_SIZE);
-
-        LPSPI_MasterTransferEDMA(spi->LPSPIx, &spi->spi_dma_handle, &transfer);
-        rt_sem_take(spi->sem, RT_WAITING_FOREVER);
+        /*
+         * Start from empty FIFOs. TX DMA keeps one word queued behind the shifter,
+         * RX DMA drains every received word. CS is a GPIO, so keep the frame
+         * continuous to avoid the between-transfer delay on every word.
+         */
+        LPSPI_FlushFifo(spi->LPSPIx, true, true);
+        LPSPI_ClearStatusFlags(spi->LPSPIx, kLPSPI_AllStatusFlag);
+        LPSPI_SetFifoWatermarks(spi->LPSPIx, 1, 0);
+        spi->LPSPIx->TCR |= LPSPI_TCR_CONT_MASK;
     }
 
-    if (remain)
+    while (done < bytes)
     {
-        transfer.dataSize = remain;
-        if (message->recv_buf) transfer.rxData   = (uint8_t *)(message->recv_buf + i *DMA_MAX_TRANSFER_SIZE);
-        if (message->send_buf) transfer.txData   = (uint8_t *)(message->send_buf + i *DMA_MAX_TRANSFER_SIZE);
-
-        LPSPI_MasterTransferEDMA(spi->LPSPIx, &spi->spi_dma_handle, &transfer);
-        rt_sem_take(spi->sem, RT_WAITING_FOREVER);
+        rt_size_t n = spi_dma_chain(spi, tx ? tx + done : RT_NULL, rx ? rx + done : RT_NULL, bytes - done, width);
+        done += n;
     }
 
     if (message->cs_release)
@@ -169,8 +300,9 @@ int rt_hw_spi_init(void)
         CLOCK_AttachClk(lpc_obj[i].clock_attach_id);
 
         lpc_obj[i].parent.parent.user_data = &lpc_obj[i];
-        lpc_obj[i].sem = rt_sem_create("sem_spi", 0, RT_IPC_FLAG_FIFO);
+        rt_sem_init(&lpc_obj[i].sem, "sem_spi", 0, RT_IPC_FLAG_FIFO);
 
+        /* 1MHz mode 0 until the attached device calls rt_spi_configure() */
         lpspi_master_config_t masterConfig;
         LPSPI_MasterGetDefaultConfig(&masterConfig);
         masterConfig.baudRate = 1 * 1000 * 1000;
@@ -179,6 +311,9 @@ int rt_hw_spi_init(void)
         masterConfig.betweenTransferDelayInNanoSec = 1000000000U / masterConfig.baudRate * 1U;
 
         LPSPI_MasterInit(lpc_obj[i].LPSPIx, &masterConfig, CLOCK_GetFreq(lpc_obj[i].clock_name));
+        lpc_obj[i].max_hz = masterConfig.baudRate;
+        lpc_obj[i].mode = RT_SPI_MODE_0 | RT_SPI_MSB;
+        lpc_obj[i].data_width = 8;
 
         EDMA_CreateHandle(&lpc_obj[i].dma_tx_handle, lpc_obj[i].DMAx, lpc_obj[i].tx_dma_chl);
         EDMA_CreateHandle(&lpc_obj[i].dma_rx_handle, lpc_obj[i].DMAx, lpc_obj[i].rx_dma_chl);
@@ -186,7 +321,8 @@ int rt_hw_spi_init(void)
         EDMA_SetChannelMux(lpc_obj[i].DMAx, lpc_obj[i].tx_dma_chl, lpc_obj[i].tx_dma_request);
         EDMA_SetChannelMux(lpc_obj[i].DMAx, lpc_obj[i].rx_dma_chl, lpc_obj[i].rx_dma_request);
 
-        LPSPI_MasterTransferCreateHandleEDMA(lpc_obj[i].LPSPIx, &lpc_obj[i].spi_dma_handle, LPSPI_MasterUserCallback, &lpc_obj[i], &lpc_obj[i].dma_rx_handle, &lpc_obj[i].dma_tx_handle);
+        /* Only the RX chain reports completion, TX runs without a callback */
+        EDMA_SetCallback(&lpc_obj[i].dma_rx_handle, spi_dma_rx_callback, &lpc_obj[i]);
 
         rt_spi_bus_register(&lpc_obj[i].parent, lpc_obj[i].name, &lpc_spi_ops);
     }
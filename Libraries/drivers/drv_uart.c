@@ -8,12 +8,22 @@
  * 2024-02-06     yandld       The first version for MCX
  * 2024-11-11     hywing       add more UART channels
  */
+#include <rthw.h>
 #include <rtdevice.h>
 #include "drv_uart.h"
 #include "fsl_lpuart.h"
+#ifdef RT_SERIAL_USING_DMA
+#include "fsl_edma.h"
+#endif
 
 #ifdef RT_USING_SERIAL
 
+#ifndef BSP_UART_TX_BUFSZ
+#define BSP_UART_TX_BUFSZ       512
+#endif
+
+#define UART_NO_DMA             0xff
+
 struct mcx_uart
 {
     struct rt_serial_device     *serial;
@@ -24,12 +34,32 @@ struct mcx_uart
     clock_ip_name_t             clock_ip_name;
     clock_div_name_t            clock_div_name;
     char *device_name;
+
+    /*
+     * Byte-wise writes (console, FinSH) go into this ring and are drained
+     * into the TX FIFO by the TX data register empty interrupt.
+     */
+    rt_uint8_t                  *tx_buf;
+    volatile rt_uint16_t        tx_head;
+    volatile rt_uint16_t        tx_tail;
+
+#ifdef RT_SERIAL_USING_DMA
+    /* eDMA channels for RT_DEVICE_FLAG_DMA_TX / RT_DEVICE_FLAG_DMA_RX, UART_NO_DMA if none */
+    uint8_t                     tx_dma_chl;
+    uint8_t                     rx_dma_chl;
+    dma_request_source_t        tx_dma_request;
+    dma_request_source_t        rx_dma_request;
+    edma_handle_t               dma_tx_handle;
+    edma_handle_t               dma_rx_handle;
+    rt_size_t                   rx_dma_pos;     /* RX buffer position already reported to the serial framework */
+#endif
 };
 
 static void uart_isr(struct rt_serial_device *serial);
 
 #if defined(BSP_USING_UART0)
 struct rt_serial_device serial0;
+static rt_uint8_t uart0_tx_buf[BSP_UART_TX_BUFSZ];
 
 void LPUART0_IRQHandler(void)
 {
@@ -38,6 +68,7 @@ void LPUART0_IRQHandler(void)
 #endif
 #if defined(BSP_USING_UART1)
 struct rt_serial_device serial1;
+static rt_uint8_t uart1_tx_buf[BSP_UART_TX_BUFSZ];
 
 void LPUART1_IRQHandler(void)
 {
@@ -46,6 +77,7 @@ void LPUART1_IRQHandler(void)
 #endif
 #if defined(BSP_USING_UART2)
 struct rt_serial_device serial2;
+static rt_uint8_t uart2_tx_buf[BSP_UART_TX_BUFSZ];
 
 void LPUART2_IRQHandler(void)
 {
@@ -53,42 +85,60 @@ void LPUART2_IRQHandler(void)
 }
 #endif
 
-static const struct mcx_uart uarts[] =
+/* eDMA channels 0-3 belong to LPSPI0/1, the console takes 4/5 */
+static struct mcx_uart uarts[] =
 {
 #ifdef BSP_USING_UART0
     {
-        &serial0,
-        LPUART0,
-        LPUART0_IRQn,
-        kCLOCK_Fro12M,
-        kFRO12M_to_LPUART0,
-        kCLOCK_GateLPUART0,
-        kCLOCK_DivLPUART0,
-        "uart0",
+        .serial = &serial0,
+        .uart_base = LPUART0,
+        .irqn = LPUART0_IRQn,
+        .clock_src = kCLOCK_Fro12M,
+        .clock_attach_id = kFRO12M_to_LPUART0,
+        .clock_ip_name = kCLOCK_GateLPUART0,
+        .clock_div_name = kCLOCK_DivLPUART0,
+        .device_name = "uart0",
+        .tx_buf = uart0_tx_buf,
+#ifdef RT_SERIAL_USING_DMA
+        .tx_dma_chl = 4,
+        .rx_dma_chl = 5,
+        .tx_dma_request = kDma0RequestLPUART0Tx,
+        .rx_dma_request = kDma0RequestLPUART0Rx,
+#endif
     },
 #endif
 #ifdef BSP_USING_UART1
     {
-        &serial1,
-        LPUART1,
-        LPUART1_IRQn,
-        kCLOCK_Fro12M,
-        kFRO12M_to_LPUART1,
-        kCLOCK_GateLPUART1,
-        kCLOCK_DivLPUART1,
-        "uart1",
+        .serial = &serial1,
+        .uart_base = LPUART1,
+        .irqn = LPUART1_IRQn,
+        .clock_src = kCLOCK_Fro12M,
+        .clock_attach_id = kFRO12M_to_LPUART1,
+        .clock_ip_name = kCLOCK_GateLPUART1,
+        .clock_div_name = kCLOCK_DivLPUART1,
+        .device_name = "uart1",
+        .tx_buf = uart1_tx_buf,
+#ifdef RT_SERIAL_USING_DMA
+        .tx_dma_chl = UART_NO_DMA,
+        .rx_dma_chl = UART_NO_DMA,
+#endif
     },
 #endif
 #ifdef BSP_USING_UART2
     {
-        &serial2,
-        LPUART2,
-        LPUART2_IRQn,
-        kCLOCK_Fro12M,
-        kFRO12M_to_LPUART2,
-        kCLOCK_GateLPUART2,
-        kCLOCK_DivLPUART2,
-        "uart2",
+        .serial = &serial2,
+        .uart_base = LPUART2,
+        .irqn = LPUART2_IRQn,
+        .clock_src = kCLOCK_Fro12M,
+        .clock_attach_id = kFRO12M_to_LPUART2,
+        .clock_ip_name = kCLOCK_GateLPUART2,
+        .clock_div_name = kCLOCK_DivLPUART2,
+        .device_name = "uart2",
+        .tx_buf = uart2_tx_buf,
+#ifdef RT_SERIAL_USING_DMA
+        .tx_dma_chl = UART_NO_DMA,
+        .rx_dma_chl = UART_NO_DMA,
+#endif
     },
 #endif
 };
@@ -123,30 +173,170 @@ static rt_err_t mcx_configure(struct rt_serial_device *serial, struct serial_con
 
     config.enableTx     = true;
     config.enableRx     = true;
+    /* idle after one character time ends a DMA reception */
+    config.rxIdleType   = kLPUART_IdleTypeStopBit;
+    config.rxIdleConfig = kLPUART_IdleCharacter1;
 
     LPUART_Init(uart->uart_base, &config, CLOCK_GetFreq(uart->clock_src));
 
+    /* TX interrupt is used by the ring, keep the NVIC line open from now on */
+    EnableIRQ(uart->irqn);
+
     return RT_EOK;
 }
 
+/**
+ * Move bytes from the TX ring into the TX FIFO until either is exhausted.
+ * Must be called with interrupts disabled or from the UART ISR.
+ */
+static void uart_tx_drain(struct mcx_uart *uart)
+{
+    LPUART_Type *base = uart->uart_base;
+
+    while (uart->tx_tail != uart->tx_head &&
+           LPUART_GetTxFifoCount(base) < FSL_FEATURE_LPUART_FIFO_SIZEn(base))
+    {
+        LPUART_WriteByte(base, uart->tx_buf[uart->tx_tail]);
+        uart->tx_tail = (uart->tx_tail + 1) % BSP_UART_TX_BUFSZ;
+    }
+
+    if (uart->tx_tail == uart->tx_head)
+    {
+        LPUART_DisableInterrupts(base, kLPUART_TxDataRegEmptyInterruptEnable);
+    }
+}
+
+#ifdef RT_SERIAL_USING_DMA
+static void uart_dma_tx_callback(edma_handle_t *handle, void *userData, bool transferDone, uint32_t tcds)
+{
+    struct mcx_uart *uart = (struct mcx_uart *)userData;
+
+    if (transferDone)
+    {
+        LPUART_EnableTxDMA(uart->uart_base, false);
+        rt_hw_serial_isr(uart->serial, RT_SERIAL_EVENT_TX_DMADONE);
+    }
+}
+
+/* Report what the RX channel wrote since the last report, up to position pos */
+static void uart_rx_dma_report(struct mcx_uart *uart, rt_size_t pos)
+{
+    rt_size_t len = pos - uart->rx_dma_pos;
+
+    uart->rx_dma_pos = pos;
+    if (len > 0)
+    {
+        rt_hw_serial_isr(uart->serial, RT_SERIAL_EVENT_RX_DMADONE | (len << 8));
+    }
+}
+
+static void uart_rx_dma_start(struct mcx_uart *uart)
+{
+    struct rt_serial_rx_fifo *rx_fifo = (struct rt_serial_rx_fifo *)uart->serial->serial_rx;
+    edma_transfer_config_t config;
+
+    EDMA_PrepareTransfer(&config, (void *)LPUART_GetDataRegisterAddress(uart->uart_base), 1,
+                         rx_fifo->buffer, 1, 1, uart->serial->config.bufsz, kEDMA_PeripheralToMemory);
+    EDMA_SubmitTransfer(&uart->dma_rx_handle, &config);
+    EDMA_StartTransfer(&uart->dma_rx_handle);
+    uart->rx_dma_pos = 0;
+}
+
+/* The RX buffer has been filled up to its end: report the tail and wrap to the start */
+static void uart_dma_rx_callback(edma_handle_t *handle, void *userData, bool transferDone, uint32_t tcds)
+{
+    struct mcx_uart *uart = (struct mcx_uart *)userData;
+
+    if (transferDone)
+    {
+        uart_rx_dma_report(uart, uart->serial->config.bufsz);
+        uart_rx_dma_start(uart);
+    }
+}
+
+static rt_err_t uart_dma_config(struct mcx_uart *uart, rt_ubase_t flag)
+{
+    if (flag == RT_DEVICE_FLAG_DMA_TX)
+    {
+        EDMA_CreateHandle(&uart->dma_tx_handle, DMA0, uart->tx_dma_chl);
+        EDMA_SetChannelMux(DMA0, uart->tx_dma_chl, uart->tx_dma_request);
+        EDMA_SetCallback(&uart->dma_tx_handle, uart_dma_tx_callback, uart);
+    }
+    else if (flag == RT_DEVICE_FLAG_DMA_RX)
+    {
+        EDMA_CreateHandle(&uart->dma_rx_handle, DMA0, uart->rx_dma_chl);
+        EDMA_SetChannelMux(DMA0, uart->rx_dma_chl, uart->rx_dma_request);
+        EDMA_SetCallback(&uart->dma_rx_handle, uart_dma_rx_callback, uart);
+
+        uart_rx_dma_start(uart);
+        LPUART_EnableRxDMA(uart->uart_base, true);
+        /* a gap of one character on the line hands the partial buffer to the reader */
+        LPUART_EnableInterrupts(uart->uart_base, kLPUART_IdleLineInterruptEnable);
+    }
+    else
+    {
+        return -RT_EINVAL;
+    }
+
+    return RT_EOK;
+}
+
+static rt_ssize_t mcx_dma_transmit(struct rt_serial_device *serial, rt_uint8_t *buf, rt_size_t size, int direction)
+{
+    struct mcx_uart *uart = (struct mcx_uart *)serial->parent.user_data;
+    edma_transfer_config_t config;
+
+    if (direction != RT_SERIAL_DMA_TX)
+    {
+        return 0;
+    }
+
+    EDMA_PrepareTransfer(&config, buf, 1, (void *)LPUART_GetDataRegisterAddress(uart->uart_base), 1,
+                         1, size, kEDMA_MemoryToPeripheral);
+    EDMA_SubmitTransfer(&uart->dma_tx_handle, &config);
+    EDMA_StartTransfer(&uart->dma_tx_handle);
+    LPUART_EnableTxDMA(uart->uart_base, true);
+
+    return size;
+}
+#endif /* RT_SERIAL_USING_DMA */
+
 static rt_err_t mcx_control(struct rt_serial_device *serial, int cmd, void *arg)
 {
     struct mcx_uart *uart = (struct mcx_uart *)serial->parent.user_data;
+    rt_ubase_t flag = (rt_ubase_t)arg;
 
     RT_ASSERT(uart != RT_NULL);
 
     switch (cmd)
     {
     case RT_DEVICE_CTRL_CLR_INT:
+#ifdef RT_SERIAL_USING_DMA
+        if (flag == RT_DEVICE_FLAG_DMA_RX)
+        {
+            LPUART_DisableInterrupts(uart->uart_base, kLPUART_IdleLineInterruptEnable);
+            LPUART_EnableRxDMA(uart->uart_base, false);
+            EDMA_AbortTransfer(&uart->dma_rx_handle);
+            break;
+        }
+        if (flag == RT_DEVICE_FLAG_DMA_TX)
+        {
+            LPUART_EnableTxDMA(uart->uart_base, false);
+            EDMA_AbortTransfer(&uart->dma_tx_handle);
+            break;
+        }
+#endif
         /* disable rx irq */
         LPUART_DisableInterrupts(uart->uart_base, kLPUART_RxDataRegFullInterruptEnable);
-        DisableIRQ(uart->irqn);
         break;
     case RT_DEVICE_CTRL_SET_INT:
         /* enable rx irq */
         LPUART_EnableInterrupts(uart->uart_base, kLPUART_RxDataRegFullInterruptEnable);
-        EnableIRQ(uart->irqn);
         break;
+#ifdef RT_SERIAL_USING_DMA
+    case RT_DEVICE_CTRL_CONFIG:
+        return uart_dma_config(uart, flag);
+#endif
     }
 
     return RT_EOK;
@@ -155,11 +345,51 @@ static rt_err_t mcx_control(struct rt_serial_device *serial, int cmd, void *arg)
 static int mcx_putc(struct rt_serial_device *serial, char ch)
 {
     struct mcx_uart *uart = (struct mcx_uart *)serial->parent.user_data;
+    rt_uint32_t exception = __get_IPSR();
+    rt_base_t level;
+
+    /*
+     * NMI and fault handlers (exceptions 2..7) never return to let the TX
+     * interrupt run, so flush the ring and write directly to keep the dump
+     * complete. Nothing else runs at that point anyway.
+     */
+    if (exception >= 2 && exception <= 7)
+    {
+        while (uart->tx_tail != uart->tx_head)
+        {
+            uart_tx_drain(uart);
+        }
+        while (!(kLPUART_TxDataRegEmptyFlag & LPUART_GetStatusFlags(uart->uart_base)));
+        LPUART_WriteByte(uart->uart_base, ch);
+        return 1;
+    }
 
-    while(!(kLPUART_TxDataRegEmptyFlag & LPUART_GetStatusFlags(uart->uart_base)));
-    LPUART_WriteByte(uart->uart_base, ch);
-
-    return 1;
+    /*
+     * Everywhere else, including other ISRs and critical sections, the byte is
+     * queued and whatever fits is moved into the FIFO at once; the TX interrupt
+     * sends the rest once interrupts are unmasked. Interrupts stay disabled
+     * for at most one FIFO refill per byte.
+     */
+    while (1)
+    {
+        level = rt_hw_interrupt_disable();
+        rt_uint16_t next = (uart->tx_head + 1) % BSP_UART_TX_BUFSZ;
+        if (next != uart->tx_tail)
+        {
+            uart->tx_buf[uart->tx_head] = ch;
+            uart->tx_head = next;
+            uart_tx_drain(uart);
+            if (uart->tx_tail != uart->tx_head)
+            {
+                LPUART_EnableInterrupts(uart->uart_base, kLPUART_TxDataRegEmptyInterruptEnable);
+            }
+            rt_hw_interrupt_enable(level);
+            return 1;
+        }
+        /* ring full: the writer is faster than the line, wait for one FIFO slot */
+        uart_tx_drain(uart);
+        rt_hw_interrupt_enable(level);
+    }
 }
 
 static int mcx_getc(struct rt_serial_device *serial)
@@ -193,8 +423,34 @@ static void uart_isr(struct rt_serial_device *serial)
     /* enter interrupt */
     rt_interrupt_enter();
 
+    uint32_t status = LPUART_GetStatusFlags(uart->uart_base);
+    uint32_t enabled = LPUART_GetEnabledInterrupts(uart->uart_base);
+
+    if (status & kLPUART_RxOverrunFlag)
+    {
+        LPUART_ClearStatusFlags(uart->uart_base, kLPUART_RxOverrunFlag);
+    }
+
     /* UART in mode Receiver -------------------------------------------------*/
-    rt_hw_serial_isr(serial, RT_SERIAL_EVENT_RX_IND);
+    if ((enabled & kLPUART_RxDataRegFullInterruptEnable) && (status & kLPUART_RxDataRegFullFlag))
+    {
+        rt_hw_serial_isr(serial, RT_SERIAL_EVENT_RX_IND);
+    }
+
+#ifdef RT_SERIAL_USING_DMA
+    if ((enabled & kLPUART_IdleLineInterruptEnable) && (status & kLPUART_IdleLineFlag))
+    {
+        LPUART_ClearStatusFlags(uart->uart_base, kLPUART_IdleLineFlag);
+        uart_rx_dma_report(uart, serial->config.bufsz -
+                           EDMA_GetRemainingMajorLoopCount(DMA0, uart->rx_dma_chl));
+    }
+#endif
+
+    /* UART in mode Transmitter ----------------------------------------------*/
+    if ((enabled & kLPUART_TxDataRegEmptyInterruptEnable) && (status & kLPUART_TxDataRegEmptyFlag))
+    {
+        uart_tx_drain(uart);
+    }
 
     /* leave interrupt */
     rt_interrupt_leave();
@@ -206,11 +462,41 @@ static const struct rt_uart_ops mcx_uart_ops =
     mcx_control,
     mcx_putc,
     mcx_getc,
+#ifdef RT_SERIAL_USING_DMA
+    mcx_dma_transmit,
+#endif
 };
 
+#ifdef RT_DEBUGING_ASSERT
+/*
+ * The stock assertion handler prints and then spins in place. Inside an ISR or
+ * a critical section the TX interrupt never runs again and the message would
+ * stay in the ring, so flush every ring before spinning.
+ */
+static void uart_assert_hook(const char *ex, const char *func, rt_size_t line)
+{
+    volatile char dummy = 0;
+    int i;
+
+    rt_kprintf("(%s) assertion failed at function:%s, line number:%d \n", ex, func, (int)line);
+    rt_backtrace();
+
+    rt_hw_interrupt_disable();
+    for (i = 0; i < sizeof(uarts) / sizeof(uarts[0]); i++)
+    {
+        while (uarts[i].tx_tail != uarts[i].tx_head)
+        {
+            uart_tx_drain(&uarts[i]);
+        }
+    }
+    while (dummy == 0);
+}
+#endif /* RT_DEBUGING_ASSERT */
+
 int rt_hw_uart_init(void)
 {
     struct serial_configure config = RT_SERIAL_CONFIG_DEFAULT;
+    rt_uint32_t flag;
     int i;
 
     for (i = 0; i < sizeof(uarts) / sizeof(uarts[0]); i++)
@@ -218,10 +504,22 @@ int rt_hw_uart_init(void)
         uarts[i].serial->ops    = &mcx_uart_ops;
         uarts[i].serial->config = config;
 
+        flag = RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_RX;
+#ifdef RT_SERIAL_USING_DMA
+        if (uarts[i].tx_dma_chl != UART_NO_DMA)
+        {
+            flag |= RT_DEVICE_FLAG_DMA_TX | RT_DEVICE_FLAG_DMA_RX;
+        }
+#endif
+
         /* register UART device */
-        rt_hw_serial_register(uarts[i].serial, uarts[i].device_name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_RX, (void *)&uarts[i]);
+        rt_hw_serial_register(uarts[i].serial, uarts[i].device_name, flag, (void *)&uarts[i]);
     }
 
+#ifdef RT_DEBUGING_ASSERT
+    rt_assert_set_hook(uart_assert_hook);
+#endif
+
     return 0;
 }
 INIT_BOARD_EXPORT(rt_hw_uart_init);
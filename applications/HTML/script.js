@@ -12,12 +12,23 @@ document.addEventListener('DOMContentLoaded', () => {
     const setTargetBtn = document.getElementById('set_target_btn');
     const setPidBtn = document.getElementById('set_pid_btn');
     const ffTableBody = document.getElementById('ff_table_body');
+    const chart = document.getElementById('stream_chart');
+    const chartCtx = chart.getContext('2d');
+    const streamRate = document.getElementById('stream_rate');
+    const streamLost = document.getElementById('stream_lost');
 
     // --- Constants ---
     const TUNNEL_HEIGHT_PX = 400;
     const MAX_SENSOR_HEIGHT_MM = 500;
+    const CHART_WINDOW_MS = 10000;      // 图表显示最近10秒
     let isFirstMessage = true;
 
+    // --- Stream State ---
+    let streamFrames = [];              // 最近 CHART_WINDOW_MS 内的帧
+    let lastSeq = null;
+    let lostFrames = 0;
+    let framesThisSecond = 0;
+
     // --- Initial Data (from main.c) ---
     const ff_table_initial = [
         { height: 50.0, base_fan_speed: 0.35 },
@@ -40,6 +51,10 @@ document.addEventListener('DOMContentLoaded', () => {
     websocket.onmessage = (event) => {
         try {
             const data = JSON.parse(event.data);
+            if (data.type === 'stream') {
+                handleStream(data.frames);
+                return;
+            }
             if (isFirstMessage) {
                 initializeControlPanel(data);
                 isFirstMessage = false;
@@ -115,6 +130,59 @@ document.addEventListener('DOMContentLoaded', () => {
         targetLine.style.bottom = `${Math.max(0, targetPosition)}px`;
     }
 
+    // --- Stream Functions ---
+    function handleStream(frames) {
+        frames.forEach(frame => {
+            if (lastSeq !== null && frame.seq > lastSeq + 1) {
+                lostFrames += frame.seq - lastSeq - 1;
+            }
+            lastSeq = frame.seq;
+            streamFrames.push(frame);
+        });
+        framesThisSecond += frames.length;
+
+        // 丢弃窗口之外的帧 (tick 为毫秒)
+        const newest = streamFrames[streamFrames.length - 1].tick;
+        while (streamFrames.length && newest - streamFrames[0].tick > CHART_WINDOW_MS) {
+            streamFrames.shift();
+        }
+
+        const latest = frames[frames.length - 1];
+        updateAnimation({ current_height: latest.height, target_height: latest.setpoint });
+        document.getElementById('current_height').textContent = latest.height;
+        document.getElementById('ramped_height').textContent = latest.setpoint.toFixed(6);
+        streamLost.textContent = lostFrames;
+    }
+
+    function drawChart() {
+        const w = chart.width, h = chart.height;
+        chartCtx.clearRect(0, 0, w, h);
+        if (streamFrames.length > 1) {
+            const newest = streamFrames[streamFrames.length - 1].tick;
+            const xOf = f => w - (newest - f.tick) * w / CHART_WINDOW_MS;
+            const plot = (color, yOf) => {
+                chartCtx.strokeStyle = color;
+                chartCtx.beginPath();
+                streamFrames.forEach((f, n) => {
+                    const x = xOf(f), y = yOf(f);
+                    if (n === 0) chartCtx.moveTo(x, y); else chartCtx.lineTo(x, y);
+                });
+                chartCtx.stroke();
+            };
+            const mmToY = mm => h - Math.min(Math.max(mm, 0), MAX_SENSOR_HEIGHT_MM) * h / MAX_SENSOR_HEIGHT_MM;
+            plot('#5a677d', f => h - Math.min(Math.max(f.duty, 0), 1) * h);
+            plot('#2a9d8f', f => mmToY(f.setpoint));
+            plot('#ff6b6b', f => mmToY(f.height));
+        }
+        requestAnimationFrame(drawChart);
+    }
+    requestAnimationFrame(drawChart);
+
+    setInterval(() => {
+        streamRate.textContent = framesThisSecond;
+        framesThisSecond = 0;
+    }, 1000);
+
     function renderFeedforwardTable() {
         ffTableBody.innerHTML = ''; // Clear existing rows
         ff_table_initial.forEach((entry, index) => {
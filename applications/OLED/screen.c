@@ -1,29 +1,102 @@
 #include <rthw.h>
 #include <rtthread.h>
 #include <rtdevice.h>
+#include <string.h>
 #include <u8g2_port.h>
 #include <system_vars.h>
 
+#define SCREEN_REFRESH_MS   100         // 刷新周期 (ms), 10Hz
+#define SCREEN_BAR_MAX_MM   500         // 高度条满量程 (mm)
+#define SCREEN_BAR_Y        46          // 高度条位置和尺寸 (像素)
+#define SCREEN_BAR_H        12
+
+/*
+ * 上一次已经发送到屏幕的帧, 用于找出变化的8x8图块
+ * SSD1306 全缓冲布局: 每个图块行 (8像素高) 占 128 字节, 每字节是一列的8个像素
+ */
+static uint8_t shadow[128 * 64 / 8];
+
+/**
+ * @brief 只把与上一帧不同的图块发送到屏幕, 同一行中连续的脏图块合并为一次传输
+ */
+static void screen_flush_dirty(u8g2_t *u8g2)
+{
+    uint8_t *buf = u8g2_GetBufferPtr(u8g2);
+    int tiles_w = u8g2_GetBufferTileWidth(u8g2);
+    int tiles_h = u8g2_GetBufferTileHeight(u8g2);
+
+    for (int ty = 0; ty < tiles_h; ty++)
+    {
+        uint8_t *row = buf + ty * tiles_w * 8;
+        uint8_t *old = shadow + ty * tiles_w * 8;
+        int run_start = -1;
+
+        for (int tx = 0; tx <= tiles_w; tx++)
+        {
+            rt_bool_t dirty = (tx < tiles_w) && memcmp(row + tx * 8, old + tx * 8, 8) != 0;
+            if (dirty && run_start < 0) {
+                run_start = tx;
+            } else if (!dirty && run_start >= 0) {
+                u8g2_UpdateDisplayArea(u8g2, run_start, ty, tx - run_start, 1);
+                run_start = -1;
+            }
+        }
+        memcpy(old, row, tiles_w * 8);
+    }
+}
+
+/**
+ * @brief 绘制一帧: 当前/目标高度文字和带目标刻度的高度条
+ */
+static void screen_draw(u8g2_t *u8g2, const struct telemetry *t)
+{
+    char buf[32];
+    int width = u8g2_GetDisplayWidth(u8g2);
+
+    u8g2_ClearBuffer(u8g2);
+
+    rt_snprintf(buf, sizeof(buf), "Current Height: %d", t->current_height);
+    u8g2_DrawStr(u8g2, 10, 18, buf);
+    rt_snprintf(buf, sizeof(buf), "Target Height: %d", (int)t->target_height);
+    u8g2_DrawStr(u8g2, 10, 36, buf);
+
+    int height = t->current_height;
+    if (height < 0) height = 0;
+    if (height > SCREEN_BAR_MAX_MM) height = SCREEN_BAR_MAX_MM;
+    int target = (int)t->ramped_height;
+    if (target < 0) target = 0;
+    if (target > SCREEN_BAR_MAX_MM) target = SCREEN_BAR_MAX_MM;
+
+    u8g2_DrawFrame(u8g2, 0, SCREEN_BAR_Y, width, SCREEN_BAR_H);
+    u8g2_DrawBox(u8g2, 0, SCREEN_BAR_Y, height * width / SCREEN_BAR_MAX_MM, SCREEN_BAR_H);
+    /* 目标刻度画在条的上下两侧, 不会被填充部分遮住 */
+    int marker = target * (width - 1) / SCREEN_BAR_MAX_MM;
+    u8g2_DrawVLine(u8g2, marker, SCREEN_BAR_Y - 3, 3);
+    u8g2_DrawVLine(u8g2, marker, SCREEN_BAR_Y + SCREEN_BAR_H, 3);
+}
+
 void screen_on()
 {
     u8g2_t u8g2;
-    char buf[32];
+    struct telemetry t;
 
     // Initialization
     u8g2_Setup_ssd1306_i2c_128x64_noname_f( &u8g2, U8G2_R0, u8x8_byte_rtthread_hw_i2c, u8x8_gpio_and_delay_rtthread);
     u8g2_InitDisplay(&u8g2);
     u8g2_SetPowerSave(&u8g2, 0);
-
-    /* full buffer example, setup procedure ends in _f */
-    u8g2_ClearBuffer(&u8g2);
     u8g2_SetFont(&u8g2, u8g2_font_ncenB08_tr);
+
+    /* 第一帧整屏发送, 之后只发送变化的图块 */
+    telemetry_read(&t);
+    screen_draw(&u8g2, &t);
+    u8g2_SendBuffer(&u8g2);
+    memcpy(shadow, u8g2_GetBufferPtr(&u8g2), sizeof(shadow));
+
     while (1)
     {
-        sprintf(buf, "Current Height: %d", current_height);
-        u8g2_DrawStr(&u8g2, 10, 18, buf);
-        sprintf(buf, "Target Height: %d", (int)target_height);
-        u8g2_DrawStr(&u8g2, 10, 36, buf);
-        u8g2_SendBuffer(&u8g2);
-        rt_thread_mdelay(500);
+        rt_thread_mdelay(SCREEN_REFRESH_MS);
+        telemetry_read(&t);
+        screen_draw(&u8g2, &t);
+        screen_flush_dirty(&u8g2);
     }
 }
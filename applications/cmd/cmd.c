@@ -0,0 +1,157 @@
+#include <rtthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmd.h"
+
+static struct cmd_table *cmd_tables = RT_NULL;
+
+void cmd_register(struct cmd_table *table)
+{
+    table->next = cmd_tables;
+    cmd_tables = table;
+}
+
+const struct cmd_def *cmd_find(const char *name)
+{
+    for (struct cmd_table *t = cmd_tables; t != RT_NULL; t = t->next) {
+        for (rt_size_t n = 0; n < t->count; n++) {
+            if (strcmp(t->defs[n].name, name) == 0) return &t->defs[n];
+        }
+    }
+    return RT_NULL;
+}
+
+void cmd_printf(struct cmd_reply *reply, const char *fmt, ...)
+{
+    va_list args;
+
+    if (reply->len + 1 >= reply->size) return;
+
+    va_start(args, fmt);
+    int n = rt_vsnprintf(reply->buf + reply->len, reply->size - reply->len, fmt, args);
+    va_end(args);
+
+    if (n > 0) {
+        reply->len += n;
+        if (reply->len >= reply->size) reply->len = reply->size - 1;
+    }
+}
+
+/* 按类型字符解析一个取值, 整个字符串都必须是合法数字 */
+static rt_bool_t cmd_parse_value(char type, const char *text, union cmd_value *value)
+{
+    char *end;
+
+    switch (type)
+    {
+    case 'i':
+        value->i = (rt_int32_t)strtol(text, &end, 0);
+        return end != text && *end == '\0';
+    case 'f':
+        value->f = strtof(text, &end);
+        return end != text && *end == '\0';
+    case 's':
+        value->s = text;
+        return RT_TRUE;
+    default:
+        return RT_FALSE;
+    }
+}
+
+static int cmd_find_option(const struct cmd_def *def, const char *name)
+{
+    if (def->options == RT_NULL) return -1;
+    for (int n = 0; n < CMD_MAX_OPTIONS && def->options[n].name != RT_NULL; n++) {
+        if (strcmp(def->options[n].name, name) == 0) return n;
+    }
+    return -1;
+}
+
+/**
+ * @brief 按命令声明把 argv 解析成类型化的取值
+ * @return RT_EOK 成功, -RT_EINVAL 参数错误 (错误原因已写入 reply)
+ */
+static rt_err_t cmd_parse(const struct cmd_def *def, int argc, char **argv,
+                          struct cmd_args *args, struct cmd_reply *reply)
+{
+    const char *positional = def->positional ? def->positional : "";
+
+    args->present = 0;
+    args->npos = 0;
+
+    for (int n = 1; n < argc; n++)
+    {
+        int option = cmd_find_option(def, argv[n]);
+        if (option >= 0)
+        {
+            const char *types = def->options[option].types;
+            int count = strlen(types);
+            if (n + count >= argc) {
+                cmd_printf(reply, "Error: Option %s expects %d value(s).\n", argv[n], count);
+                return -RT_EINVAL;
+            }
+            for (int v = 0; v < count; v++) {
+                if (!cmd_parse_value(types[v], argv[n + 1 + v], &args->opt[option][v])) {
+                    cmd_printf(reply, "Error: Invalid value '%s' for %s.\n", argv[n + 1 + v], argv[n]);
+                    return -RT_EINVAL;
+                }
+            }
+            args->present |= 1UL << option;
+            n += count;
+        }
+        else if (args->npos < strlen(positional))
+        {
+            if (!cmd_parse_value(positional[args->npos], argv[n], &args->pos[args->npos])) {
+                cmd_printf(reply, "Error: Invalid argument '%s'.\n", argv[n]);
+                return -RT_EINVAL;
+            }
+            args->npos++;
+        }
+        else
+        {
+            cmd_printf(reply, "Error: Unknown option %s\n", argv[n]);
+            return -RT_EINVAL;
+        }
+    }
+
+    if (args->npos < def->min_positional) {
+        cmd_printf(reply, "Usage: %s\n", def->usage);
+        return -RT_EINVAL;
+    }
+    return RT_EOK;
+}
+
+rt_err_t cmd_execute(int argc, char **argv, rt_bool_t remote, struct cmd_reply *reply)
+{
+    struct cmd_args args;
+
+    const struct cmd_def *def = cmd_find(argv[0]);
+    if (def == RT_NULL) {
+        cmd_printf(reply, "ERROR: Unknown command '%s'.\n", argv[0]);
+        return -RT_EEMPTY;
+    }
+    if (remote && (def->flags & CMD_FLAG_CONSOLE_ONLY)) {
+        cmd_printf(reply, "ERROR: '%s' is only available on the console.\n", argv[0]);
+        return -RT_EPERM;
+    }
+
+    rt_err_t ret = cmd_parse(def, argc, argv, &args, reply);
+    if (ret != RT_EOK) {
+        return ret;
+    }
+    return def->handler(&args, reply);
+}
+
+void cmd_console(int argc, char **argv)
+{
+    /* FinSH 只有一个线程执行命令, 缓冲区可以是静态的 */
+    static char buf[CMD_CONSOLE_BUFSZ];
+    struct cmd_reply reply = { buf, sizeof(buf), 0, 0 };
+
+    buf[0] = '\0';
+    cmd_execute(argc, argv, RT_FALSE, &reply);
+    if (reply.len > 0) {
+        rt_kputs(buf);
+    }
+}
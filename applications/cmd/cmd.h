@@ -0,0 +1,108 @@
+#ifndef __CMD_H__
+#define __CMD_H__
+
+#include <rtthread.h>
+
+/*
+ * 命令注册表, 由 FinSH 和远程TCP服务器共用
+ *  - 参数按命令声明的类型一次性解析成整数/浮点/字符串, 处理函数不再自己解析字符串
+ *  - 处理函数把结果写入调用方提供的回复缓冲区, 不直接打印
+ *    控制台调用时由 cmd_console() 打印回复, 远程调用时回复只发给客户端
+ *  - 命令表和解析结果都是静态/栈上的, 不分配内存
+ */
+
+#define CMD_MAX_OPTIONS         8       // 每个命令最多的选项数
+#define CMD_MAX_VALUES          3       // 每个选项/位置参数最多的取值个数
+#define CMD_CONSOLE_BUFSZ       1024    // 控制台调用时的回复缓冲区大小
+
+union cmd_value
+{
+    rt_int32_t i;
+    float f;
+    const char *s;
+};
+
+/* 选项声明, types 中每个字符对应一个取值: 'i' 整数, 'f' 浮点, 's' 字符串, "" 表示开关 */
+struct cmd_option
+{
+    const char *name;
+    const char *types;
+};
+
+/* 解析结果, 选项按其在声明数组中的下标访问 */
+struct cmd_args
+{
+    rt_uint32_t present;                                    // 第 n 位: 第 n 个选项出现过
+    union cmd_value opt[CMD_MAX_OPTIONS][CMD_MAX_VALUES];
+    union cmd_value pos[CMD_MAX_VALUES];                    // 位置参数
+    rt_uint8_t npos;
+};
+
+#define CMD_REPLY_JSON          0x01    // 调用方希望得到JSON格式 (远程客户端)
+
+struct cmd_reply
+{
+    char *buf;
+    rt_size_t size;
+    rt_size_t len;
+    rt_uint8_t flags;
+};
+
+/* 处理函数: 成功返回 RT_EOK, 参数错误等返回负值, 回复内容都写入 reply */
+typedef rt_err_t (*cmd_handler_t)(const struct cmd_args *args, struct cmd_reply *reply);
+
+#define CMD_FLAG_CONSOLE_ONLY   0x01    // 会长时间阻塞, 不允许远程调用
+
+struct cmd_def
+{
+    const char *name;
+    const char *usage;
+    const struct cmd_option *options;   // 以 name 为 RT_NULL 的项结尾, 可为 RT_NULL
+    const char *positional;             // 位置参数类型, 同 cmd_option.types
+    rt_uint8_t min_positional;          // 必须给出的位置参数个数
+    rt_uint8_t flags;
+    cmd_handler_t handler;
+};
+
+/* 命令表, 由注册方静态定义后挂到注册表上 */
+struct cmd_table
+{
+    const struct cmd_def *defs;
+    rt_size_t count;
+    struct cmd_table *next;
+};
+
+void cmd_register(struct cmd_table *table);
+const struct cmd_def *cmd_find(const char *name);
+
+/**
+ * @brief 解析参数并执行命令
+ * @param argc   参数个数, argv[0] 为命令名
+ * @param argv   参数
+ * @param remote 是否来自远程客户端
+ * @param reply  回复缓冲区
+ * @return RT_EOK 成功; -RT_EEMPTY 没有该命令; 其他为参数错误或处理函数的返回值
+ */
+rt_err_t cmd_execute(int argc, char **argv, rt_bool_t remote, struct cmd_reply *reply);
+
+/* 在控制台 (FinSH) 执行命令并打印回复 */
+void cmd_console(int argc, char **argv);
+
+/* 向回复缓冲区追加格式化文本, 超出缓冲区时截断 */
+void cmd_printf(struct cmd_reply *reply, const char *fmt, ...);
+
+rt_inline rt_bool_t cmd_has(const struct cmd_args *args, int option)
+{
+    return (args->present & (1UL << option)) != 0;
+}
+
+/* 把命令导出为同名 FinSH 命令, 控制台执行时打印回复 */
+#define CMD_MSH_EXPORT(name, desc)                                  \
+    static int name##_msh(int argc, char **argv)                    \
+    {                                                               \
+        cmd_console(argc, argv);                                    \
+        return 0;                                                   \
+    }                                                               \
+    MSH_CMD_EXPORT_ALIAS(name##_msh, name, desc)
+
+#endif /* __CMD_H__ */
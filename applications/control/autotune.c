@@ -0,0 +1,126 @@
+#include <math.h>
+#include "autotune.h"
+
+#define AUTOTUNE_PI         3.14159265f
+#define AUTOTUNE_BIAS_GAIN  0.5f        // 每个周期按半周期不对称程度修正 bias 的比例
+
+static float clampf(float x, float lo, float hi)
+{
+    if (x < lo) return lo;
+    if (x > hi) return hi;
+    return x;
+}
+
+void autotune_start(autotune_t *at, const autotune_config_t *cfg, float setpoint)
+{
+    at->cfg = *cfg;
+    if (at->cfg.cycles == 0) at->cfg.cycles = 1;
+    at->setpoint = setpoint;
+    at->bias = clampf(cfg->bias, cfg->out_min + cfg->amplitude, cfg->out_max - cfg->amplitude);
+    at->t = 0.0f;
+    at->t_rise = 0.0f;
+    at->t_fall = 0.0f;
+    at->meas_max = setpoint;
+    at->meas_min = setpoint;
+    at->period_sum = 0.0f;
+    at->amp_sum = 0.0f;
+    at->relay = 1;
+    at->rises = 0;
+    at->measured = 0;
+    at->state = AUTOTUNE_RUNNING;
+    at->ku = 0.0f;
+    at->tu = 0.0f;
+    at->amp = 0.0f;
+}
+
+/* 上升沿时结束一个完整周期 [t_rise, t]: 修正 bias, 过渡期后计入平均 */
+static void autotune_cycle_done(autotune_t *at)
+{
+    const autotune_config_t *cfg = &at->cfg;
+    float period = at->t - at->t_rise;
+    float high = at->t_fall - at->t_rise;
+    float low = at->t - at->t_fall;
+
+    /* 高输出持续得比低输出久, 说明 bias 偏低 */
+    at->bias += AUTOTUNE_BIAS_GAIN * cfg->amplitude * (high - low) / period;
+    at->bias = clampf(at->bias, cfg->out_min + cfg->amplitude, cfg->out_max - cfg->amplitude);
+
+    /* rises - 1 为已完成的周期数 */
+    if (at->rises - 1 <= cfg->skip_cycles) return;
+
+    at->period_sum += period;
+    at->amp_sum += 0.5f * (at->meas_max - at->meas_min);
+    if (++at->measured < cfg->cycles) return;
+
+    at->tu = at->period_sum / at->measured;
+    at->amp = at->amp_sum / at->measured;
+    if (at->amp <= cfg->hysteresis) {
+        at->state = AUTOTUNE_FAILED;
+        return;
+    }
+    at->ku = 4.0f * cfg->amplitude /
+             (AUTOTUNE_PI * sqrtf(at->amp * at->amp - cfg->hysteresis * cfg->hysteresis));
+    at->state = AUTOTUNE_DONE;
+}
+
+autotune_state_t autotune_update(autotune_t *at, float measurement, float dt, float *out)
+{
+    const autotune_config_t *cfg = &at->cfg;
+
+    if (at->state != AUTOTUNE_RUNNING) {
+        *out = at->bias;
+        return at->state;
+    }
+
+    at->t += dt;
+    if (measurement > at->meas_max) at->meas_max = measurement;
+    if (measurement < at->meas_min) at->meas_min = measurement;
+
+    float error = at->setpoint - measurement;
+    if (at->relay > 0 && error < -cfg->hysteresis) {
+        at->relay = -1;
+        at->t_fall = at->t;
+    } else if (at->relay < 0 && error > cfg->hysteresis) {
+        /* 第一个上升沿之前的时间不是完整周期 */
+        if (++at->rises > 1) autotune_cycle_done(at);
+        at->relay = 1;
+        at->t_rise = at->t;
+        at->meas_max = measurement;
+        at->meas_min = measurement;
+    }
+
+    if (at->state == AUTOTUNE_RUNNING && at->t > cfg->timeout) {
+        at->state = AUTOTUNE_FAILED;
+    }
+    if (at->state != AUTOTUNE_RUNNING) {
+        *out = at->bias;
+        return at->state;
+    }
+
+    *out = at->bias + at->relay * cfg->amplitude;
+    return AUTOTUNE_RUNNING;
+}
+
+void autotune_gains(const autotune_t *at, autotune_rule_t rule, float ts, float *kp, float *ki, float *kd)
+{
+    float k, ti, td;
+
+    switch (rule)
+    {
+    case AUTOTUNE_RULE_ZN:
+        k = 0.6f;  ti = 0.5f * at->tu; td = 0.125f * at->tu;
+        break;
+    case AUTOTUNE_RULE_NO_OVERSHOOT:
+        k = 0.2f;  ti = 0.5f * at->tu; td = at->tu / 3.0f;
+        break;
+    case AUTOTUNE_RULE_SOME_OVERSHOOT:
+    default:
+        k = 0.33f; ti = 0.5f * at->tu; td = at->tu / 3.0f;
+        break;
+    }
+
+    /* pid.h 的积分按 "误差 * 整定周期数" 累加, 微分按 "mm / 整定周期" 计算 */
+    *kp = k * at->ku;
+    *ki = *kp * ts / ti;
+    *kd = *kp * td / ts;
+}
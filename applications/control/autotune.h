@@ -0,0 +1,84 @@
+#ifndef __AUTOTUNE_H__
+#define __AUTOTUNE_H__
+
+#include <stdint.h>
+
+/*
+ * 继电反馈 (Åström–Hägglund) PID自整定
+ *  - 输出在 bias ± amplitude 之间切换, 误差越过滞环 ±hysteresis 时翻转, 使被控量进入极限环振荡
+ *  - 每个完整振荡周期测一次周期 Tu 和振幅 a, 丢弃开头的过渡周期后取平均
+ *    临界增益 Ku = 4d / (pi * sqrt(a^2 - eps^2)) (带滞环的描述函数)
+ *  - 上升/下降半周期不对称说明 bias 偏离平衡点, 每个周期按不对称程度修正 bias
+ *    结束时的 bias 即为该设定值下的平衡输出, 可直接作为前馈
+ *  - 由 Ku / Tu 按整定规则算出增益, 换算成 pid.h 中"每个整定周期"的单位
+ * 每个控制周期调用一次 autotune_update(), 常数时间, 不分配内存
+ * 本文件不依赖RT-Thread, 可以直接在主机上编译
+ */
+
+typedef enum
+{
+    AUTOTUNE_RULE_ZN = 0,           // Ziegler–Nichols 经典: Kp=0.6Ku, Ti=Tu/2, Td=Tu/8
+    AUTOTUNE_RULE_SOME_OVERSHOOT,   // 少量超调: Kp=0.33Ku, Ti=Tu/2, Td=Tu/3
+    AUTOTUNE_RULE_NO_OVERSHOOT,     // 无超调: Kp=0.2Ku, Ti=Tu/2, Td=Tu/3
+} autotune_rule_t;
+
+typedef enum
+{
+    AUTOTUNE_RUNNING = 0,
+    AUTOTUNE_DONE,
+    AUTOTUNE_FAILED,                // 超时或没有形成振荡
+} autotune_state_t;
+
+typedef struct
+{
+    float amplitude;                // 继电幅值 d (占空比)
+    float hysteresis;               // 滞环 eps (mm), 应大于测量噪声
+    float bias;                     // 初始偏置 (占空比), 一般取前馈表的值
+    float out_min;                  // 输出限幅, bias 修正后 bias ± d 保持在范围内
+    float out_max;
+    uint8_t skip_cycles;            // 丢弃的开头过渡周期数
+    uint8_t cycles;                 // 参与平均的周期数
+    float timeout;                  // 超时 (s)
+} autotune_config_t;
+
+typedef struct
+{
+    autotune_config_t cfg;
+    float setpoint;
+    float bias;                     // 当前偏置, 每个周期修正
+    float t;                        // 已运行时间 (s)
+    float t_rise;                   // 最近一次切换到高输出的时刻
+    float t_fall;                   // 最近一次切换到低输出的时刻
+    float meas_max;                 // 当前周期内的测量值极值
+    float meas_min;
+    float period_sum;
+    float amp_sum;
+    int8_t relay;                   // +1 高输出, -1 低输出
+    uint8_t rises;                  // 已出现的上升沿次数
+    uint8_t measured;               // 已计入平均的周期数
+    autotune_state_t state;
+
+    /* 结果, state 为 AUTOTUNE_DONE 时有效 */
+    float ku;                       // 临界增益 (占空比 / mm)
+    float tu;                       // 临界周期 (s)
+    float amp;                      // 平均振幅 (mm)
+} autotune_t;
+
+void autotune_start(autotune_t *at, const autotune_config_t *cfg, float setpoint);
+
+/**
+ * @brief 执行一步继电控制
+ * @param measurement 测量值 (mm)
+ * @param dt          距上一次调用的时间 (s)
+ * @param out         输出占空比
+ * @return 当前状态, 不再是 AUTOTUNE_RUNNING 时 out 为结束时的 bias
+ */
+autotune_state_t autotune_update(autotune_t *at, float measurement, float dt, float *out);
+
+/**
+ * @brief 由辨识结果按整定规则计算增益
+ * @param ts 增益的整定周期 (s), 与 pid_config_t.ts 相同
+ */
+void autotune_gains(const autotune_t *at, autotune_rule_t rule, float ts, float *kp, float *ki, float *kd);
+
+#endif /* __AUTOTUNE_H__ */
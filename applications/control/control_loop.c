@@ -0,0 +1,321 @@
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "control_loop.h"
+#include "ctrl_queue.h"
+#include "cmd.h"
+#if defined(APP_CONTROL_TIMER_KTIME) || defined(BSP_USING_TICKLESS)
+#include "ktime.h"
+#endif
+
+#define CONTROL_THREAD_STACK_SIZE   2048
+#define CONTROL_DT_MAX_PERIODS      4       // 实测dt超过该周期数时视为异常, 改用标称周期
+
+/* 控制线程必须高于网络协议栈和软件定时器线程, 网络负载不能抢占控制周期 */
+#if defined(RT_LWIP_TCPTHREAD_PRIORITY) && APP_CONTROL_THREAD_PRIORITY >= RT_LWIP_TCPTHREAD_PRIORITY
+#error "APP_CONTROL_THREAD_PRIORITY must be higher (numerically lower) than RT_LWIP_TCPTHREAD_PRIORITY"
+#endif
+#if defined(RT_USING_TIMER_SOFT) && APP_CONTROL_THREAD_PRIORITY >= RT_TIMER_THREAD_PRIO
+#warning "Soft timer callbacks can delay the control thread (APP_CONTROL_THREAD_PRIORITY >= RT_TIMER_THREAD_PRIO)"
+#endif
+
+#ifdef APP_CONTROL_TIMER_KTIME
+static struct rt_ktime_hrtimer period_timer;
+static unsigned long period_cnt;                // 控制周期 (cputimer 计数)
+static unsigned long next_deadline;             // 下一次唤醒的 cputimer 计数
+#else
+static rt_device_t timer_dev = RT_NULL;
+#endif
+static struct rt_semaphore tick_sem;
+static volatile rt_uint32_t tick_count = 0;     // 定时器中断累计的节拍数
+static volatile rt_uint32_t release_stamp;      // 最近一个节拍的到达时刻 (loop_stamp), 即本周期的起点
+
+/* 控制线程静态分配, 不依赖堆, 启动后不会因内存碎片创建失败 */
+static struct rt_thread control_thread;
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t control_thread_stack[CONTROL_THREAD_STACK_SIZE];
+static rt_bool_t control_started = RT_FALSE;
+static control_loop_step_t control_step = RT_NULL;
+static struct control_loop_stats loop_stats;
+
+/*
+ * 周期和响应时间的时间戳, 32位计数, 时间差用无符号减法处理回绕.
+ * 空闲线程休眠 (WFI) 时内核时钟停止, DWT周期计数器随之停住, 打开 tickless 时
+ * 改用不停的 ktime cputimer 计数, 否则休眠的时间不计入实测 dt
+ */
+#ifdef BSP_USING_TICKLESS
+rt_inline rt_uint32_t loop_stamp(void)
+{
+    return (rt_uint32_t)rt_ktime_cputimer_getcnt();
+}
+
+static rt_uint32_t stamp_to_us(rt_uint32_t stamps)
+{
+    return (rt_uint32_t)((rt_uint64_t)stamps * 1000000 / rt_ktime_cputimer_getfrq());
+}
+#else
+rt_inline rt_uint32_t loop_stamp(void)
+{
+    return (rt_uint32_t)clock_cpu_gettime();
+}
+
+static rt_uint32_t stamp_to_us(rt_uint32_t stamps)
+{
+    return (rt_uint32_t)clock_cpu_microsecond(stamps);
+}
+#endif
+
+#ifdef APP_CONTROL_TIMER_KTIME
+/**
+ * @brief hrtimer 超时回调 (中断上下文), 按绝对时刻装载下一次唤醒, 中断延迟不会累积成周期漂移
+ */
+static void control_tick_isr(void *parameter)
+{
+    unsigned long now = rt_ktime_cputimer_getcnt();
+
+    next_deadline += period_cnt;
+    unsigned long delay = next_deadline - now;
+    /* 错过了整个周期 (如调试器暂停) 时从当前时刻重新对齐 */
+    if (delay == 0 || delay > period_cnt) {
+        next_deadline = now + period_cnt;
+        delay = period_cnt;
+    }
+    rt_ktime_hrtimer_start(&period_timer, delay);
+
+    release_stamp = loop_stamp();
+    tick_count++;
+    rt_sem_release(&tick_sem);
+}
+
+static rt_err_t control_timer_open(void)
+{
+    rt_ktime_hrtimer_init(&period_timer, "ctrl", RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER,
+                          control_tick_isr, RT_NULL);
+    period_cnt = (unsigned long)((rt_uint64_t)CONTROL_LOOP_PERIOD_US * 1000 * RT_KTIME_RESMUL /
+                                 rt_ktime_cputimer_getres());
+    return period_cnt > 0 ? RT_EOK : -RT_ERROR;
+}
+
+static void control_timer_close(void)
+{
+}
+
+static rt_err_t control_timer_start(void)
+{
+    next_deadline = rt_ktime_cputimer_getcnt() + period_cnt;
+    return rt_ktime_hrtimer_start(&period_timer, period_cnt);
+}
+#else
+/**
+ * @brief 定时器超时回调 (中断上下文), 只负责计数并唤醒控制线程
+ */
+static rt_err_t control_tick_isr(rt_device_t dev, rt_size_t size)
+{
+    release_stamp = loop_stamp();
+    tick_count++;
+    rt_sem_release(&tick_sem);
+    return RT_EOK;
+}
+
+static rt_err_t control_timer_open(void)
+{
+    timer_dev = rt_device_find(APP_CONTROL_TIMER_DEV_NAME);
+    if (timer_dev == RT_NULL) {
+        rt_kprintf("[Control] Timer %s not found!\n", APP_CONTROL_TIMER_DEV_NAME);
+        return -RT_ERROR;
+    }
+    if (rt_device_open(timer_dev, RT_DEVICE_OFLAG_RDWR) != RT_EOK) {
+        rt_kprintf("[Control] Failed to open timer %s!\n", APP_CONTROL_TIMER_DEV_NAME);
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
+
+static void control_timer_close(void)
+{
+    rt_device_close(timer_dev);
+}
+
+static rt_err_t control_timer_start(void)
+{
+    rt_hwtimerval_t timeout;
+    rt_hwtimer_mode_t mode = HWTIMER_MODE_PERIOD;
+
+    rt_device_set_rx_indicate(timer_dev, control_tick_isr);
+    rt_device_control(timer_dev, HWTIMER_CTRL_MODE_SET, &mode);
+    timeout.sec = 0;
+    timeout.usec = CONTROL_LOOP_PERIOD_US;
+    if (rt_device_write(timer_dev, 0, &timeout, sizeof(timeout)) != sizeof(timeout)) {
+        rt_kprintf("[Control] Failed to start timer %s!\n", APP_CONTROL_TIMER_DEV_NAME);
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
+#endif /* APP_CONTROL_TIMER_KTIME */
+
+/**
+ * @brief 控制线程入口, 每个定时器节拍执行一次控制计算
+ * 截止时刻为节拍到达后一个周期: 从节拍到达到本周期计算完成超过一个周期,
+ * 或因上一周期未完成而丢掉节拍, 都计为错过截止时刻
+ * @param parameter 线程参数 (未使用)
+ */
+static void control_thread_entry(void *parameter)
+{
+    const float nominal_dt = CONTROL_LOOP_PERIOD_US / 1000000.0f;
+    rt_uint32_t handled = tick_count;
+    rt_uint32_t last_stamp = loop_stamp();
+
+    while (1)
+    {
+        rt_sem_take(&tick_sem, RT_WAITING_FOREVER);
+        rt_uint32_t stamp = loop_stamp();
+        rt_uint32_t release = release_stamp;
+
+        /*
+         * 上一周期执行过长时, 信号量中会积压节拍, 全部丢弃只处理最新的一个;
+         * 读计数和清信号量在关中断下完成, 两者之间到达的节拍不会被清掉又记为丢失
+         */
+        rt_base_t tick_level = rt_hw_interrupt_disable();
+        rt_uint32_t ticks = tick_count;
+        rt_uint32_t missed = ticks - handled - 1;
+        if (missed != 0) {
+            rt_sem_control(&tick_sem, RT_IPC_CMD_RESET, (void *)0);
+        }
+        rt_hw_interrupt_enable(tick_level);
+        handled = ticks;
+
+        rt_uint32_t period_us = stamp_to_us(stamp - last_stamp);
+        last_stamp = stamp;
+        float dt = period_us / 1000000.0f;
+        if (dt <= 0.0f || dt > nominal_dt * CONTROL_DT_MAX_PERIODS) {
+            dt = nominal_dt;
+        }
+
+        control_step(dt);
+
+        rt_uint32_t done = loop_stamp();
+        rt_uint32_t exec_us = stamp_to_us(done - stamp);
+        rt_uint32_t wake_us = stamp_to_us(stamp - release);
+        rt_uint32_t response_us = stamp_to_us(done - release);
+
+        rt_base_t level = rt_hw_interrupt_disable();
+        loop_stats.cycles++;
+        loop_stats.missed_ticks += missed;
+        loop_stats.period_us = period_us;
+        loop_stats.exec_us = exec_us;
+        if (exec_us > loop_stats.exec_max_us) loop_stats.exec_max_us = exec_us;
+        if (exec_us > CONTROL_LOOP_PERIOD_US) loop_stats.overruns++;
+        loop_stats.wake_us = wake_us;
+        if (wake_us > loop_stats.wake_max_us) loop_stats.wake_max_us = wake_us;
+        if (response_us > loop_stats.response_max_us) loop_stats.response_max_us = response_us;
+        loop_stats.deadline_misses += missed + (response_us > CONTROL_LOOP_PERIOD_US ? 1 : 0);
+        rt_hw_interrupt_enable(level);
+    }
+}
+
+/**
+ * @brief 启动由硬件定时器驱动的控制线程
+ * @param step 每个控制周期调用的控制函数
+ * @return RT_EOK 成功, 其他值失败
+ */
+rt_err_t control_loop_start(control_loop_step_t step)
+{
+    if (control_started || step == RT_NULL) {
+        return -RT_ERROR;
+    }
+    control_step = step;
+
+    if (control_timer_open() != RT_EOK) {
+        return -RT_ERROR;
+    }
+
+    rt_sem_init(&tick_sem, "ctrl_tick", 0, RT_IPC_FLAG_PRIO);
+    if (rt_thread_init(&control_thread, "Control", control_thread_entry, RT_NULL,
+                       control_thread_stack, sizeof(control_thread_stack),
+                       APP_CONTROL_THREAD_PRIORITY, 10) != RT_EOK) {
+        rt_kprintf("[Control] Failed to init control thread.\n");
+        rt_sem_detach(&tick_sem);
+        control_timer_close();
+        return -RT_ERROR;
+    }
+    control_started = RT_TRUE;
+    rt_thread_startup(&control_thread);
+
+    /* 控制线程就绪后再启动周期定时器 */
+    if (control_timer_start() != RT_EOK) {
+        return -RT_ERROR;
+    }
+
+    rt_kprintf("[Control] Control loop running at %d Hz.\n", CONTROL_LOOP_RATE_HZ);
+    return RT_EOK;
+}
+
+void control_loop_get_stats(struct control_loop_stats *stats)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    *stats = loop_stats;
+    rt_hw_interrupt_enable(level);
+}
+
+void control_loop_reset_stats(void)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    rt_uint32_t cycles = loop_stats.cycles;
+    rt_memset(&loop_stats, 0, sizeof(loop_stats));
+    loop_stats.cycles = cycles;
+    rt_hw_interrupt_enable(level);
+}
+
+enum
+{
+    CTRL_STATS_RESET,
+};
+
+static const struct cmd_option ctrl_stats_options[] =
+{
+    [CTRL_STATS_RESET] = { "-reset", "" },
+    { RT_NULL, RT_NULL },
+};
+
+/* ctrl_stats [-reset]  控制周期的截止时刻统计, -reset 在输出后清零 (周期计数保留) */
+static rt_err_t ctrl_stats_cmd(const struct cmd_args *args, struct cmd_reply *reply)
+{
+    struct control_loop_stats s;
+
+    control_loop_get_stats(&s);
+    if (reply->flags & CMD_REPLY_JSON) {
+        cmd_printf(reply, "{\"rate_hz\":%d,\"cycles\":%u,\"deadline_misses\":%u,\"missed_ticks\":%u,"
+                   "\"overruns\":%u,\"wake_us\":%u,\"wake_max_us\":%u,\"exec_max_us\":%u,"
+                   "\"response_max_us\":%u,\"requests_rejected\":%u}",
+                   CONTROL_LOOP_RATE_HZ, s.cycles, s.deadline_misses, s.missed_ticks, s.overruns,
+                   s.wake_us, s.wake_max_us, s.exec_max_us, s.response_max_us, ctrl_queue_rejected());
+    } else {
+        cmd_printf(reply, "Control loop: %d Hz, priority %d, %u cycles\n",
+                   CONTROL_LOOP_RATE_HZ, APP_CONTROL_THREAD_PRIORITY, s.cycles);
+        cmd_printf(reply, "Deadline misses: %u (missed ticks %u, overruns %u)\n",
+                   s.deadline_misses, s.missed_ticks, s.overruns);
+        cmd_printf(reply, "Wake latency: %u us (max %u us)\n", s.wake_us, s.wake_max_us);
+        cmd_printf(reply, "Exec max: %u us, response max: %u us of %u us\n",
+                   s.exec_max_us, s.response_max_us, (rt_uint32_t)CONTROL_LOOP_PERIOD_US);
+        cmd_printf(reply, "Requests rejected (queue full): %u\n", ctrl_queue_rejected());
+    }
+    if (cmd_has(args, CTRL_STATS_RESET)) {
+        control_loop_reset_stats();
+    }
+    return RT_EOK;
+}
+
+static const struct cmd_def control_cmd_defs[] =
+{
+    { "ctrl_stats", "ctrl_stats [-reset]", ctrl_stats_options, RT_NULL, 0, 0, ctrl_stats_cmd },
+};
+
+static struct cmd_table control_cmds = { control_cmd_defs, sizeof(control_cmd_defs) / sizeof(control_cmd_defs[0]), RT_NULL };
+
+static int control_cmds_init(void)
+{
+    cmd_register(&control_cmds);
+    return 0;
+}
+INIT_APP_EXPORT(control_cmds_init);
+
+CMD_MSH_EXPORT(ctrl_stats, Control loop deadline misses and latency);
@@ -0,0 +1,32 @@
+#ifndef __CONTROL_LOOP_H__
+#define __CONTROL_LOOP_H__
+
+#include <rtthread.h>
+
+#define CONTROL_LOOP_RATE_HZ    APP_CONTROL_LOOP_RATE_HZ                 // 控制频率 (Hz)
+#define CONTROL_LOOP_PERIOD_US  (1000000UL / CONTROL_LOOP_RATE_HZ)       // 控制周期 (us)
+
+/* 每个控制周期调用一次, dt 为两次唤醒之间实测的时间间隔 (s) */
+typedef void (*control_loop_step_t)(float dt);
+
+struct control_loop_stats
+{
+    rt_uint32_t cycles;         // 已执行的控制周期数
+    rt_uint32_t missed_ticks;   // 因上一周期未完成而丢失的定时器节拍
+    rt_uint32_t overruns;       // 单周期执行时间超过控制周期的次数
+    rt_uint32_t period_us;      // 最近一次实测周期 (us)
+    rt_uint32_t exec_us;        // 最近一次单周期执行时间 (us)
+    rt_uint32_t exec_max_us;    // 单周期执行时间最大值 (us)
+    rt_uint32_t deadline_misses;// 节拍到达后一个周期内没有完成计算的次数 (含丢失的节拍)
+    rt_uint32_t wake_us;        // 最近一次从节拍到达到控制线程开始运行的时间 (us)
+    rt_uint32_t wake_max_us;
+    rt_uint32_t response_max_us;// 从节拍到达到计算完成的最大时间 (us)
+};
+
+rt_err_t control_loop_start(control_loop_step_t step);
+void control_loop_get_stats(struct control_loop_stats *stats);
+
+/* 清零统计 (周期计数保留) */
+void control_loop_reset_stats(void);
+
+#endif /* __CONTROL_LOOP_H__ */
@@ -0,0 +1,73 @@
+#include <rtthread.h>
+#include <rtatomic.h>
+#include "ctrl_queue.h"
+
+#define CTRL_QUEUE_MASK     (CTRL_QUEUE_SIZE - 1)
+
+struct ctrl_slot
+{
+    volatile rt_atomic_t seq;
+    struct ctrl_msg msg;
+};
+
+static struct ctrl_slot slots[CTRL_QUEUE_SIZE];
+static volatile rt_atomic_t queue_tail = 0;         // 下一个要抢占的位置, 生产者CAS
+static rt_ubase_t queue_head = 0;                   // 下一个要读取的位置, 只由控制线程读写
+static volatile rt_atomic_t queue_rejected = 0;
+
+/*
+ * 槽位序号减去槽位下标后保存, 全零的初始状态即为 "第 i 个槽位序号为 i (可写)",
+ * 静态数组不需要初始化函数
+ */
+rt_inline rt_atomic_t slot_seq(rt_ubase_t index)
+{
+    return rt_atomic_load(&slots[index].seq) + (rt_atomic_t)index;
+}
+
+rt_inline void slot_set_seq(rt_ubase_t index, rt_atomic_t seq)
+{
+    rt_atomic_store(&slots[index].seq, seq - (rt_atomic_t)index);
+}
+
+rt_err_t ctrl_queue_post(const struct ctrl_msg *msg)
+{
+    rt_atomic_t pos = rt_atomic_load(&queue_tail);
+    while (1)
+    {
+        rt_ubase_t index = (rt_ubase_t)pos & CTRL_QUEUE_MASK;
+        rt_atomic_t diff = slot_seq(index) - pos;
+
+        if (diff == 0) {
+            /* 槽位空闲, 抢占成功后独占写入; 失败时 pos 已被更新为最新值 */
+            if (rt_atomic_compare_exchange_strong(&queue_tail, &pos, pos + 1)) {
+                slots[index].msg = *msg;
+                slot_set_seq(index, pos + 1);
+                return RT_EOK;
+            }
+        } else if (diff < 0) {
+            /* 控制线程还没取走上一轮的请求 */
+            rt_atomic_add(&queue_rejected, 1);
+            return -RT_EFULL;
+        } else {
+            pos = rt_atomic_load(&queue_tail);
+        }
+    }
+}
+
+rt_bool_t ctrl_queue_fetch(struct ctrl_msg *msg)
+{
+    rt_ubase_t index = queue_head & CTRL_QUEUE_MASK;
+
+    if (slot_seq(index) != (rt_atomic_t)(queue_head + 1)) {
+        return RT_FALSE;
+    }
+    *msg = slots[index].msg;
+    slot_set_seq(index, (rt_atomic_t)(queue_head + CTRL_QUEUE_SIZE));
+    queue_head++;
+    return RT_TRUE;
+}
+
+rt_uint32_t ctrl_queue_rejected(void)
+{
+    return (rt_uint32_t)rt_atomic_load(&queue_rejected);
+}
@@ -0,0 +1,40 @@
+#ifndef __CTRL_QUEUE_H__
+#define __CTRL_QUEUE_H__
+
+#include <rtthread.h>
+
+/*
+ * 命令线程 -> 控制线程的有界无锁请求队列
+ *  - 多个生产者 (FinSH/远程服务器/自整定线程) 用CAS抢占槽位, 互不加锁, 也不锁调度器
+ *  - 唯一的消费者是控制线程, 每个周期开始时取完所有已写好的请求, 从不等待
+ *    生产者抢到槽位后被抢占、还没写完时, 控制线程在该槽位停下, 下个周期再取
+ *  - 队列满时投递立即失败, 不阻塞生产者
+ * 每个槽位带序号 (Vyukov 有界队列), 序号等于下标+1 表示可读, 等于下标+长度表示可写
+ */
+
+#define CTRL_QUEUE_SIZE     16      // 必须为2的幂
+
+/* 请求内容由使用方定义, type 区分请求种类 */
+struct ctrl_msg
+{
+    rt_uint16_t type;
+    rt_int16_t index;
+    float value[3];
+};
+
+/**
+ * @brief 投递一个请求, 可在任意线程调用, 不阻塞
+ * @return RT_EOK 成功; -RT_EFULL 队列已满
+ */
+rt_err_t ctrl_queue_post(const struct ctrl_msg *msg);
+
+/**
+ * @brief 取出一个请求, 只允许控制线程调用
+ * @return RT_TRUE 取到; RT_FALSE 队列为空或队首请求还没写完
+ */
+rt_bool_t ctrl_queue_fetch(struct ctrl_msg *msg);
+
+/* 因队列满被拒绝的请求数 */
+rt_uint32_t ctrl_queue_rejected(void);
+
+#endif /* __CTRL_QUEUE_H__ */
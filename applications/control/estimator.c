@@ -0,0 +1,123 @@
+#include <string.h>
+#include "estimator.h"
+
+void estimator_init(estimator_t *e, const estimator_config_t *cfg)
+{
+    memset(e, 0, sizeof(*e));
+    e->cfg = *cfg;
+}
+
+void estimator_reset(estimator_t *e)
+{
+    e->initialized = 0;
+    e->rejects = 0;
+    e->x = 0.0f;
+    e->v = 0.0f;
+}
+
+/* 用测量作为初值: 位置方差取测量方差, 速度未知取一个大的方差 */
+static void estimator_start(estimator_t *e, float z)
+{
+    float r = e->cfg.meas_noise * e->cfg.meas_noise;
+
+    e->x = z;
+    e->v = 0.0f;
+    e->p00 = r;
+    e->p01 = 0.0f;
+    e->p11 = 1.0e6f;
+    e->since_update = 0.0f;
+    e->rejects = 0;
+    e->innovation = 0.0f;
+    e->initialized = 1;
+}
+
+void estimator_predict(estimator_t *e, float dt)
+{
+    if (!e->initialized || dt <= 0.0f) return;
+
+    /* 外推太久的速度不可信, 只保持位置 */
+    float coast = e->cfg.max_coast - e->since_update;
+    float move_dt = dt < coast ? dt : (coast > 0.0f ? coast : 0.0f);
+    e->x += e->v * move_dt;
+    e->since_update += dt;
+
+    if (e->cfg.type == ESTIMATOR_KALMAN) {
+        /* P = F P F' + Q, F = [1 dt; 0 1], Q 为离散白噪声加速度模型 */
+        float q = e->cfg.accel_noise * e->cfg.accel_noise;
+        float dt2 = dt * dt;
+        e->p00 += dt * (2.0f * e->p01 + dt * e->p11) + q * dt2 * dt2 * 0.25f;
+        e->p01 += dt * e->p11 + q * dt2 * dt * 0.5f;
+        e->p11 += q * dt2;
+    }
+}
+
+static void estimator_miss(estimator_t *e, float z)
+{
+    e->rejected++;
+    if (++e->rejects >= e->cfg.max_rejects && e->cfg.max_rejects > 0) {
+        estimator_start(e, z);
+    }
+}
+
+int estimator_update(estimator_t *e, float z)
+{
+    if (!e->initialized) {
+        estimator_start(e, z);
+        return 1;
+    }
+
+    float r = z - e->x;
+    e->innovation = r;
+
+    if (e->cfg.type == ESTIMATOR_KALMAN) {
+        float s = e->p00 + e->cfg.meas_noise * e->cfg.meas_noise;
+        if (r * r > e->cfg.gate * e->cfg.gate * s) {
+            estimator_miss(e, z);
+            return 0;
+        }
+        float k0 = e->p00 / s;
+        float k1 = e->p01 / s;
+        e->x += k0 * r;
+        e->v += k1 * r;
+        e->p11 -= k1 * e->p01;
+        e->p01 -= k0 * e->p01;
+        e->p00 -= k0 * e->p00;
+    } else {
+        if (r > e->cfg.gate || r < -e->cfg.gate) {
+            estimator_miss(e, z);
+            return 0;
+        }
+        e->x += e->cfg.alpha * r;
+        if (e->since_update > 0.0f) {
+            e->v += e->cfg.beta / e->since_update * r;
+        }
+    }
+
+    e->since_update = 0.0f;
+    e->rejects = 0;
+    return 1;
+}
+
+void estimator_reject(estimator_t *e)
+{
+    e->rejected++;
+}
+
+int estimator_output(const estimator_t *e, float ahead, float *x, float *v)
+{
+    float coast = e->cfg.max_coast - e->since_update;
+
+    if (!e->initialized) {
+        *x = 0.0f;
+        *v = 0.0f;
+        return 0;
+    }
+    if (ahead > coast) {
+        *x = e->x + e->v * (coast > 0.0f ? coast : 0.0f);
+        *v = 0.0f;
+        return 0;
+    }
+    *x = e->x + e->v * (ahead > 0.0f ? ahead : 0.0f);
+    *v = e->v;
+    return 1;
+}
@@ -0,0 +1,70 @@
+#ifndef __ESTIMATOR_H__
+#define __ESTIMATOR_H__
+
+#include <stdint.h>
+
+/*
+ * 高度状态估计器, 状态为 {高度 x (mm), 速度 v (mm/s)}, 匀速模型
+ *  - 固定增益 alpha-beta 滤波, 或二状态卡尔曼滤波 (过程噪声为白噪声加速度)
+ *  - 每个测量先预测到其时间戳再校正, 测量间隔不均匀也没有关系
+ *  - 新息超过门限的测量视为离群值丢弃, 只预测不校正;
+ *    连续丢弃 max_rejects 个后认为高度确实跳变, 用新测量重新初始化
+ *  - 没有测量时按速度外推, 外推时间超过 max_coast 后不再外推 (速度视为0)
+ * 本文件不依赖RT-Thread, 可以直接在主机上编译
+ */
+
+typedef enum
+{
+    ESTIMATOR_ALPHA_BETA = 0,
+    ESTIMATOR_KALMAN,
+} estimator_type_t;
+
+typedef struct
+{
+    estimator_type_t type;
+    float alpha;            // alpha-beta: 位置校正增益 (0, 1]
+    float beta;             // alpha-beta: 速度校正增益 (0, 2)
+    float accel_noise;      // 卡尔曼: 加速度过程噪声标准差 (mm/s²)
+    float meas_noise;       // 卡尔曼: 测量噪声标准差 (mm)
+    float gate;             // 新息门限: alpha-beta 为 mm, 卡尔曼为新息标准差的倍数
+    uint8_t max_rejects;    // 连续丢弃这么多个测量后重新初始化
+    float max_coast;        // 没有测量时最多外推的时间 (s)
+} estimator_config_t;
+
+typedef struct
+{
+    estimator_config_t cfg;
+    float x;                // 高度 (mm)
+    float v;                // 速度 (mm/s)
+    float p00, p01, p11;    // 卡尔曼协方差
+    float since_update;     // 距上一次接受测量的时间 (s)
+    uint8_t initialized;
+    uint8_t rejects;        // 当前连续丢弃的测量数
+    uint32_t rejected;      // 累计丢弃的测量数
+    float innovation;       // 最近一次测量的新息 (mm)
+} estimator_t;
+
+void estimator_init(estimator_t *e, const estimator_config_t *cfg);
+
+/* 清除状态, 下一个测量直接作为初值 */
+void estimator_reset(estimator_t *e);
+
+/* 状态预测 dt 秒 (推进到下一个测量的时间戳) */
+void estimator_predict(estimator_t *e, float dt);
+
+/**
+ * @brief 用一个测量校正状态, 调用前应先预测到该测量的时间戳
+ * @return 1 接受, 0 作为离群值丢弃
+ */
+int estimator_update(estimator_t *e, float z);
+
+/* 记一个无效测量 (如超量程), 状态不变 */
+void estimator_reject(estimator_t *e);
+
+/**
+ * @brief 从当前状态外推 ahead 秒后的高度和速度, 不修改状态
+ * @return 0 还没有初值或外推时间超过 max_coast (输出为保持的位置, 速度为0), 1 正常
+ */
+int estimator_output(const estimator_t *e, float ahead, float *x, float *v);
+
+#endif /* __ESTIMATOR_H__ */
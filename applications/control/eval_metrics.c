@@ -0,0 +1,60 @@
+#include <string.h>
+#include "eval_metrics.h"
+
+#define FABSF(x) ((x) > 0 ? (x) : -(x))
+
+void eval_metrics_start(eval_metrics_t *m, float setpoint, float measurement, float output, float band)
+{
+    float step = setpoint - measurement;
+
+    memset(m, 0, sizeof(*m));
+    m->band = band;
+    if (step > band) m->direction = 1.0f;
+    else if (step < -band) m->direction = -1.0f;
+    m->last_out = output;
+}
+
+void eval_metrics_update(eval_metrics_t *m, float setpoint, float measurement, float output,
+                         uint8_t saturated, float dt)
+{
+    eval_result_t *r = &m->r;
+    float error = setpoint - measurement;
+    float abs_error = FABSF(error);
+
+    m->t += dt;
+    r->samples++;
+    r->iae += abs_error * dt;
+    r->ise += error * error * dt;
+    r->itae += m->t * abs_error * dt;
+
+    /* 误差为负表示测量值在设定值之上, 向上阶跃时即为超调 */
+    float over = m->direction != 0.0f ? -error * m->direction : abs_error;
+    if (over > r->overshoot) r->overshoot = over;
+
+    if (abs_error > m->band) {
+        m->last_outside = m->t;
+        m->ss_n = 0;
+        m->ss_mean = 0.0f;
+        m->ss_m2 = 0.0f;
+    } else {
+        m->ss_n++;
+        float delta = error - m->ss_mean;
+        m->ss_mean += delta / m->ss_n;
+        m->ss_m2 += delta * (error - m->ss_mean);
+    }
+
+    r->effort += output * dt;
+    r->effort_tv += FABSF(output - m->last_out);
+    m->last_out = output;
+    if (saturated) r->saturated++;
+}
+
+void eval_metrics_result(const eval_metrics_t *m, eval_result_t *r)
+{
+    *r = m->r;
+    r->duration = m->t;
+    r->settled = m->ss_n > 0;
+    r->settling_time = r->settled ? m->last_outside : m->t;
+    r->ss_mean = m->ss_mean;
+    r->ss_var = m->ss_n > 1 ? m->ss_m2 / (m->ss_n - 1) : 0.0f;
+}
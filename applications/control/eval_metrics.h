@@ -0,0 +1,66 @@
+#ifndef __EVAL_METRICS_H__
+#define __EVAL_METRICS_H__
+
+#include <stdint.h>
+
+/*
+ * 控制性能评估指标, 每个样本增量更新, 常数时间, 不保存历史样本
+ *  - 误差积分: IAE = ∫|e|dt, ISE = ∫e²dt, ITAE = ∫t|e|dt
+ *  - 超调: 沿阶跃方向越过设定值的最大距离; 没有阶跃时为最大偏差
+ *  - 调节时间: 最后一次离开误差带的时刻
+ *  - 稳态方差: 最后一次进入误差带以来的误差方差 (Welford 算法)
+ *  - 控制量: ∫u dt, 输出变化总量 Σ|Δu|, 输出被限幅的样本数
+ * 本文件不依赖RT-Thread, 可以直接在主机上编译
+ */
+
+typedef struct
+{
+    float duration;         // 评估时长 (s)
+    uint32_t samples;       // 样本数
+    float iae;              // mm·s
+    float ise;              // mm²·s
+    float itae;             // mm·s²
+    float overshoot;        // mm
+    float settling_time;    // s, 没有稳定时等于 duration
+    uint8_t settled;        // 结束时误差在误差带内
+    float ss_mean;          // 稳态误差均值 (mm)
+    float ss_var;           // 稳态误差方差 (mm²)
+    float effort;           // ∫u dt (占空比·s)
+    float effort_tv;        // Σ|Δu|
+    uint32_t saturated;     // 输出被限幅的样本数
+} eval_result_t;
+
+typedef struct
+{
+    float band;             // 误差带 (mm)
+    float direction;        // 阶跃方向 +1/-1, 0 表示没有阶跃
+    float t;
+    float last_out;
+    float last_outside;     // 最后一次在误差带外的时刻
+    uint32_t ss_n;          // Welford 状态
+    float ss_mean;
+    float ss_m2;
+    eval_result_t r;
+} eval_metrics_t;
+
+/**
+ * @brief 开始一次评估
+ * @param setpoint    评估开始时的设定值 (mm)
+ * @param measurement 评估开始时的测量值 (mm), 与设定值相差超过误差带时视为阶跃
+ * @param output      评估开始时的输出, 用于计算第一个样本的 Δu
+ * @param band        误差带 (mm)
+ */
+void eval_metrics_start(eval_metrics_t *m, float setpoint, float measurement, float output, float band);
+
+/**
+ * @brief 加入一个样本
+ * @param dt        距上一个样本的时间 (s)
+ * @param saturated 本样本的输出是否被限幅
+ */
+void eval_metrics_update(eval_metrics_t *m, float setpoint, float measurement, float output,
+                         uint8_t saturated, float dt);
+
+/* 取当前结果, 评估进行中也可以调用 */
+void eval_metrics_result(const eval_metrics_t *m, eval_result_t *r);
+
+#endif /* __EVAL_METRICS_H__ */
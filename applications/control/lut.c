@@ -0,0 +1,119 @@
+#include <math.h>
+#include "lut.h"
+
+#define LUT_UNIFORM_EPS     1e-4f       // 判断等间距时允许的相对误差
+
+static void lut_build_segment(lut_t *lut, int seg)
+{
+    float dx = lut->x[seg + 1] - lut->x[seg];
+
+    for (int c = 0; c < lut->channels; c++) {
+        float slope = (lut->y[seg + 1][c] - lut->y[seg][c]) / dx;
+        lut->slope[seg][c] = slope;
+        lut->intercept[seg][c] = lut->y[seg][c] - slope * lut->x[seg];
+    }
+}
+
+/* 断点 index 的横坐标是否仍落在等间距网格上 */
+static int lut_on_grid(const lut_t *lut, int index, float x)
+{
+    float step = 1.0f / lut->inv_step;
+    return fabsf(x - (lut->x0 + index * step)) <= step * LUT_UNIFORM_EPS;
+}
+
+int lut_init(lut_t *lut, const float *x, const float *y, int n, int channels)
+{
+    if (n < 1 || n > LUT_MAX_POINTS || channels < 1 || channels > LUT_MAX_CHANNELS) {
+        return -1;
+    }
+    for (int i = 1; i < n; i++) {
+        if (!(x[i] > x[i - 1])) return -1;
+    }
+
+    lut->n = (uint8_t)n;
+    lut->channels = (uint8_t)channels;
+    for (int i = 0; i < n; i++) {
+        lut->x[i] = x[i];
+        for (int c = 0; c < channels; c++) {
+            lut->y[i][c] = y[i * channels + c];
+        }
+    }
+    for (int i = 0; i + 1 < n; i++) {
+        lut_build_segment(lut, i);
+    }
+
+    lut->x0 = x[0];
+    lut->uniform = (n >= 2);
+    if (lut->uniform) {
+        lut->inv_step = (float)(n - 1) / (x[n - 1] - x[0]);
+        for (int i = 1; i + 1 < n && lut->uniform; i++) {
+            lut->uniform = (uint8_t)lut_on_grid(lut, i, x[i]);
+        }
+    }
+    return 0;
+}
+
+int lut_set_point(lut_t *lut, int index, float x, const float *y)
+{
+    if (index < 0 || index >= lut->n) return -1;
+    if (index > 0 && !(x > lut->x[index - 1])) return -1;
+    if (index + 1 < lut->n && !(x < lut->x[index + 1])) return -1;
+
+    /* 横坐标偏离网格后改用二分查找; 修改首末断点会改变网格本身, 同样退出直接下标 */
+    if (lut->uniform && x != lut->x[index]) {
+        if (index == 0 || index == lut->n - 1 || !lut_on_grid(lut, index, x)) {
+            lut->uniform = 0;
+        }
+    }
+
+    lut->x[index] = x;
+    for (int c = 0; c < lut->channels; c++) {
+        lut->y[index][c] = y[c];
+    }
+    if (index > 0) lut_build_segment(lut, index - 1);
+    if (index + 1 < lut->n) lut_build_segment(lut, index);
+    return 0;
+}
+
+static int lut_find_segment(const lut_t *lut, float x)
+{
+    int last = lut->n - 2;
+
+    if (lut->uniform) {
+        int seg = (int)((x - lut->x0) * lut->inv_step);
+        return seg > last ? last : seg;
+    }
+
+    /* x[lo] <= x < x[hi] */
+    int lo = 0, hi = lut->n - 1;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) >> 1;
+        if (x < lut->x[mid]) hi = mid;
+        else lo = mid;
+    }
+    return lo;
+}
+
+void lut_eval(const lut_t *lut, float x, float *y)
+{
+    int edge = -1;
+
+    if (x <= lut->x[0]) edge = 0;
+    else if (x >= lut->x[lut->n - 1]) edge = lut->n - 1;
+    if (edge >= 0) {
+        for (int c = 0; c < lut->channels; c++) y[c] = lut->y[edge][c];
+        return;
+    }
+
+    int seg = lut_find_segment(lut, x);
+    for (int c = 0; c < lut->channels; c++) {
+        y[c] = lut->intercept[seg][c] + lut->slope[seg][c] * x;
+    }
+}
+
+float lut_eval1(const lut_t *lut, float x)
+{
+    float y[LUT_MAX_CHANNELS];
+    lut_eval(lut, x, y);
+    return y[0];
+}
@@ -0,0 +1,53 @@
+#ifndef __LUT_H__
+#define __LUT_H__
+
+#include <stdint.h>
+
+/*
+ * 分段线性插值查找表, 一个横坐标对应多个输出通道 (如 Kp/Ki/Kd)
+ *  - 建表时为每一段预先计算斜率和截距, 查表只需定位段号再做一次乘加
+ *  - 断点等间距时直接由下标计算段号 O(1), 否则二分查找 O(log n)
+ *  - 修改单个断点只重算相邻两段, 不需要整表重建
+ * 超出断点范围时输出首/末断点的值
+ * 本文件不依赖RT-Thread, 并发修改时由调用方加锁
+ */
+
+#define LUT_MAX_POINTS      16
+#define LUT_MAX_CHANNELS    3
+
+typedef struct
+{
+    uint8_t n;                                  // 断点数
+    uint8_t channels;                           // 输出通道数
+    uint8_t uniform;                            // 断点是否等间距
+    float x0;                                   // 等间距时的首断点
+    float inv_step;                             // 等间距时的 1 / 间距
+    float x[LUT_MAX_POINTS];
+    float y[LUT_MAX_POINTS][LUT_MAX_CHANNELS];
+    float slope[LUT_MAX_POINTS - 1][LUT_MAX_CHANNELS];      // 第 i 段: [x[i], x[i+1]]
+    float intercept[LUT_MAX_POINTS - 1][LUT_MAX_CHANNELS];
+} lut_t;
+
+/**
+ * @brief 由断点建表
+ * @param x        断点横坐标, 必须严格递增
+ * @param y        断点输出, 按行存放 (n 行, 每行 channels 个)
+ * @param n        断点数, 1 ~ LUT_MAX_POINTS
+ * @param channels 输出通道数, 1 ~ LUT_MAX_CHANNELS
+ * @return 0 成功, -1 参数非法
+ */
+int lut_init(lut_t *lut, const float *x, const float *y, int n, int channels);
+
+/**
+ * @brief 修改一个断点, 只重算与之相邻的两段
+ * @return 0 成功, -1 下标越界或新横坐标破坏递增顺序 (表保持不变)
+ */
+int lut_set_point(lut_t *lut, int index, float x, const float *y);
+
+/* 查表, 输出 channels 个值到 y */
+void lut_eval(const lut_t *lut, float x, float *y);
+
+/* 单通道表的便捷接口 */
+float lut_eval1(const lut_t *lut, float x);
+
+#endif /* __LUT_H__ */
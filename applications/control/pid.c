@@ -0,0 +1,212 @@
+#include <math.h>
+#include <stddef.h>
+#include "pid.h"
+
+#define Q31_ONE         2147483648.0f       // 2^31
+#define Q16_ONE         65536
+#define PID_MAX_SHIFT   7                   // Q31增益最大 2^7 (每mm输出满量程的128倍)
+
+static int32_t sat_q31(int64_t x)
+{
+    if (x > INT32_MAX) return INT32_MAX;
+    if (x < INT32_MIN) return INT32_MIN;
+    return (int32_t)x;
+}
+
+static int32_t float_to_q31(float x)
+{
+    if (x >= 1.0f) return INT32_MAX;
+    if (x <= -1.0f) return INT32_MIN;
+    return (int32_t)(x * Q31_ONE);
+}
+
+/* 把浮点增益拆成Q31尾数和左移位数, 使尾数落在 [-1, 1) 内 */
+static void gain_to_q31(float gain, int32_t *mantissa, int8_t *shift)
+{
+    int exp = 0;
+    frexpf(gain, &exp);
+    if (exp < 0) exp = 0;
+    if (exp > PID_MAX_SHIFT) exp = PID_MAX_SHIFT;
+    *shift = (int8_t)exp;
+    *mantissa = float_to_q31(ldexpf(gain, -exp));
+}
+
+/* 增益尾数 * 信号(Q16) -> 输出(Q31) */
+static int32_t gain_mul_q16(int32_t mantissa, int8_t shift, int32_t value_q16)
+{
+    return sat_q31(((int64_t)mantissa * value_q16) >> (16 - shift));
+}
+
+void pid_set_gains(pid_controller_t *pid, float kp, float ki, float kd)
+{
+    pid->cfg.kp = kp;
+    pid->cfg.ki = ki;
+    pid->cfg.kd = kd;
+
+    if (pid->cfg.backend == PID_BACKEND_Q31) {
+        gain_to_q31(kp, &pid->s.q31.kp, &pid->s.q31.kp_shift);
+        gain_to_q31(ki, &pid->s.q31.ki, &pid->s.q31.ki_shift);
+        gain_to_q31(kd, &pid->s.q31.kd, &pid->s.q31.kd_shift);
+    }
+}
+
+void pid_reset(pid_controller_t *pid)
+{
+    pid->primed = 0;
+    pid->terms = (pid_terms_t){0};
+    if (pid->cfg.backend == PID_BACKEND_Q31) {
+        pid->s.q31.integral = 0;
+        pid->s.q31.prev_meas = 0;
+        pid->s.q31.d_state = 0;
+    } else {
+        pid->s.f32.integral = 0.0f;
+        pid->s.f32.prev_meas = 0.0f;
+        pid->s.f32.d_state = 0.0f;
+    }
+}
+
+void pid_init(pid_controller_t *pid, const pid_config_t *cfg)
+{
+    pid->cfg = *cfg;
+    if (pid->cfg.ts <= 0.0f) pid->cfg.ts = 1.0f;
+
+    if (pid->cfg.backend == PID_BACKEND_Q31) {
+        float alpha = pid->cfg.ts / (pid->cfg.d_tau + pid->cfg.ts);
+        pid->s.q31.d_alpha = (int32_t)(alpha * Q16_ONE);
+        pid->s.q31.out_min = float_to_q31(pid->cfg.out_min);
+        pid->s.q31.out_max = float_to_q31(pid->cfg.out_max);
+    }
+    pid_set_gains(pid, cfg->kp, cfg->ki, cfg->kd);
+    pid_reset(pid);
+}
+
+float pid_get_integral(const pid_controller_t *pid)
+{
+    if (pid->cfg.backend == PID_BACKEND_Q31) {
+        return (float)pid->s.q31.integral / Q16_ONE;
+    }
+    return pid->s.f32.integral;
+}
+
+/* ext_rate 非空时直接使用外部给出的测量值变化率 (mm / 整定周期, 已取负), 不差分也不滤波 */
+static float pid_update_f32(pid_controller_t *pid, float setpoint, float measurement, float feedforward, float dt,
+                            const float *ext_rate)
+{
+    const pid_config_t *cfg = &pid->cfg;
+    float k = dt / cfg->ts;     // 实际周期相对整定周期的比例
+    float error = setpoint - measurement;
+
+    if (ext_rate) {
+        pid->s.f32.d_state = *ext_rate;
+    } else {
+        /* 微分作用于测量值, 一阶低通 alpha = dt / (tau + dt) */
+        float rate = pid->primed ? (pid->s.f32.prev_meas - measurement) / k : 0.0f;
+        float alpha = dt / (cfg->d_tau + dt);
+        pid->s.f32.d_state += alpha * (rate - pid->s.f32.d_state);
+    }
+    pid->s.f32.prev_meas = measurement;
+    pid->primed = 1;
+
+    float p = cfg->kp * error;
+    float d = cfg->kd * pid->s.f32.d_state;
+    float integral = pid->s.f32.integral + error * k;
+    float out = feedforward + p + cfg->ki * integral + d;
+
+    /* 条件积分: 输出已饱和且误差会使饱和加剧时, 保持积分不变 */
+    if ((out > cfg->out_max && error > 0.0f) || (out < cfg->out_min && error < 0.0f)) {
+        integral = pid->s.f32.integral;
+    }
+    pid->s.f32.integral = integral;
+
+    float i = cfg->ki * integral;
+    float sum = feedforward + p + i + d;
+    out = sum;
+    if (out > cfg->out_max) out = cfg->out_max;
+    if (out < cfg->out_min) out = cfg->out_min;
+
+    pid->terms.p = p;
+    pid->terms.i = i;
+    pid->terms.d = d;
+    pid->terms.ff = feedforward;
+    pid->terms.out = out;
+    pid->terms.saturated = (out != sum);
+    return out;
+}
+
+static int32_t pid_step_q31(pid_controller_t *pid, int32_t setpoint, int32_t measurement, int32_t feedforward, int32_t k_q16,
+                            const int32_t *ext_rate_q16)
+{
+    int32_t error = setpoint - measurement;
+
+    if (ext_rate_q16) {
+        pid->s.q31.d_state = *ext_rate_q16;
+    } else {
+        int32_t rate_q16 = 0;
+        if (pid->primed) {
+            rate_q16 = (int32_t)(((int64_t)(pid->s.q31.prev_meas - measurement) << 32) / k_q16);
+        }
+        pid->s.q31.d_state += (int32_t)(((int64_t)pid->s.q31.d_alpha * (rate_q16 - pid->s.q31.d_state)) >> 16);
+    }
+    pid->s.q31.prev_meas = measurement;
+    pid->primed = 1;
+
+    int32_t p = gain_mul_q16(pid->s.q31.kp, pid->s.q31.kp_shift, error * Q16_ONE);
+    int32_t d = gain_mul_q16(pid->s.q31.kd, pid->s.q31.kd_shift, pid->s.q31.d_state);
+    int64_t integral = pid->s.q31.integral + (int64_t)error * k_q16;
+    /* 积分项先降到Q8再乘增益, 避免64位乘法溢出 */
+    int32_t i = sat_q31(((int64_t)pid->s.q31.ki * sat_q31(integral >> 8)) >> (8 - pid->s.q31.ki_shift));
+    int64_t sum = (int64_t)feedforward + p + i + d;
+
+    if ((sum > pid->s.q31.out_max && error > 0) || (sum < pid->s.q31.out_min && error < 0)) {
+        integral = pid->s.q31.integral;
+        i = sat_q31(((int64_t)pid->s.q31.ki * sat_q31(integral >> 8)) >> (8 - pid->s.q31.ki_shift));
+        sum = (int64_t)feedforward + p + i + d;
+    }
+    pid->s.q31.integral = integral;
+
+    int32_t out = sat_q31(sum);
+    if (out > pid->s.q31.out_max) out = pid->s.q31.out_max;
+    if (out < pid->s.q31.out_min) out = pid->s.q31.out_min;
+
+    pid->terms.p = p / Q31_ONE;
+    pid->terms.i = i / Q31_ONE;
+    pid->terms.d = d / Q31_ONE;
+    pid->terms.ff = feedforward / Q31_ONE;
+    pid->terms.out = out / Q31_ONE;
+    pid->terms.saturated = (out != sum);
+    return out;
+}
+
+int32_t pid_update_q31(pid_controller_t *pid, int32_t setpoint, int32_t measurement, int32_t feedforward)
+{
+    return pid_step_q31(pid, setpoint, measurement, feedforward, Q16_ONE, NULL);
+}
+
+static float pid_update_common(pid_controller_t *pid, float setpoint, float measurement, float feedforward, float dt,
+                               const float *rate)
+{
+    if (dt <= 0.0f) dt = pid->cfg.ts;
+
+    /* 微分状态的单位是 "测量值减小的速度, mm / 整定周期" */
+    float ext_rate = rate ? -*rate * pid->cfg.ts : 0.0f;
+
+    if (pid->cfg.backend == PID_BACKEND_Q31) {
+        int32_t k_q16 = (int32_t)(dt / pid->cfg.ts * Q16_ONE);
+        if (k_q16 < 1) k_q16 = 1;
+        int32_t ext_rate_q16 = (int32_t)lrintf(ext_rate * Q16_ONE);
+        int32_t out = pid_step_q31(pid, (int32_t)lrintf(setpoint), (int32_t)lrintf(measurement),
+                                   float_to_q31(feedforward), k_q16, rate ? &ext_rate_q16 : NULL);
+        return out / Q31_ONE;
+    }
+    return pid_update_f32(pid, setpoint, measurement, feedforward, dt, rate ? &ext_rate : NULL);
+}
+
+float pid_update(pid_controller_t *pid, float setpoint, float measurement, float feedforward, float dt)
+{
+    return pid_update_common(pid, setpoint, measurement, feedforward, dt, NULL);
+}
+
+float pid_update_rate(pid_controller_t *pid, float setpoint, float measurement, float rate, float feedforward, float dt)
+{
+    return pid_update_common(pid, setpoint, measurement, feedforward, dt, &rate);
+}
@@ -0,0 +1,95 @@
+#ifndef __PID_H__
+#define __PID_H__
+
+#include <stdint.h>
+
+/*
+ * 通用PID控制器, 可同时存在多个实例
+ *  - 微分作用于测量值 (设定值跳变不会产生微分冲击), 带一阶低通滤波
+ *  - 条件积分抗饱和: 输出饱和且误差方向会加剧饱和时停止积分
+ *  - 每次更新为固定的常数时间, 无循环和查表
+ * 增益沿用"每个整定周期"的单位 (ts), 实际周期 dt 不同时自动换算积分和微分
+ * 本文件不依赖RT-Thread, 可以直接在主机上编译做基准测试
+ */
+
+typedef enum
+{
+    PID_BACKEND_F32 = 0,    // 单精度浮点 (M33带FPU, 默认)
+    PID_BACKEND_Q31,        // 定点: 信号为整数mm, 输出为Q31, 64位乘累加+饱和
+} pid_backend_t;
+
+typedef struct
+{
+    pid_backend_t backend;
+    float kp;
+    float ki;
+    float kd;
+    float ts;               // 增益整定时的采样周期 (s)
+    float d_tau;            // 微分低通滤波时间常数 (s), 0 表示不滤波
+    float out_min;          // 输出下限 (Q31后端要求在 [-1, 1) 内)
+    float out_max;          // 输出上限
+} pid_config_t;
+
+/* 最近一次更新的各项输出, 供遥测/评估使用 */
+typedef struct
+{
+    float p;
+    float i;
+    float d;
+    float ff;
+    float out;
+    uint8_t saturated;      // 本次输出是否被限幅
+} pid_terms_t;
+
+typedef struct
+{
+    pid_config_t cfg;
+    pid_terms_t terms;
+    uint8_t primed;         // 已有上一次测量值, 可以计算微分
+    union
+    {
+        struct
+        {
+            float integral;     // 误差积分 (mm * 整定周期)
+            float prev_meas;
+            float d_state;      // 滤波后的测量值变化率 (mm / 整定周期)
+        } f32;
+        struct
+        {
+            int32_t kp, ki, kd;             // 增益尾数, 增益 = 尾数 * 2^shift / 2^31
+            int8_t kp_shift, ki_shift, kd_shift;
+            int32_t d_alpha;                // 微分低通系数 (Q16, 按 ts 预先计算)
+            int32_t out_min, out_max;       // Q31
+            int64_t integral;               // 误差积分 (mm * 整定周期, Q16)
+            int32_t prev_meas;              // mm
+            int32_t d_state;                // mm / 整定周期, Q16
+        } q31;
+    } s;
+} pid_controller_t;
+
+void pid_init(pid_controller_t *pid, const pid_config_t *cfg);
+void pid_reset(pid_controller_t *pid);
+void pid_set_gains(pid_controller_t *pid, float kp, float ki, float kd);
+float pid_get_integral(const pid_controller_t *pid);
+
+/**
+ * @brief 执行一次PID更新
+ * @param setpoint    设定值 (mm)
+ * @param measurement 测量值 (mm)
+ * @param feedforward 前馈量, 直接叠加到输出
+ * @param dt          距上一次更新的时间 (s)
+ * @return 限幅后的控制输出
+ */
+float pid_update(pid_controller_t *pid, float setpoint, float measurement, float feedforward, float dt);
+
+/**
+ * @brief 与 pid_update() 相同, 但微分项使用外部给出的测量值变化率 (如状态估计器的速度),
+ *        不再差分测量值, 也不经过 d_tau 低通
+ * @param rate 测量值变化率 (mm/s)
+ */
+float pid_update_rate(pid_controller_t *pid, float setpoint, float measurement, float rate, float feedforward, float dt);
+
+/* Q31后端的纯整数入口: 固定周期 ts, 输入为整数mm, 前馈和输出为Q31 */
+int32_t pid_update_q31(pid_controller_t *pid, int32_t setpoint, int32_t measurement, int32_t feedforward);
+
+#endif /* __PID_H__ */
@@ -0,0 +1,122 @@
+#include <rtthread.h>
+#include <rtatomic.h>
+#include <string.h>
+#include "telemetry.h"
+
+#define STREAM_RING_SIZE    64                      // 流式遥测帧缓冲, 必须为2的幂; 200Hz下约320ms
+#define STREAM_RING_MASK    (STREAM_RING_SIZE - 1)
+
+/*
+ * 顺序锁: 写者在拷贝前后各把版本号加一, 拷贝期间版本号为奇数
+ * 读者拷贝前后版本号一致且为偶数才算读到完整快照, 否则重读
+ * 写者(控制线程)从不等待读者, 读者也不关中断、不持锁
+ */
+static volatile rt_atomic_t tm_version = 0;
+static struct telemetry tm_data;
+
+/* 单生产者(控制线程)/单消费者(远程服务器线程)无锁环形缓冲区, 写法同 tof.c */
+static struct telemetry_frame stream_ring[STREAM_RING_SIZE];
+static volatile rt_atomic_t stream_head = 0;        // 只由控制线程写
+static volatile rt_atomic_t stream_tail = 0;        // 只由读取者写
+static volatile rt_atomic_t stream_on = 0;
+static rt_uint32_t stream_dropped = 0;
+
+static void stream_push(const struct telemetry *t)
+{
+    rt_ubase_t head = (rt_ubase_t)rt_atomic_load(&stream_head);
+    struct telemetry_frame *f = &stream_ring[head & STREAM_RING_MASK];
+
+    f->seq = t->seq;
+    f->tick = t->tick;
+    f->height = t->current_height;
+    f->setpoint = t->ramped_height;
+    f->p = t->pid_p;
+    f->i = t->pid_i;
+    f->d = t->pid_d;
+    f->ff = t->feedforward_speed;
+    f->duty = t->fan_speed;
+    rt_atomic_store(&stream_head, (rt_atomic_t)(head + 1));
+}
+
+void telemetry_publish(const struct telemetry *t)
+{
+    rt_atomic_t version = rt_atomic_load(&tm_version);
+
+    rt_atomic_store(&tm_version, version + 1);
+    memcpy(&tm_data, t, sizeof(tm_data));
+    rt_atomic_store(&tm_version, version + 2);
+
+    if (rt_atomic_load(&stream_on)) {
+        stream_push(t);
+    }
+}
+
+void telemetry_read(struct telemetry *t)
+{
+    while (1)
+    {
+        rt_atomic_t begin = rt_atomic_load(&tm_version);
+        if (begin & 1) {
+            /* 写者只会在更高优先级的控制线程中, 这里让出CPU等它写完 */
+            rt_thread_yield();
+            continue;
+        }
+
+        memcpy(t, &tm_data, sizeof(*t));
+
+        if (rt_atomic_load(&tm_version) == begin) {
+            return;
+        }
+    }
+}
+
+void telemetry_stream_enable(rt_bool_t enable)
+{
+    /* 打开时丢弃缓冲区中的旧帧, 只发送此后的周期 */
+    if (enable) {
+        rt_atomic_store(&stream_tail, rt_atomic_load(&stream_head));
+    }
+    rt_atomic_store(&stream_on, enable ? 1 : 0);
+}
+
+/**
+ * @brief 取出最多 max 帧, 不阻塞 (仅限单个读取者调用)
+ * @param frames 输出缓冲
+ * @param max    最多取出的帧数
+ * @return 实际取出的帧数
+ */
+rt_size_t telemetry_stream_read(struct telemetry_frame *frames, rt_size_t max)
+{
+    rt_ubase_t tail = (rt_ubase_t)rt_atomic_load(&stream_tail);
+    rt_size_t count = 0;
+
+    while (count < max)
+    {
+        rt_ubase_t head = (rt_ubase_t)rt_atomic_load(&stream_head);
+        if (head == tail) {
+            break;
+        }
+        /* 读取太慢时跳过已被覆盖的旧帧 */
+        if (head - tail >= STREAM_RING_SIZE) {
+            stream_dropped += head - tail - (STREAM_RING_SIZE - 1);
+            tail = head - (STREAM_RING_SIZE - 1);
+        }
+
+        frames[count] = stream_ring[tail & STREAM_RING_MASK];
+
+        /* 拷贝期间控制线程可能已绕回改写该槽位, 此时重新读取 */
+        head = (rt_ubase_t)rt_atomic_load(&stream_head);
+        if (head - tail < STREAM_RING_SIZE) {
+            tail++;
+            count++;
+        }
+    }
+
+    rt_atomic_store(&stream_tail, (rt_atomic_t)tail);
+    return count;
+}
+
+rt_uint32_t telemetry_stream_dropped(void)
+{
+    return stream_dropped;
+}
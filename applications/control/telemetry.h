@@ -0,0 +1,61 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <rtthread.h>
+
+/* 控制线程每个周期发布一次的状态快照, 所有字段属于同一个控制周期 */
+struct telemetry
+{
+    rt_uint32_t seq;                // 发布序号, 每个控制周期加一
+    rt_tick_t   tick;               // 发布时刻 (tick)
+    rt_int32_t  current_height;     // 当前高度 (mm)
+    float target_height;            // 最终目标高度 (mm)
+    float ramped_height;            // 斜坡后的目标高度 (mm)
+    float est_height;               // 控制器使用的高度估计 (mm)
+    float est_velocity;             // 控制器微分项使用的速度估计 (mm/s)
+    float kp;
+    float ki;
+    float kd;
+    float integral_error;
+    float previous_error;
+    float feedforward_speed;
+    float pid_p;                    // PID各项输出
+    float pid_i;
+    float pid_d;
+    float fan_speed;                // 本周期输出到风扇的占空比
+    rt_bool_t is_evaluating;
+    float total_abs_error;
+};
+
+/*
+ * 流式遥测帧: 每个控制周期一帧, 固定布局, 小端序, 无填充 (36字节)
+ * 远程服务器把若干帧打包成一批发送, 批格式见 remote.c
+ */
+struct telemetry_frame
+{
+    rt_uint32_t seq;                // 与 telemetry.seq 相同, 用于发现丢帧
+    rt_uint32_t tick;               // 发布时刻 (tick)
+    rt_int32_t  height;             // 当前高度 (mm)
+    float setpoint;                 // 斜坡后的目标高度 (mm)
+    float p;
+    float i;
+    float d;
+    float ff;
+    float duty;                     // 风扇占空比
+};
+
+/* 发布一份快照, 只允许控制线程调用, 不会阻塞 */
+void telemetry_publish(const struct telemetry *t);
+
+/* 读取最近一次发布的完整快照, 可在任意线程调用 (不可在中断中调用) */
+void telemetry_read(struct telemetry *t);
+
+/*
+ * 流式遥测: 打开后控制线程每次发布时额外向环形缓冲区写入一帧
+ * 只允许一个读取者 (远程服务器线程), 读取者来不及取走时丢弃最旧的帧
+ */
+void telemetry_stream_enable(rt_bool_t enable);
+rt_size_t telemetry_stream_read(struct telemetry_frame *frames, rt_size_t max);
+rt_uint32_t telemetry_stream_dropped(void);
+
+#endif /* __TELEMETRY_H__ */
@@ -0,0 +1,382 @@
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <rtatomic.h>
+#include "sensor_st_vl53l0x.h"
+#include "tof.h"
+
+#define TOF_RING_SIZE           8                       // 样本环形缓冲区长度, 必须为2的幂
+#define TOF_RING_MASK           (TOF_RING_SIZE - 1)
+#define TOF_THREAD_STACK_SIZE   1024
+#define TOF_POLL_GAP_MS         2                       // 轮询模式下两次测距之间让出CPU的时间 (ms)
+#define TOF_I2C_ADDR            0x29                    // VL53L0X 默认7位地址
+#define TOF_READY_TIMEOUT_MS    100                     // 连续测距约33ms一帧, 超过3帧没有中断视为丢失
+#define TOF_IRQ_MAX_MISSES      3                       // 连续这么多次等不到数据就绪后退回轮询
+
+/* VL53L0X 寄存器, 与 ST API / vl53l0x_device.h 中的定义一致 */
+#define VL53L0X_REG_SYSRANGE_START              0x00
+#define VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG     0x0A
+#define VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR      0x0B
+#define VL53L0X_REG_RESULT_INTERRUPT_STATUS     0x13
+#define VL53L0X_REG_RESULT_RANGE_STATUS         0x14
+#define VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH     0x84
+#define VL53L0X_SYSRANGE_SINGLESHOT             0x01
+#define VL53L0X_SYSRANGE_BACK_TO_BACK           0x02
+#define VL53L0X_GPIO_NEW_SAMPLE_READY           0x04
+
+/* 单生产者(采集线程)/单消费者(控制线程)无锁环形缓冲区 */
+static struct tof_sample ring[TOF_RING_SIZE];
+static volatile rt_atomic_t ring_head = 0;              // 只由采集线程写
+static volatile rt_atomic_t ring_tail = 0;              // 只由控制线程写
+
+static rt_device_t tof_dev = RT_NULL;
+static struct rt_semaphore ready_sem;
+static volatile rt_tick_t ready_tick;                   // 最近一次数据就绪中断的时刻, 作为样本时间戳
+static struct rt_thread tof_thread;
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t tof_thread_stack[TOF_THREAD_STACK_SIZE];
+static rt_bool_t tof_started = RT_FALSE;
+static struct tof_stats tof_stat;
+
+static void tof_push(rt_uint32_t timestamp, rt_int32_t height)
+{
+    rt_ubase_t head = (rt_ubase_t)rt_atomic_load(&ring_head);
+    struct tof_sample *slot = &ring[head & TOF_RING_MASK];
+
+    slot->timestamp = timestamp;
+    slot->height = height;
+    /* 样本写完后再发布head, 消费者看到的槽位总是完整的 */
+    rt_atomic_store(&ring_head, (rt_atomic_t)(head + 1));
+    tof_stat.samples++;
+}
+
+#if APP_TOF_INT_PIN >= 0
+/*
+ * 中断模式: 软件包只提供单次测距 (rt_device_read 每次启动一次测量并等待结果),
+ * 这里直接在同一条I2C总线上把传感器切到背靠背连续测距, GPIO1 配成新样本就绪
+ * (低电平有效), 每个样本到来时读结果寄存器并清中断; 软件包的校准和初始化不变
+ */
+static struct rt_i2c_bus_device *tof_bus = RT_NULL;
+static rt_uint8_t tof_stop_variable;
+
+static rt_err_t tof_reg_write(rt_uint8_t reg, rt_uint8_t value)
+{
+    rt_uint8_t buf[2] = { reg, value };
+    struct rt_i2c_msg msg = { TOF_I2C_ADDR, RT_I2C_WR, sizeof(buf), buf };
+
+    return rt_i2c_transfer(tof_bus, &msg, 1) == 1 ? RT_EOK : -RT_EIO;
+}
+
+/* 写索引再读, 驱动合并为一次带重复起始位的传输 */
+static rt_err_t tof_reg_read(rt_uint8_t reg, rt_uint8_t *buf, rt_uint16_t len)
+{
+    struct rt_i2c_msg msgs[2] = {
+        { TOF_I2C_ADDR, RT_I2C_WR, 1, &reg },
+        { TOF_I2C_ADDR, RT_I2C_RD, len, buf },
+    };
+
+    return rt_i2c_transfer(tof_bus, msgs, 2) == 2 ? RT_EOK : -RT_EIO;
+}
+
+/* 进入/退出内部寄存器页写 0x91 (stop variable), 序列与 ST API 的 StartMeasurement/StopMeasurement 相同 */
+static rt_err_t tof_write_stop_variable(rt_uint8_t value)
+{
+    rt_err_t err = RT_EOK;
+
+    err |= tof_reg_write(0x80, 0x01);
+    err |= tof_reg_write(0xFF, 0x01);
+    err |= tof_reg_write(0x00, 0x00);
+    err |= tof_reg_write(0x91, value);
+    err |= tof_reg_write(0x00, 0x01);
+    err |= tof_reg_write(0xFF, 0x00);
+    err |= tof_reg_write(0x80, 0x00);
+    return err == RT_EOK ? RT_EOK : -RT_EIO;
+}
+
+/**
+ * @brief 配置 GPIO1 为新样本就绪中断并启动背靠背连续测距
+ */
+static rt_err_t tof_continuous_start(void)
+{
+    rt_uint8_t mux;
+    rt_err_t err = RT_EOK;
+
+    tof_bus = rt_i2c_bus_device_find(APP_TOF_I2C_BUS_NAME);
+    if (tof_bus == RT_NULL) {
+        return -RT_ERROR;
+    }
+
+    /* stop variable 由 DataInit 从 0x91 读出, 启动测量时要写回 */
+    err |= tof_reg_write(0x80, 0x01);
+    err |= tof_reg_write(0xFF, 0x01);
+    err |= tof_reg_write(0x00, 0x00);
+    err |= tof_reg_read(0x91, &tof_stop_variable, 1);
+    err |= tof_reg_write(0x00, 0x01);
+    err |= tof_reg_write(0xFF, 0x00);
+    err |= tof_reg_write(0x80, 0x00);
+
+    err |= tof_reg_write(VL53L0X_REG_SYSTEM_INTERRUPT_CONFIG, VL53L0X_GPIO_NEW_SAMPLE_READY);
+    err |= tof_reg_read(VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH, &mux, 1);
+    err |= tof_reg_write(VL53L0X_REG_GPIO_HV_MUX_ACTIVE_HIGH, mux & ~0x10);     // 低电平有效
+    err |= tof_reg_write(VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
+    if (err != RT_EOK) {
+        return -RT_EIO;
+    }
+
+    if (tof_write_stop_variable(tof_stop_variable) != RT_EOK) {
+        return -RT_EIO;
+    }
+    return tof_reg_write(VL53L0X_REG_SYSRANGE_START, VL53L0X_SYSRANGE_BACK_TO_BACK);
+}
+
+/* 停止连续测距, 之后软件包的单次测距照常工作 */
+static void tof_continuous_stop(void)
+{
+    tof_reg_write(VL53L0X_REG_SYSRANGE_START, VL53L0X_SYSRANGE_SINGLESHOT);
+    tof_write_stop_variable(0x00);
+    tof_reg_write(VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
+}
+
+/**
+ * @brief 有新样本时读出距离并清中断
+ * @return RT_EOK 读到样本; -RT_EEMPTY 还没有新样本; -RT_EIO 总线错误
+ */
+static rt_err_t tof_continuous_read(rt_int32_t *height)
+{
+    rt_uint8_t status, result[12];
+
+    if (tof_reg_read(VL53L0X_REG_RESULT_INTERRUPT_STATUS, &status, 1) != RT_EOK) {
+        return -RT_EIO;
+    }
+    if ((status & 0x07) == 0) {
+        return -RT_EEMPTY;
+    }
+    if (tof_reg_read(VL53L0X_REG_RESULT_RANGE_STATUS, result, sizeof(result)) != RT_EOK) {
+        return -RT_EIO;
+    }
+    *height = (result[10] << 8) | result[11];
+    return tof_reg_write(VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
+}
+
+/**
+ * @brief GPIO1数据就绪回调 (中断上下文), 记下就绪时刻并唤醒采集线程读取结果
+ */
+static void tof_ready_isr(void *args)
+{
+    RT_UNUSED(args);
+    ready_tick = rt_tick_get();
+    rt_sem_release(&ready_sem);
+}
+
+static rt_err_t tof_irq_start(void)
+{
+    rt_pin_mode(APP_TOF_INT_PIN, PIN_MODE_INPUT_PULLUP);   // GPIO1 开漏输出
+    if (rt_pin_attach_irq(APP_TOF_INT_PIN, PIN_IRQ_MODE_FALLING, tof_ready_isr, RT_NULL) != RT_EOK) {
+        return -RT_ERROR;
+    }
+    if (tof_continuous_start() != RT_EOK) {
+        rt_pin_detach_irq(APP_TOF_INT_PIN);
+        tof_continuous_stop();
+        return -RT_EIO;
+    }
+    if (rt_pin_irq_enable(APP_TOF_INT_PIN, PIN_IRQ_ENABLE) != RT_EOK) {
+        rt_pin_detach_irq(APP_TOF_INT_PIN);
+        tof_continuous_stop();
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
+
+static void tof_irq_stop(void)
+{
+    rt_pin_irq_enable(APP_TOF_INT_PIN, PIN_IRQ_DISABLE);
+    rt_pin_detach_irq(APP_TOF_INT_PIN);
+    tof_continuous_stop();
+}
+
+/**
+ * @brief 中断模式下取一个样本: 等数据就绪中断, 超时也查一次状态寄存器 (边沿可能丢失)
+ *        连续 TOF_IRQ_MAX_MISSES 次超时且没有新样本时关闭中断, 退回轮询
+ */
+static void tof_irq_acquire(void)
+{
+    static rt_uint8_t misses = 0;
+    rt_int32_t height;
+
+    rt_err_t wait = rt_sem_take(&ready_sem, rt_tick_from_millisecond(TOF_READY_TIMEOUT_MS));
+    if (wait != RT_EOK) {
+        tof_stat.irq_timeouts++;
+    }
+
+    /* 时间戳取中断时刻, 不含唤醒延迟和I2C读取时间; 边沿丢失时只能取当前时刻 */
+    rt_tick_t stamp = wait == RT_EOK ? ready_tick : rt_tick_get();
+    rt_err_t err = tof_continuous_read(&height);
+    if (err == RT_EOK) {
+        misses = 0;
+        tof_push(stamp, height);
+        return;
+    }
+    if (err == -RT_EIO) {
+        tof_stat.read_errors++;
+    }
+    if (wait != RT_EOK && ++misses >= TOF_IRQ_MAX_MISSES) {
+        tof_irq_stop();
+        tof_stat.irq_mode = RT_FALSE;
+        rt_kprintf("[ToF] No data-ready interrupt for %d frames, falling back to polling.\n", misses);
+    }
+}
+#endif /* APP_TOF_INT_PIN >= 0 */
+
+/**
+ * @brief 采集线程入口: 中断模式下每个数据就绪中断读一次, 否则连续背靠背单次测距
+ * @param parameter 线程参数 (未使用)
+ */
+static void tof_thread_entry(void *parameter)
+{
+    struct rt_sensor_data data;
+
+    RT_UNUSED(parameter);
+    while (1)
+    {
+#if APP_TOF_INT_PIN >= 0
+        if (tof_stat.irq_mode) {
+            tof_irq_acquire();
+            continue;
+        }
+#endif
+        if (rt_device_read(tof_dev, 0, &data, 1) == 1) {
+            tof_push(data.timestamp, data.data.proximity);
+        } else {
+            tof_stat.read_errors++;
+        }
+        rt_thread_mdelay(TOF_POLL_GAP_MS);
+    }
+}
+
+/**
+ * @brief 取出最早一个未读样本, 不阻塞 (仅限单个消费者调用)
+ * @param sample 输出样本
+ * @return RT_TRUE 取到新样本, RT_FALSE 缓冲区为空
+ */
+rt_bool_t tof_read(struct tof_sample *sample)
+{
+    rt_ubase_t tail = (rt_ubase_t)rt_atomic_load(&ring_tail);
+
+    while (1)
+    {
+        rt_ubase_t head = (rt_ubase_t)rt_atomic_load(&ring_head);
+        if (head == tail) {
+            return RT_FALSE;
+        }
+        /* 消费太慢时跳过已被覆盖的旧样本 */
+        if (head - tail >= TOF_RING_SIZE) {
+            tof_stat.dropped += head - tail - (TOF_RING_SIZE - 1);
+            tail = head - (TOF_RING_SIZE - 1);
+        }
+
+        *sample = ring[tail & TOF_RING_MASK];
+
+        /* 拷贝期间生产者可能已绕回改写该槽位, 此时重新读取 */
+        head = (rt_ubase_t)rt_atomic_load(&ring_head);
+        if (head - tail < TOF_RING_SIZE) {
+            break;
+        }
+    }
+
+    rt_atomic_store(&ring_tail, (rt_atomic_t)(tail + 1));
+    return RT_TRUE;
+}
+
+/**
+ * @brief 取出所有未读样本并返回其中最新的一个, 不阻塞
+ * @param sample 输出样本
+ * @return RT_TRUE 有新样本, RT_FALSE 自上次读取后没有新样本
+ */
+rt_bool_t tof_read_latest(struct tof_sample *sample)
+{
+    rt_bool_t fresh = RT_FALSE;
+
+    while (tof_read(sample)) {
+        fresh = RT_TRUE;
+    }
+    return fresh;
+}
+
+void tof_get_stats(struct tof_stats *stats)
+{
+    *stats = tof_stat;
+}
+
+/**
+ * @brief 在硬件I2C总线上注册VL53L0X传感器设备 (设备名 "tof_vl53l0x")
+ *        代替软件包示例中写死在软件I2C总线上的注册
+ */
+static int tof_sensor_port(void)
+{
+    struct rt_sensor_config cfg = {0};
+
+    cfg.intf.dev_name = APP_TOF_I2C_BUS_NAME;
+    cfg.intf.user_data = (void *)TOF_I2C_ADDR;
+    cfg.irq_pin.pin = PIN_IRQ_PIN_NONE;
+
+    if (rt_hw_vl53l0x_init("vl53l0x", &cfg, APP_TOF_XSHUT_PIN) != RT_EOK) {
+        rt_kprintf("[ToF] VL53L0X init on %s failed!\n", APP_TOF_I2C_BUS_NAME);
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
+INIT_COMPONENT_EXPORT(tof_sensor_port);
+
+/**
+ * @brief 打开ToF传感器并启动采集线程
+ *        配置了 GPIO1 引脚时用数据就绪中断+连续测距, 配置失败或中断丢失时退回到线程内轮询
+ * @return RT_EOK 成功, 其他值失败
+ */
+rt_err_t tof_start(void)
+{
+    if (tof_started) {
+        return -RT_EBUSY;
+    }
+
+    tof_dev = rt_device_find(APP_TOF_DEV_NAME);
+    if (tof_dev == RT_NULL) {
+        rt_kprintf("[ToF] Device %s not found!\n", APP_TOF_DEV_NAME);
+        return -RT_ERROR;
+    }
+
+    rt_sem_init(&ready_sem, "tof_rdy", 0, RT_IPC_FLAG_PRIO);
+
+    /* 软件包按轮询模式打开, 连续测距和数据就绪中断由本文件直接配置 */
+    if (rt_device_open(tof_dev, RT_DEVICE_FLAG_RDONLY) != RT_EOK) {
+        rt_kprintf("[ToF] Failed to open %s!\n", APP_TOF_DEV_NAME);
+        rt_sem_detach(&ready_sem);
+        return -RT_ERROR;
+    }
+
+#if APP_TOF_INT_PIN >= 0
+    if (tof_irq_start() == RT_EOK) {
+        tof_stat.irq_mode = RT_TRUE;
+    } else {
+        rt_kprintf("[ToF] Interrupt mode unavailable, falling back to polling.\n");
+    }
+#endif
+
+    if (rt_thread_init(&tof_thread, "ToFAcq", tof_thread_entry, RT_NULL,
+                       tof_thread_stack, sizeof(tof_thread_stack),
+                       APP_TOF_THREAD_PRIORITY, 10) != RT_EOK) {
+        rt_kprintf("[ToF] Failed to init acquisition thread.\n");
+#if APP_TOF_INT_PIN >= 0
+        if (tof_stat.irq_mode) {
+            tof_irq_stop();
+            tof_stat.irq_mode = RT_FALSE;
+        }
+#endif
+        rt_device_close(tof_dev);
+        rt_sem_detach(&ready_sem);
+        return -RT_ERROR;
+    }
+    tof_started = RT_TRUE;
+    rt_thread_startup(&tof_thread);
+
+    rt_kprintf("[ToF] %s acquisition started (%s mode).\n",
+               APP_TOF_DEV_NAME, tof_stat.irq_mode ? "interrupt" : "polling");
+    return RT_EOK;
+}
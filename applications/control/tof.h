@@ -0,0 +1,27 @@
+#ifndef __TOF_H__
+#define __TOF_H__
+
+#include <rtthread.h>
+
+/* 单次测距样本 */
+struct tof_sample
+{
+    rt_uint32_t timestamp;      // 采样时刻 (tick): 中断模式为数据就绪中断的时刻, 轮询模式来自 rt_sensor_data.timestamp
+    rt_int32_t  height;         // 测得的高度 (mm)
+};
+
+struct tof_stats
+{
+    rt_uint32_t samples;        // 采集到的样本总数
+    rt_uint32_t dropped;        // 消费者来不及取走而被覆盖的样本数
+    rt_uint32_t read_errors;    // 读取失败次数
+    rt_uint32_t irq_timeouts;   // 等数据就绪中断超时的次数
+    rt_bool_t   irq_mode;       // RT_TRUE: GPIO1数据就绪中断; RT_FALSE: 线程内连续轮询
+};
+
+rt_err_t tof_start(void);
+rt_bool_t tof_read(struct tof_sample *sample);
+rt_bool_t tof_read_latest(struct tof_sample *sample);
+void tof_get_stats(struct tof_stats *stats);
+
+#endif /* __TOF_H__ */
@@ -37,11 +37,11 @@ int wifi_spi_device_init(void)
     int ret = 0;
     char sn_version[32];
 
-    struct rt_spi_device *spi_device = rt_malloc(sizeof(struct rt_spi_device));
-    if (!spi_device) return -1;
+    /* SPI device object is static, attaching it does not touch the heap */
+    static struct rt_spi_device spi_device;
 
     rw007_gpio_init();
-    ret = rt_spi_bus_attach_device_cspin(spi_device, BOARD_RW007_DEVICE_NAME, BOARD_RW007_SPI_BUS_NAME, BOARD_RW007_CS_PIN, RT_NULL);
+    ret = rt_spi_bus_attach_device_cspin(&spi_device, BOARD_RW007_DEVICE_NAME, BOARD_RW007_SPI_BUS_NAME, BOARD_RW007_CS_PIN, RT_NULL);
     if (ret != RT_EOK) return -2;
 
     rt_hw_wifi_init("rw007");
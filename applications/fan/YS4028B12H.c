@@ -53,8 +53,9 @@ rt_err_t ys4028b12h_set_speed(ys4028b12h_cfg_t cfg, float speed)
     }
     else{
 
-        cfg->pulse = (int)(cfg->period * speed); // 计算脉冲宽度
-        rt_pwm_set(cfg->name, cfg->channel,cfg->period, cfg->pulse);
+        cfg->pulse = (int)(cfg->period * speed + 0.5f); // 计算脉冲宽度
+        /* 周期不变, 只更新占空比, 驱动直接写比较寄存器, 分辨率为一个计数周期 */
+        rt_pwm_set_pulse(cfg->name, cfg->channel, cfg->pulse);
 
         return RT_EOK;
     }
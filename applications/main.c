@@ -1,43 +1,122 @@
 #include <rtthread.h>
 #include <rtdevice.h>
+#include <string.h>
 #include "drv_pin.h"
 #include "YS4028B12H.h"
-#include <stdlib.h> // for atof()
-#include <string.h> // for strcmp()
+#include "control_loop.h"
+#include "tof.h"
+#include "pid.h"
+#include "lut.h"
+#include "autotune.h"
+#include "eval_metrics.h"
+#include "estimator.h"
+#include "telemetry.h"
+#include "ctrl_queue.h"
+#include "cmd.h"
+#ifdef APP_USING_PARAM_STORE
+#include "kvstore.h"
+#endif
+#ifdef APP_SYSMON_HEAP_AUDIT
+#include "sysmon.h"
+#endif
 #include <system_vars.h>
 
 /*******************************************************************************
  * 宏定义
  ******************************************************************************/
 #define LED_PIN        ((3*32)+12)      // 工作指示灯引脚
-#define SAMPLE_DELAY_MS    20           // 控制周期/采样周期 (ms)
-#define RAMP_STEP          0.5f         // 设定值斜坡步长 (mm/cycle)
+#define PID_TUNED_DT       0.02f        // 增益表整定时的控制周期 (s), 其他频率下按实测dt换算
+#define RAMP_RATE          25.0f        // 设定值斜坡速率 (mm/s)
+#define PID_D_TAU          0.02f        // 微分低通滤波时间常数 (s)
 #define MIN_HEIGHT        100.0f        // 最小高度 (mm)
 #define FABS(x) ((x) > 0 ? (x) : -(x))  // 绝对值宏
+#define EST_ALPHA            0.5f       // alpha-beta 位置增益
+#define EST_BETA             0.2f       // alpha-beta 速度增益
+#define EST_ACCEL_NOISE      1000.0f    // 卡尔曼过程噪声, 加速度标准差 (mm/s²)
+#define EST_MEAS_NOISE       5.0f       // 卡尔曼测量噪声标准差 (mm)
+#define EST_GATE_MM          60.0f      // alpha-beta 离群门限 (mm)
+#define EST_GATE_SIGMA       4.0f       // 卡尔曼离群门限 (新息标准差倍数)
+#define EST_MAX_REJECTS      5          // 连续离群这么多次后重新初始化
+#define EST_MAX_COAST        0.2f       // 没有有效样本时最多外推的时间 (s)
+#define EVAL_SETTLE_BAND     10.0f      // 评估的默认误差带 (mm)
+#define AUTOTUNE_AMPLITUDE   0.05f      // 自整定默认继电幅值 (占空比)
+#define AUTOTUNE_HYSTERESIS  5.0f       // 自整定默认滞环 (mm), 大于测距噪声
+#define AUTOTUNE_SETTLE_BAND 10.0f      // 开始继电前的稳定判据 (mm)
+#define AUTOTUNE_SETTLE_MS   2000       // 在稳定带内保持的时间 (ms)
+#define AUTOTUNE_SETTLE_MAX  20000      // 等待稳定的最长时间 (ms), 超时后照常开始
+#define AUTOTUNE_TIMEOUT     90.0f      // 单个断点继电辨识的超时 (s)
+#define AUTOTUNE_EVAL_MS     10000      // 新增益的评估时长 (ms)
+#define AUTOTUNE_RELAY_MARGIN 2000      // 等待继电辨识结束时在超时之外多等的时间 (ms)
+#define AUTOTUNE_ABORT_GRACE 500        // 中止后等待控制线程结束辨识的时间 (ms)
+#define AUTOTUNE_REQ_RETRIES 10         // 控制请求队列满时的重试次数, 每次间隔一个控制周期
+#define PARAM_KEY_GAINS    "gains"      // 参数存储中增益调度表的键
+#define PARAM_KEY_FF       "ff"         // 参数存储中前馈表的键
+
+#if defined(APP_HEIGHT_ESTIMATOR_ALPHA_BETA) || defined(APP_HEIGHT_ESTIMATOR_KALMAN)
+#define HEIGHT_USING_ESTIMATOR
+#endif
 
 /*******************************************************************************
  * 全局变量
  ******************************************************************************/
-rt_thread_t working_indicate = RT_NULL;
-rt_thread_t screen_thread = RT_NULL;
+/* 应用线程的控制块和栈都静态分配, 不从堆上取内存 */
+static struct rt_thread working_indicate;
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t working_indicate_stack[256];
+static struct rt_thread screen_thread;
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t screen_thread_stack[1280];
+static ys4028b12h_cfg_t fan_cfg = RT_NULL;
+static pid_controller_t height_pid;
+static lut_t gain_lut;      // 增益调度表的插值段, 输出 {Kp, Ki, Kd}
+static lut_t ff_lut;        // 前馈速度表的插值段
 
 /* PID 控制器参数 */
-int32_t current_height = 20;  // 当前高度 (mm)
+static int32_t current_height = 20;  // 当前高度 (mm), 仅控制线程读写
 float target_height = 250.0f; // 用户设定的最终目标高度 (mm)
-float ramped_height = 250.0f; // PID控制器当前正在追踪的、平滑变化的目标高度
+static float ramped_height = 250.0f; // PID控制器当前正在追踪的、平滑变化的目标高度
 
 float KP = 0.0f;
 float KI = 0.0f;
 float KD = 0.0f;
 
-/* PID 控制器状态变量 */
-float integral_error = 0.0f;
-float previous_error = 0.0f;
+/* PID 控制器状态变量, 仅控制线程读写, 其他线程通过 telemetry_read() 获取 */
+static float integral_error = 0.0f;
+static float previous_error = 0.0f;
+static float ff_speed = 0.0f;
+static float fan_speed = 0.0f;
+
+/* 高度估计, 仅控制线程读写 */
+#ifdef HEIGHT_USING_ESTIMATOR
+static estimator_t height_est;
+static rt_tick_t est_tick;          // 估计器状态对应的时刻 (最近一个样本的时间戳)
+#endif
+static float est_height = 0.0f;     // PID使用的高度 (mm)
+static float est_velocity = 0.0f;   // PID微分项使用的速度 (mm/s), 未启用估计器时为0
+
+/*
+ * PID 控制参数评估, 完全在控制线程内进行, 命令线程只发请求、取结果
+ * 请求在控制周期开始时处理, 时长到了或收到停止请求时控制线程把结果写入 eval_result
+ * 并把 eval_done 加一; 其他线程锁调度器拷贝 eval_result, 控制线程不会写到一半
+ */
+rt_bool_t is_evaluating = RT_FALSE;                 // 只由控制线程写
+static float total_abs_error = 0.0f;                // IAE 按整定周期归一化, 即 EVAL_RESULT
+static eval_metrics_t eval_metrics;
+static float eval_duration;                         // 本次评估时长 (s)
+static float eval_elapsed;                          // 本次评估已进行的时间 (s), 没有新样本的周期也计入
+static eval_result_t eval_result;                   // 最近一次完成的评估结果
+static volatile rt_uint32_t eval_done = 0;          // 已完成的评估次数
+static volatile rt_uint32_t eval_request_ms = 0;    // 非零: 请求开始一次评估
+static volatile float eval_request_band = EVAL_SETTLE_BAND;
+static volatile rt_bool_t eval_stop = RT_FALSE;     // 请求提前结束当前评估
 
-/* PID 控制参数评估 */
-// static void pid_tune(int argc, char **argv);
-rt_bool_t is_evaluating = RT_FALSE;
-float total_abs_error = 0.0f;
+/* 继电自整定, autotune_active 为真时控制线程用继电输出代替PID */
+static autotune_t autotuner;
+static volatile rt_bool_t autotune_active = RT_FALSE;   // 只由控制线程写
+static volatile rt_uint32_t autotune_runs = 0;          // 控制线程每结束一次继电辨识加一
+static autotune_config_t autotune_request_cfg;          // 随 CTRL_REQ_AUTOTUNE 请求一起交给控制线程
+static volatile rt_bool_t autotune_abort = RT_FALSE;
+static volatile rt_bool_t autotune_busy = RT_FALSE;     // 整定线程在运行, 线程对象回收后才清除
+static struct rt_thread autotune_thread;
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t autotune_thread_stack[1536];
 typedef struct {
     float height;
     float kp;
@@ -45,8 +124,9 @@ typedef struct {
     float kd;
 } pid_profile_t;
 
-/* --- PID增益调度表 --- PS：每个高度点只运行了30s,60个迭代的贝叶斯算法，还可以再优化优化 */
-const pid_profile_t gain_schedule_table[] = {
+/* --- PID增益调度表 --- PS：每个高度点只运行了30s,60个迭代的贝叶斯算法，还可以再优化优化
+ * 这里是出厂默认值, 参数存储中有保存的表时启动时会被覆盖 */
+pid_profile_t gain_schedule_table[] = {
     // {高度, Kp, Ki, Kd}
     {50.0f, 0.03042419f, 0.00000174f, 0.00651698f}, // Best Score: 2148.0
     {100.0f, 0.00199807f, 0.00028206f, 0.01910421f}, // Best Score: 2012.0
@@ -78,6 +158,19 @@ feedforward_profile_t ff_table[] = {
 };
 const int num_ff_profiles = sizeof(ff_table) / sizeof(ff_table[0]);
 
+/*
+ * 命令线程 (FinSH/远程服务器/自整定线程) 对控制参数的修改都投递到请求队列,
+ * 由控制线程在每个周期开始时执行, 控制线程从不等待锁, 也不会被命令线程锁调度器
+ */
+enum
+{
+    CTRL_REQ_TARGET,        // value[0]: 目标高度 (mm)
+    CTRL_REQ_GAINS,         // 手动覆盖 Kp/Ki/Kd, index 第0/1/2位表示 value[0/1/2] 有效
+    CTRL_REQ_GAIN_POINT,    // 增益调度表第 index 个断点的 {Kp, Ki, Kd}, 高度不变
+    CTRL_REQ_FF_POINT,      // 前馈表第 index 个断点, value[0]: 高度 (mm), value[1]: 占空比
+    CTRL_REQ_AUTOTUNE,      // 在 value[0] 高度开始继电辨识, 配置在 autotune_request_cfg
+};
+
 /*******************************************************************************
  * 函数
  ******************************************************************************/
@@ -94,49 +187,359 @@ void working_led() {
     }
 }
 
-void update_pid_gains_by_target(float current_target)
+#ifdef APP_USING_PARAM_STORE
+/* 表中各行的高度 (每行第一个成员) 必须严格递增 */
+static rt_bool_t profile_heights_increasing(const void *table, rt_size_t stride, int n)
+{
+    const rt_uint8_t *row = table;
+    for (int i = 1; i < n; i++, row += stride) {
+        if (*(const float *)(row + stride) <= *(const float *)row) return RT_FALSE;
+    }
+    return RT_TRUE;
+}
+
+/**
+ * @brief 从参数存储加载增益调度表和前馈表
+ * 保存的表行数与编译进来的表不同 (表结构改过) 或高度不递增时忽略, 使用默认表
+ */
+static void params_load(void)
+{
+    pid_profile_t gains[sizeof(gain_schedule_table) / sizeof(gain_schedule_table[0])];
+    feedforward_profile_t ff[sizeof(ff_table) / sizeof(ff_table[0])];
+    rt_size_t len;
+
+    if (kv_init(APP_PARAM_STORE_DEV_NAME) != RT_EOK) {
+        rt_kprintf("Warning: Parameter store unavailable, using built-in tables.\n");
+        return;
+    }
+    if (kv_get(PARAM_KEY_GAINS, gains, sizeof(gains), &len) == RT_EOK && len == sizeof(gains) &&
+        profile_heights_increasing(gains, sizeof(gains[0]), num_pid_profiles)) {
+        memcpy(gain_schedule_table, gains, sizeof(gains));
+        rt_kprintf("Gain schedule loaded from parameter store.\n");
+    }
+    if (kv_get(PARAM_KEY_FF, ff, sizeof(ff), &len) == RT_EOK && len == sizeof(ff) &&
+        profile_heights_increasing(ff, sizeof(ff[0]), num_ff_profiles)) {
+        memcpy(ff_table, ff, sizeof(ff));
+        rt_kprintf("Feedforward table loaded from parameter store.\n");
+    }
+}
+
+/**
+ * @brief 把当前的增益调度表和前馈表写入参数存储
+ * 先锁调度器拷贝一份 (只有两张小表的拷贝时间), 写Flash期间表可以继续被修改
+ */
+static rt_err_t params_save(void)
 {
-    int lower_index = -1, upper_index = -1;
+    pid_profile_t gains[sizeof(gain_schedule_table) / sizeof(gain_schedule_table[0])];
+    feedforward_profile_t ff[sizeof(ff_table) / sizeof(ff_table[0])];
+    struct telemetry t;
+
+    /* 已投递的修改最迟在再下一个控制周期开始时执行, 等它执行完再拷贝; 控制环没有运行时最多等4个周期 */
+    telemetry_read(&t);
+    rt_uint32_t seq = t.seq;
+    for (int n = 0; n < 4 * 1000 / CONTROL_LOOP_RATE_HZ; n++) {
+        telemetry_read(&t);
+        if (t.seq - seq >= 2) break;
+        rt_thread_mdelay(1);
+    }
+
+    rt_enter_critical();
+    memcpy(gains, gain_schedule_table, sizeof(gains));
+    memcpy(ff, ff_table, sizeof(ff));
+    rt_exit_critical();
+
+    rt_err_t ret = kv_set(PARAM_KEY_GAINS, gains, sizeof(gains));
+    if (ret == RT_EOK) {
+        ret = kv_set(PARAM_KEY_FF, ff, sizeof(ff));
+    }
+    return ret;
+}
+
+/**
+ * @brief Flash擦写前的等待钩子: 等控制线程发布完下一个周期再返回
+ * 擦写期间从Flash取指会停顿, 这样停顿落在两个控制周期之间的空闲时间里
+ * 控制环没有运行时最多等两个周期
+ */
+static void params_flash_gate(void)
+{
+    struct telemetry t;
+
+    telemetry_read(&t);
+    rt_uint32_t seq = t.seq;
+    for (int n = 0; n < 2 * 1000 / CONTROL_LOOP_RATE_HZ; n++) {
+        rt_thread_mdelay(1);
+        telemetry_read(&t);
+        if (t.seq != seq) return;
+    }
+}
+#endif /* APP_USING_PARAM_STORE */
+
+/**
+ * @brief 由增益调度表和前馈表生成插值查找表, 两张表的高度都必须严格递增
+ * @return RT_EOK 成功, -RT_ERROR 表格式错误
+ */
+static rt_err_t schedule_tables_init(void)
+{
+    float x[LUT_MAX_POINTS];
+    float y[LUT_MAX_POINTS * LUT_MAX_CHANNELS];
+
+    if (num_pid_profiles > LUT_MAX_POINTS || num_ff_profiles > LUT_MAX_POINTS) {
+        return -RT_ERROR;
+    }
+
     for (int i = 0; i < num_pid_profiles; i++) {
-        if (gain_schedule_table[i].height <= current_target) lower_index = i;
-        if (gain_schedule_table[i].height >= current_target && upper_index == -1) upper_index = i;
+        x[i] = gain_schedule_table[i].height;
+        y[i * 3 + 0] = gain_schedule_table[i].kp;
+        y[i * 3 + 1] = gain_schedule_table[i].ki;
+        y[i * 3 + 2] = gain_schedule_table[i].kd;
+    }
+    if (lut_init(&gain_lut, x, y, num_pid_profiles, 3) != 0) {
+        return -RT_ERROR;
     }
 
-    if (lower_index == -1) { // 低于范围
-        KP = gain_schedule_table[0].kp; KI = gain_schedule_table[0].ki; KD = gain_schedule_table[0].kd;
-    } else if (upper_index == -1 || lower_index == upper_index) { // 高于范围或精确匹配
-        KP = gain_schedule_table[lower_index].kp; KI = gain_schedule_table[lower_index].ki; KD = gain_schedule_table[lower_index].kd;
-    } else { // 插值
-        const pid_profile_t* p_lower = &gain_schedule_table[lower_index];
-        const pid_profile_t* p_upper = &gain_schedule_table[upper_index];
-        float ratio = (current_target - p_lower->height) / (p_upper->height - p_lower->height);
-        KP = p_lower->kp + ratio * (p_upper->kp - p_lower->kp);
-        KI = p_lower->ki + ratio * (p_upper->ki - p_lower->ki);
-        KD = p_lower->kd + ratio * (p_upper->kd - p_lower->kd);
+    for (int i = 0; i < num_ff_profiles; i++) {
+        x[i] = ff_table[i].height;
+        y[i] = ff_table[i].base_fan_speed;
     }
+    if (lut_init(&ff_lut, x, y, num_ff_profiles, 1) != 0) {
+        return -RT_ERROR;
+    }
+    return RT_EOK;
+}
+
+void update_pid_gains_by_target(float current_target)
+{
+    float gains[3];
+    lut_eval(&gain_lut, current_target, gains);
+    KP = gains[0]; KI = gains[1]; KD = gains[2];
 }
 
 float get_feedforward_speed(float target_height)
 {
-    int lower_index = -1, upper_index = -1;
-    for (int i = 0; i < num_ff_profiles; i++) {
-        if (ff_table[i].height <= target_height) lower_index = i;
-        if (ff_table[i].height >= target_height && upper_index == -1) upper_index = i;
+    return lut_eval1(&ff_lut, target_height);
+}
+
+#ifdef HEIGHT_USING_ESTIMATOR
+/**
+ * @brief 把所有未读样本按时间戳依次送入估计器, 再外推到当前时刻
+ * 超量程读数和离群值不参与校正, 估计器照常预测, 控制周期不受影响
+ * @return RT_TRUE 估计有效; RT_FALSE 还没有样本或太久没有有效样本
+ */
+static rt_bool_t height_estimate(float *height, float *rate)
+{
+    struct tof_sample sample;
+
+    while (tof_read(&sample)) {
+        /* tick 差值转成有符号数, 计数回绕后仍正确 */
+        estimator_predict(&height_est, (rt_int32_t)(sample.timestamp - est_tick) / (float)RT_TICK_PER_SECOND);
+        est_tick = sample.timestamp;
+        if (sample.height > 8000) {
+            estimator_reject(&height_est);  // VL53L0X 超量程时返回 8190/8191
+            continue;
+        }
+        current_height = sample.height;
+        estimator_update(&height_est, (float)sample.height);
     }
+    float ahead = (rt_int32_t)(rt_tick_get() - est_tick) / (float)RT_TICK_PER_SECOND;
+    return estimator_output(&height_est, ahead, height, rate) != 0;
+}
+#endif
+
+/**
+ * @brief 高度控制: 读取高度, 斜坡, PID + 前馈, 输出到风扇
+ * @param dt 距上一周期的实测时间 (s)
+ */
+static void height_control(float dt)
+{
+    static float pid_dt = 0.0f; // 距上一次PID更新的时间, 没有新样本的周期会累加
 
-    if (lower_index == -1) {
-        return ff_table[0].base_fan_speed;
-    } else if (upper_index == -1 || lower_index == upper_index) {
-        return ff_table[lower_index].base_fan_speed;
+    /* --- 设定值斜坡 --- PS：这里会有半个步长的误差，懒得调了 */
+    float ramp_step = RAMP_RATE * dt;
+    if (FABS(ramped_height - target_height) > ramp_step) {
+        if (ramped_height < target_height) ramped_height += ramp_step;
+        else ramped_height -= ramp_step;
+        update_pid_gains_by_target(ramped_height);
     } else {
-        const feedforward_profile_t* p_lower = &ff_table[lower_index];
-        const feedforward_profile_t* p_upper = &ff_table[upper_index];
-        if (p_upper->height == p_lower->height) return p_lower->base_fan_speed;
-        float ratio = (target_height - p_lower->height) / (p_upper->height - p_lower->height);
-        return p_lower->base_fan_speed + ratio * (p_upper->base_fan_speed - p_lower->base_fan_speed);
+        ramped_height = target_height;
+    }
+    ff_speed = get_feedforward_speed(ramped_height);
+
+    pid_dt += dt;
+#ifdef HEIGHT_USING_ESTIMATOR
+    /* 估计器每个周期给出当前时刻的高度和速度, PID每周期更新; 太久没有有效样本时风扇保持输出 */
+    float height, rate;
+    if (!height_estimate(&height, &rate)) return;
+    dt = pid_dt;
+    pid_dt = 0.0f;
+#else
+    /* 只在有新测距样本时更新PID, 否则风扇保持上一周期的输出 */
+    struct tof_sample sample;
+    if (!tof_read_latest(&sample)) return;
+    dt = pid_dt;
+    pid_dt = 0.0f;
+    current_height = sample.height;
+    if (current_height > 8000) { rt_kprintf("Warning: Height exceeds 8000\n"); return; }
+    float height = (float)current_height;
+#endif
+    est_height = height;
+#ifdef HEIGHT_USING_ESTIMATOR
+    est_velocity = rate;
+#endif
+
+    /* --- 自整定期间由继电控制器直接给出输出, 结束或中止后下一个样本恢复PID --- */
+    if (autotune_active) {
+        if (autotune_abort || autotune_update(&autotuner, height, dt, &fan_speed) != AUTOTUNE_RUNNING) {
+            autotune_active = RT_FALSE;
+            autotune_runs++;
+        }
+        ys4028b12h_set_speed(fan_cfg, fan_speed);
+        return;
+    }
+
+    /* --- PID 控制器核心计算 --- 增益调度和手动调参都只改全局KP/KI/KD，这里同步给控制器 */
+    if (KP != height_pid.cfg.kp || KI != height_pid.cfg.ki || KD != height_pid.cfg.kd) {
+        pid_set_gains(&height_pid, KP, KI, KD);
+    }
+    float error = ramped_height - height;
+
+    /* --- 前馈与PID输出合并, 限幅与条件积分抗饱和在控制器内完成 --- */
+#ifdef HEIGHT_USING_ESTIMATOR
+    /* 微分项直接用估计的速度, 不再差分量化后的原始读数 */
+    fan_speed = pid_update_rate(&height_pid, ramped_height, height, rate, ff_speed, dt);
+#else
+    fan_speed = pid_update(&height_pid, ramped_height, height, ff_speed, dt);
+#endif
+    integral_error = pid_get_integral(&height_pid);
+    previous_error = error;
+
+    ys4028b12h_set_speed(fan_cfg, fan_speed);
+
+    if (is_evaluating) {
+        eval_metrics_update(&eval_metrics, ramped_height, (float)current_height, fan_speed,
+                            height_pid.terms.saturated, dt);
+        total_abs_error = eval_metrics.r.iae / PID_TUNED_DT;
     }
 }
 
+/**
+ * @brief 处理评估的开始/结束, 每个控制周期在高度控制之前调用
+ * @param dt 距上一周期的实测时间 (s)
+ */
+static void eval_step(float dt)
+{
+    rt_uint32_t request = eval_request_ms;
+
+    /* 新的评估从清零的PID状态开始, 各次评估之间可以比较 */
+    if (request != 0) {
+        pid_reset(&height_pid);
+        integral_error = 0;
+        previous_error = 0;
+        total_abs_error = 0;
+        eval_metrics_start(&eval_metrics, ramped_height, (float)current_height, fan_speed, eval_request_band);
+        eval_duration = request / 1000.0f;
+        eval_elapsed = 0.0f;
+        eval_stop = RT_FALSE;
+        eval_request_ms = 0;
+        is_evaluating = RT_TRUE;
+        return;
+    }
+
+    if (!is_evaluating) return;
+    eval_elapsed += dt;
+    if (eval_stop || eval_elapsed >= eval_duration) {
+        eval_metrics_result(&eval_metrics, &eval_result);
+        is_evaluating = RT_FALSE;
+        eval_done++;
+    }
+}
+
+/**
+ * @brief 把控制线程持有的状态打包成快照发布, 供OLED/远程/命令行读取
+ */
+static void publish_telemetry(void)
+{
+    static rt_uint32_t seq = 0;
+    struct telemetry t;
+
+    t.seq = ++seq;
+    t.tick = rt_tick_get();
+    t.current_height = current_height;
+    t.target_height = target_height;
+    t.ramped_height = ramped_height;
+    t.est_height = est_height;
+    t.est_velocity = est_velocity;
+    t.kp = KP;
+    t.ki = KI;
+    t.kd = KD;
+    t.integral_error = integral_error;
+    t.previous_error = previous_error;
+    t.feedforward_speed = ff_speed;
+    t.pid_p = height_pid.terms.p;
+    t.pid_i = height_pid.terms.i;
+    t.pid_d = height_pid.terms.d;
+    t.fan_speed = fan_speed;
+    t.is_evaluating = is_evaluating;
+    t.total_abs_error = total_abs_error;
+    telemetry_publish(&t);
+}
+
+/**
+ * @brief 执行命令线程投递的全部请求, 每个控制周期在高度控制之前调用
+ * 请求在投递前已检查过范围, 这里只做与控制状态相关的检查
+ */
+static void control_requests(void)
+{
+    struct ctrl_msg msg;
+
+    while (ctrl_queue_fetch(&msg))
+    {
+        switch (msg.type)
+        {
+        case CTRL_REQ_TARGET:
+            target_height = msg.value[0];
+            break;
+        case CTRL_REQ_GAINS:
+            if (msg.index & 0x01) KP = msg.value[0];
+            if (msg.index & 0x02) KI = msg.value[1];
+            if (msg.index & 0x04) KD = msg.value[2];
+            break;
+        case CTRL_REQ_GAIN_POINT: {
+            pid_profile_t *entry = &gain_schedule_table[msg.index];
+            lut_set_point(&gain_lut, msg.index, entry->height, msg.value);
+            entry->kp = msg.value[0];
+            entry->ki = msg.value[1];
+            entry->kd = msg.value[2];
+            update_pid_gains_by_target(ramped_height);
+            break;
+        }
+        case CTRL_REQ_FF_POINT:
+            /* 与相邻断点的顺序在投递时检查过, 期间表被其他请求改过时这里仍会拒绝 */
+            if (lut_set_point(&ff_lut, msg.index, msg.value[0], &msg.value[1]) == 0) {
+                ff_table[msg.index].height = msg.value[0];
+                ff_table[msg.index].base_fan_speed = msg.value[1];
+            }
+            break;
+        case CTRL_REQ_AUTOTUNE:
+            autotune_start(&autotuner, &autotune_request_cfg, msg.value[0]);
+            autotune_active = RT_TRUE;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 单个控制周期: 执行请求和高度控制, 然后发布本周期的状态快照
+ * @param dt 距上一周期的实测时间 (s)
+ */
+static void control_step(float dt)
+{
+    control_requests();
+    eval_step(dt);
+    height_control(dt);
+    publish_telemetry();
+}
 
 int main(void)
 {
@@ -153,188 +556,822 @@ int main(void)
     rt_kprintf("MCXA156 Ball Suspension Demo\r\n");
 
     /* 启动工作指示灯线程 */
-    working_indicate = rt_thread_create("WorkingIndicate", working_led, RT_NULL, 256, 11, 20);
-    screen_thread = rt_thread_create("ScreenUpdate", screen_on, RT_NULL, 1280, 11, 20);
-    if (working_indicate != RT_NULL && screen_thread != RT_NULL) {
-        rt_thread_startup(working_indicate);
-        rt_thread_startup(screen_thread);
+    if (rt_thread_init(&working_indicate, "WorkingIndicate", working_led, RT_NULL,
+                       working_indicate_stack, sizeof(working_indicate_stack), 11, 20) == RT_EOK &&
+        rt_thread_init(&screen_thread, "ScreenUpdate", screen_on, RT_NULL,
+                       screen_thread_stack, sizeof(screen_thread_stack), 11, 20) == RT_EOK) {
+        rt_thread_startup(&working_indicate);
+        rt_thread_startup(&screen_thread);
     } else {
         rt_kprintf("Failed to create working indicate thread.\n");
     }
 
     /* 初始化风扇 */
-    ys4028b12h_cfg_t cfg = &my_ys4028b12h_config;
-    if (cfg->name == RT_NULL) {
-        ys4028b12h_init(cfg);
+    fan_cfg = &my_ys4028b12h_config;
+    if (fan_cfg->name == RT_NULL) {
+        ys4028b12h_init(fan_cfg);
     }
-    ys4028b12h_set_speed(cfg, 0.0f);
+    ys4028b12h_set_speed(fan_cfg, 0.0f);
     rt_kprintf("Fan initialized.\n");
 
-    /* 初始化VL53L0X ToF传感器 */
-    rt_device_t tof_dev = rt_device_find("tof_vl53l0x");
-    if (tof_dev == RT_NULL) { 
-        rt_kprintf("Error: VL53L0X device not found!\n");
-        return -1; 
-    }
-    if (rt_device_open(tof_dev, RT_DEVICE_FLAG_RDONLY) != RT_EOK) {
-        rt_kprintf("Error: Failed to open VL53L0X device!\n");
+    /* 初始化VL53L0X ToF传感器, 由采集线程连续测距 */
+    if (tof_start() != RT_EOK) {
+        rt_kprintf("Error: Failed to start VL53L0X acquisition!\n");
         return -1;
     }
-
-    rt_kprintf("VL53L0X device opened.\n");
     
+#ifdef APP_USING_PARAM_STORE
+    params_load();
+#endif
     rt_kprintf("Initializing PID and Feedforward for default target: %.1f mm\n", target_height);
+    if (schedule_tables_init() != RT_EOK) {
+        rt_kprintf("Error: Gain schedule / feedforward table heights must be strictly increasing!\n");
+        return -1;
+    }
     update_pid_gains_by_target(ramped_height);
-    pid_tune(1, RT_NULL);
+    pid_config_t pid_cfg = {
+#ifdef APP_PID_USING_Q31
+        .backend = PID_BACKEND_Q31,
+#else
+        .backend = PID_BACKEND_F32,
+#endif
+        .kp = KP, .ki = KI, .kd = KD,
+        .ts = PID_TUNED_DT,
+        .d_tau = PID_D_TAU,
+        .out_min = 0.0f, .out_max = 1.0f,
+    };
+    pid_init(&height_pid, &pid_cfg);
+#ifdef HEIGHT_USING_ESTIMATOR
+    estimator_config_t est_cfg = {
+#ifdef APP_HEIGHT_ESTIMATOR_KALMAN
+        .type = ESTIMATOR_KALMAN,
+        .gate = EST_GATE_SIGMA,
+#else
+        .type = ESTIMATOR_ALPHA_BETA,
+        .gate = EST_GATE_MM,
+#endif
+        .alpha = EST_ALPHA, .beta = EST_BETA,
+        .accel_noise = EST_ACCEL_NOISE, .meas_noise = EST_MEAS_NOISE,
+        .max_rejects = EST_MAX_REJECTS,
+        .max_coast = EST_MAX_COAST,
+    };
+    estimator_init(&height_est, &est_cfg);
+#endif
+    ff_speed = get_feedforward_speed(ramped_height);
+    publish_telemetry();    // 控制线程启动前先发布初始状态
+    char *status_argv[] = { "pid_tune" };
+    cmd_console(1, status_argv);
 
-    /* 主控制循环 */
-    while (1)
-    {
-        struct rt_sensor_data sensor_data;
-        rt_size_t res = rt_device_read(tof_dev, 0, &sensor_data, 1);
-        if (res != 1) { rt_kprintf("Error: Failed to read sensor data!\n"); continue; }
-        current_height = sensor_data.data.proximity;
-        if (current_height > 8000) { rt_kprintf("Warning: Height exceeds 8000\n"); continue; }
-
-        /* --- 设定值斜坡 --- PS：这里会有0.5的误差，懒得调了 */
-        if (FABS(ramped_height - target_height) > RAMP_STEP) {
-            if (ramped_height < target_height) ramped_height += RAMP_STEP;
-            else ramped_height -= RAMP_STEP;
-            update_pid_gains_by_target(ramped_height);
-        } else {
-            ramped_height = target_height;
+    if (control_loop_start(control_step) != RT_EOK) {
+        rt_kprintf("Error: Failed to start control loop!\n");
+        return -1;
+    }
+#ifdef APP_USING_PARAM_STORE
+    kv_set_flash_gate(params_flash_gate);
+#endif
+#ifdef APP_SYSMON_HEAP_AUDIT
+    sysmon_heap_mark();     // 此后的堆分配都会出现在 heap 命令的计数里
+#endif
+
+    return 0;
+}
+
+/*******************************************************************************
+ * 评测用
+ ******************************************************************************/
+
+/**
+ * @brief 投递一个控制请求, 下一个控制周期生效
+ * @return RT_EOK 成功; -RT_EFULL 队列已满 (控制线程没有在运行或命令来得太快)
+ */
+static rt_err_t control_request(rt_uint16_t type, int index, float v0, float v1, float v2)
+{
+    struct ctrl_msg msg = { type, (rt_int16_t)index, { v0, v1, v2 } };
+    return ctrl_queue_post(&msg);
+}
+
+/**
+ * @brief 修改增益调度表的一个断点 (高度不变), 控制线程只重算相邻两段, 并按当前斜坡目标更新增益
+ */
+static rt_err_t gain_schedule_set(int index, const float gains[3])
+{
+    return control_request(CTRL_REQ_GAIN_POINT, index, gains[0], gains[1], gains[2]);
+}
+
+/* 前馈表断点的高度必须在相邻两个断点之间 */
+static rt_bool_t ff_point_valid(int index, float height)
+{
+    if (index > 0 && !(height > ff_table[index - 1].height)) return RT_FALSE;
+    if (index + 1 < num_ff_profiles && !(height < ff_table[index + 1].height)) return RT_FALSE;
+    return RT_TRUE;
+}
+
+enum
+{
+    PID_TUNE_TARGET,
+    PID_TUNE_KP,
+    PID_TUNE_KI,
+    PID_TUNE_KD,
+    PID_TUNE_FF,
+    PID_TUNE_FF_SET,
+    PID_TUNE_GAIN_SET,
+    PID_TUNE_SAVE,
+};
+
+static const struct cmd_option pid_tune_options[] =
+{
+    [PID_TUNE_TARGET] = { "-t", "f" },
+    [PID_TUNE_KP]     = { "-p", "f" },
+    [PID_TUNE_KI]     = { "-i", "f" },
+    [PID_TUNE_KD]     = { "-d", "f" },
+    [PID_TUNE_FF]     = { "-ff", "" },
+    [PID_TUNE_FF_SET] = { "-ff_set", "iff" },
+    [PID_TUNE_GAIN_SET] = { "-gain_set", "i" },
+    [PID_TUNE_SAVE]   = { "-save", "" },
+    { RT_NULL, RT_NULL },
+};
+
+static rt_err_t pid_tune_cmd(const struct cmd_args *args, struct cmd_reply *reply)
+{
+    if (args->present == 0) {
+        struct telemetry t;
+        telemetry_read(&t);
+        cmd_printf(reply, "--- PID & Feedforward Status ---\n");
+        cmd_printf(reply, "  Final Target: %.2f mm, Ramped Target: %.2f mm\n", target_height, t.ramped_height);
+        cmd_printf(reply, "  Kp: %f, Ki: %f, Kd: %f\n", KP, KI, KD);
+        cmd_printf(reply, "\n--- Usage ---\n");
+        cmd_printf(reply, "  pid_tune -t <val>                    (Set target height)\n");
+        cmd_printf(reply, "  pid_tune -p <val> -i <val> -d <val>  (Manual PID override)\n");
+        cmd_printf(reply, "  pid_tune -ff                         (Show Feedforward table)\n");
+        cmd_printf(reply, "  pid_tune -ff_set <idx> <h> <spd>     (Set Feedforward entry)\n");
+        cmd_printf(reply, "    e.g., pid_tune -ff_set 2 100.0 0.45\n");
+        cmd_printf(reply, "  pid_tune -gain_set <idx> [-p ..] [-i ..] [-d ..]  (Set Gain schedule entry)\n");
+        cmd_printf(reply, "  pid_tune -save                       (Save tables to flash)\n");
+#ifdef APP_USING_PARAM_STORE
+        struct kv_stats kv;
+        kv_get_stats(&kv);
+        cmd_printf(reply, "\nParameter store: seq %d, %d/%d bytes used, %d keys\n",
+                   kv.seq, kv.used, kv.sector_size, kv.keys);
+#endif
+        return RT_EOK;
+    }
+
+    if (cmd_has(args, PID_TUNE_FF)) {
+        cmd_printf(reply, "--- Feedforward Table ---\n");
+        cmd_printf(reply, "Idx | Height (mm) | Base Speed\n");
+        cmd_printf(reply, "----|-------------|-----------\n");
+        for (int i = 0; i < num_ff_profiles; i++) {
+            cmd_printf(reply, "%-3d | %-11.1f | %.4f\n", i, ff_table[i].height, ff_table[i].base_fan_speed);
         }
+    }
 
-        /* --- PID 控制器核心计算 --- */
-        float error = ramped_height - (float)current_height;
-        if (is_evaluating) { total_abs_error += FABS(error); }
+    if (cmd_has(args, PID_TUNE_FF_SET)) {
+        int index = args->opt[PID_TUNE_FF_SET][0].i;
+        float height = args->opt[PID_TUNE_FF_SET][1].f;
+        float speed = args->opt[PID_TUNE_FF_SET][2].f;
+        if (index < 0 || index >= num_ff_profiles) {
+            cmd_printf(reply, "Error: Index %d is out of bounds (0-%d).\n", index, num_ff_profiles - 1);
+            return -RT_EINVAL;
+        }
+        if (!ff_point_valid(index, height)) {
+            cmd_printf(reply, "Error: Height %.1f must lie between the neighbouring entries.\n", height);
+            return -RT_EINVAL;
+        }
+        /* 控制线程只重算该断点相邻的两段 */
+        if (control_request(CTRL_REQ_FF_POINT, index, height, speed, 0.0f) != RT_EOK) {
+            cmd_printf(reply, "Error: Control request queue is full.\n");
+            return -RT_EBUSY;
+        }
+        cmd_printf(reply, "Feedforward table entry %d updated to: Height=%.1f, Speed=%.4f\n",
+                   index, height, speed);
+    }
 
-        integral_error += error;
-        float derivative_error = error - previous_error;
-        if (previous_error == 9999) derivative_error = 0;
-        float pid_output = (KP * error) + (KI * integral_error) + (KD * derivative_error);
-        previous_error = error;
+    if (cmd_has(args, PID_TUNE_GAIN_SET)) {
+        /* -p/-i/-d 改的是该断点的增益, 没给出的保持原值; 断点高度不变 */
+        int index = args->opt[PID_TUNE_GAIN_SET][0].i;
+        if (index < 0 || index >= num_pid_profiles) {
+            cmd_printf(reply, "Error: Index %d is out of bounds (0-%d).\n", index, num_pid_profiles - 1);
+            return -RT_EINVAL;
+        }
+        pid_profile_t *entry = &gain_schedule_table[index];
+        float gains[3] = {
+            cmd_has(args, PID_TUNE_KP) ? args->opt[PID_TUNE_KP][0].f : entry->kp,
+            cmd_has(args, PID_TUNE_KI) ? args->opt[PID_TUNE_KI][0].f : entry->ki,
+            cmd_has(args, PID_TUNE_KD) ? args->opt[PID_TUNE_KD][0].f : entry->kd,
+        };
+        if (gain_schedule_set(index, gains) != RT_EOK) {
+            cmd_printf(reply, "Error: Control request queue is full.\n");
+            return -RT_EBUSY;
+        }
+        cmd_printf(reply, "Gain schedule entry %d updated to: Height=%.1f, Kp=%f, Ki=%f, Kd=%f\n",
+                   index, entry->height, gains[0], gains[1], gains[2]);
+    }
 
-        /* --- 前馈与PID输出合并 --- */
-        float ff_speed = get_feedforward_speed(ramped_height);
-        float final_fan_speed = ff_speed + pid_output;
+    /* 回复中的值是请求的值, 控制线程在下一个周期应用 */
+    float target = target_height;
+    float gains[3] = { KP, KI, KD };
+    int gain_mask = 0;
+    if (!cmd_has(args, PID_TUNE_GAIN_SET)) {
+        for (int k = 0; k < 3; k++) {
+            if (cmd_has(args, PID_TUNE_KP + k)) {
+                gains[k] = args->opt[PID_TUNE_KP + k][0].f;
+                gain_mask |= 1 << k;
+            }
+        }
+    }
+    if (cmd_has(args, PID_TUNE_TARGET)) {
+        target = args->opt[PID_TUNE_TARGET][0].f;
+        if (target < MIN_HEIGHT) {
+            cmd_printf(reply, "Warning: Target height is below minimum (%f mm). Clamping to %f mm.\n", target, MIN_HEIGHT);
+            target = MIN_HEIGHT;
+        }
+    }
+    if ((gain_mask != 0 && control_request(CTRL_REQ_GAINS, gain_mask, gains[0], gains[1], gains[2]) != RT_EOK) ||
+        (cmd_has(args, PID_TUNE_TARGET) && control_request(CTRL_REQ_TARGET, 0, target, 0.0f, 0.0f) != RT_EOK)) {
+        cmd_printf(reply, "Error: Control request queue is full.\n");
+        return -RT_EBUSY;
+    }
+    if (args->present & ((1UL << PID_TUNE_TARGET) | (1UL << PID_TUNE_KP) | (1UL << PID_TUNE_KI) | (1UL << PID_TUNE_KD))) {
+        cmd_printf(reply, "Parameters updated. Target: %.2f mm, Kp: %f, Ki: %f, Kd: %f\n", target, gains[0], gains[1], gains[2]);
+    }
 
-        /* --- 输出限幅与积分抗饱和 --- */
-        if (final_fan_speed > 1.0f) {
-            final_fan_speed = 1.0f;
-            integral_error -= error; // 抗饱和
+    if (cmd_has(args, PID_TUNE_SAVE)) {
+#ifdef APP_USING_PARAM_STORE
+        rt_err_t ret = params_save();
+        if (ret != RT_EOK) {
+            cmd_printf(reply, "Error: Failed to save tables (%d).\n", ret);
+            return ret;
         }
-        if (final_fan_speed < 0.0f) {
-            final_fan_speed = 0.0f;
-            integral_error -= error; // 抗饱和
+        cmd_printf(reply, "Gain schedule and feedforward tables saved.\n");
+#else
+        cmd_printf(reply, "Error: Parameter store is disabled (APP_USING_PARAM_STORE).\n");
+        return -RT_ENOSYS;
+#endif
+    }
+    return RT_EOK;
+}
+
+/**
+ * @brief 请求控制线程开始一次评估
+ * @return 请求前的完成次数, 传给 eval_wait() 判断本次评估是否完成
+ */
+static rt_uint32_t eval_start(rt_uint32_t duration_ms, float band)
+{
+    rt_uint32_t done = eval_done;
+
+    eval_request_band = band;
+    eval_request_ms = duration_ms > 0 ? duration_ms : 1;
+    return done;
+}
+
+/* 等待 eval_start() 发起的评估完成, 超过时长两个周期仍未完成时返回 RT_FALSE */
+static rt_bool_t eval_wait(rt_uint32_t done, rt_uint32_t duration_ms)
+{
+    rt_uint32_t waited = 0;
+
+    while (eval_done == done) {
+        if (waited > duration_ms + 2 * 1000 / CONTROL_LOOP_RATE_HZ) return RT_FALSE;
+        rt_thread_mdelay(10);
+        waited += 10;
+    }
+    return RT_TRUE;
+}
+
+static void eval_get_result(eval_result_t *r)
+{
+    rt_enter_critical();
+    *r = eval_result;
+    rt_exit_critical();
+}
+
+static void eval_print_json(struct cmd_reply *reply, const eval_result_t *r)
+{
+    cmd_printf(reply, "{\"duration\":%.3f,\"samples\":%u,\"iae\":%.3f,\"ise\":%.1f,\"itae\":%.3f,"
+               "\"overshoot\":%.2f,\"settling_time\":%.3f,\"settled\":%s,\"ss_mean\":%.3f,\"ss_var\":%.3f,"
+               "\"effort\":%.4f,\"effort_tv\":%.4f,\"saturated\":%u}",
+               r->duration, r->samples, r->iae, r->ise, r->itae,
+               r->overshoot, r->settling_time, r->settled ? "true" : "false", r->ss_mean, r->ss_var,
+               r->effort, r->effort_tv, r->saturated);
+}
+
+enum
+{
+    PID_EVAL_ASYNC,
+    PID_EVAL_BAND,
+    PID_EVAL_STOP,
+};
+
+static const struct cmd_option pid_eval_options[] =
+{
+    [PID_EVAL_ASYNC] = { "-async", "" },
+    [PID_EVAL_BAND]  = { "-band", "f" },
+    [PID_EVAL_STOP]  = { "-stop", "" },
+    { RT_NULL, RT_NULL },
+};
+
+/*
+ * pid_eval <ms>         阻塞到评估结束 (只限控制台), 输出 EVAL_RESULT 和 EVAL_METRICS
+ * pid_eval <ms> -async  立即返回, 之后用不带参数的 pid_eval 取结果
+ * pid_eval              查询进行中的状态和最近一次的结果
+ */
+static rt_err_t pid_eval_cmd(const struct cmd_args *args, struct cmd_reply *reply)
+{
+    eval_result_t r;
+
+    if (cmd_has(args, PID_EVAL_STOP)) {
+        eval_stop = RT_TRUE;
+        cmd_printf(reply, "Evaluation stop requested.\n");
+        return RT_EOK;
+    }
+
+    if (args->npos == 0) {
+        eval_get_result(&r);
+        if (reply->flags & CMD_REPLY_JSON) {
+            cmd_printf(reply, "{\"running\":%s,\"done\":%u,\"result\":", is_evaluating ? "true" : "false", eval_done);
+            eval_print_json(reply, &r);
+            cmd_printf(reply, "}");
+            return RT_EOK;
         }
-        ys4028b12h_set_speed(cfg, final_fan_speed);
+        cmd_printf(reply, "Evaluation: %s, %u completed\n", is_evaluating ? "running" : "idle", eval_done);
+        cmd_printf(reply, "EVAL_METRICS:");
+        eval_print_json(reply, &r);
+        cmd_printf(reply, "\n");
+        return RT_EOK;
+    }
 
-        rt_thread_mdelay(SAMPLE_DELAY_MS);
+    if (is_evaluating || eval_request_ms != 0 || autotune_busy) {
+        cmd_printf(reply, "Error: Evaluation or autotune already running.\n");
+        return -RT_EBUSY;
     }
+    rt_uint32_t duration = args->pos[0].i;
+    float band = cmd_has(args, PID_EVAL_BAND) ? args->opt[PID_EVAL_BAND][0].f : EVAL_SETTLE_BAND;
+    rt_bool_t async = cmd_has(args, PID_EVAL_ASYNC);
 
-    rt_device_close(tof_dev);
-    return 0;
+    /* 远程服务器线程不能被长时间阻塞 */
+    if (!async && (reply->flags & CMD_REPLY_JSON)) {
+        cmd_printf(reply, "Error: Use -async for remote evaluation.\n");
+        return -RT_EPERM;
+    }
+
+    rt_uint32_t done = eval_start(duration, band);
+    if (async) {
+        cmd_printf(reply, "Evaluation started for %d ms.\n", duration);
+        return RT_EOK;
+    }
+
+    /* 开始提示立即打印, 结果随回复输出 */
+    rt_kprintf("Starting evaluation for %d ms...\n", duration);
+    if (!eval_wait(done, duration)) {
+        cmd_printf(reply, "Error: Evaluation did not complete, is the control loop running?\n");
+        return -RT_ETIMEOUT;
+    }
+    eval_get_result(&r);
+    cmd_printf(reply, "EVAL_RESULT:%f\n", r.iae / PID_TUNED_DT);
+    cmd_printf(reply, "EVAL_METRICS:");
+    eval_print_json(reply, &r);
+    cmd_printf(reply, "\n");
+    return RT_EOK;
+}
+
+static rt_err_t get_status_cmd(const struct cmd_args *args, struct cmd_reply *reply)
+{
+    struct telemetry t;
+
+    RT_UNUSED(args);
+    telemetry_read(&t);
+
+    /* 远程客户端取JSON, 所有字段来自同一个控制周期 */
+    if (reply->flags & CMD_REPLY_JSON) {
+        cmd_printf(reply, "{"
+            "\"seq\":%lu,"
+            "\"current_height\":%ld,"
+            "\"target_height\":%.2f,"
+            "\"ramped_height\":%.2f,"
+            "\"est_height\":%.2f,"
+            "\"est_velocity\":%.2f,"
+            "\"pid_kp\":%.6f,"
+            "\"pid_ki\":%.6f,"
+            "\"pid_kd\":%.6f,"
+            "\"integral_error\":%.4f,"
+            "\"previous_error\":%.4f,"
+            "\"feedforward_speed\":%.4f,"
+            "\"is_evaluating\":%s,"
+            "\"total_abs_error\":%.4f"
+            "}",
+            (unsigned long)t.seq,
+            (long)t.current_height,
+            t.target_height, t.ramped_height,
+            t.est_height, t.est_velocity,
+            t.kp, t.ki, t.kd,
+            t.integral_error, t.previous_error,
+            t.feedforward_speed,
+            t.is_evaluating ? "true" : "false",
+            t.total_abs_error);
+        return RT_EOK;
+    }
+
+    cmd_printf(reply, "--- System Status (cycle %d) ---\n", t.seq);
+    cmd_printf(reply, "Current Height: %d mm\n", t.current_height);
+    cmd_printf(reply, "Final Target Height: %.2f mm\n", t.target_height);
+    cmd_printf(reply, "Ramped Target Height: %.2f mm\n", t.ramped_height);
+    cmd_printf(reply, "Estimated Height: %.2f mm, Velocity: %.2f mm/s\n", t.est_height, t.est_velocity);
+    cmd_printf(reply, "PID Gains: Kp=%.6f, Ki=%.6f, Kd=%.6f\n", t.kp, t.ki, t.kd);
+    cmd_printf(reply, "Integral Error: %.4f\n", t.integral_error);
+    cmd_printf(reply, "Previous Error: %.4f\n", t.previous_error);
+    cmd_printf(reply, "Feedforward Speed: %.4f\n", t.feedforward_speed);
+    cmd_printf(reply, "Fan Speed: %.4f\n", t.fan_speed);
+    cmd_printf(reply, "PID Evaluation: %s\n", t.is_evaluating ? "ON" : "OFF");
+    cmd_printf(reply, "Total Abs Error: %.4f\n", t.total_abs_error);
+
+    struct control_loop_stats stats;
+    control_loop_get_stats(&stats);
+    cmd_printf(reply, "Control Loop: %d Hz, period %d us, exec %d us (max %d us)\n",
+               CONTROL_LOOP_RATE_HZ, stats.period_us, stats.exec_us, stats.exec_max_us);
+    cmd_printf(reply, "Control Overruns: %d, Missed Ticks: %d\n", stats.overruns, stats.missed_ticks);
+
+    struct tof_stats tof;
+    tof_get_stats(&tof);
+    cmd_printf(reply, "ToF: %s mode, %d samples, %d dropped, %d read errors, %d irq timeouts\n",
+               tof.irq_mode ? "interrupt" : "polling", tof.samples, tof.dropped, tof.read_errors,
+               tof.irq_timeouts);
+#ifdef HEIGHT_USING_ESTIMATOR
+    cmd_printf(reply, "Estimator: %s, %d samples rejected, last innovation %.2f mm\n",
+               height_est.cfg.type == ESTIMATOR_KALMAN ? "Kalman" : "alpha-beta",
+               height_est.rejected, height_est.innovation);
+#endif
+    return RT_EOK;
 }
 
 /*******************************************************************************
- * 评测用
+ * 继电自整定: 逐个断点辨识 Ku/Tu, 算出增益直接写入增益调度表
  ******************************************************************************/
 
-void pid_tune(int argc, char **argv)
-{
-    if (argc < 2) {
-        rt_kprintf("--- PID & Feedforward Status ---\n");
-        rt_kprintf("  Final Target: %.2f mm, Ramped Target: %.2f mm\n", target_height, ramped_height);
-        rt_kprintf("  Kp: %f, Ki: %f, Kd: %f\n", KP, KI, KD);
-        rt_kprintf("\n--- Usage ---\n");
-        rt_kprintf("  pid_tune -t <val>                    (Set target height)\n");
-        rt_kprintf("  pid_tune -p <val> -i <val> -d <val>  (Manual PID override)\n");
-        rt_kprintf("  pid_tune -ff                         (Show Feedforward table)\n");
-        rt_kprintf("  pid_tune -ff_set <idx> <h> <spd>     (Set Feedforward entry)\n");
-        rt_kprintf("    e.g., pid_tune -ff_set 2 100.0 0.45\n");
+enum autotune_status
+{
+    AUTOTUNE_STATUS_NONE = 0,
+    AUTOTUNE_STATUS_RUNNING,
+    AUTOTUNE_STATUS_OK,
+    AUTOTUNE_STATUS_FAILED,
+    AUTOTUNE_STATUS_SKIPPED,    // 断点低于最小高度
+    AUTOTUNE_STATUS_ABORTED,
+};
+
+static const char *const autotune_status_names[] = { "none", "running", "ok", "failed", "skipped", "aborted" };
+
+struct autotune_result
+{
+    rt_uint8_t status;
+    float ku;
+    float tu;
+    float bias;             // 继电结束时的偏置, 即该高度的平衡占空比
+    float kp, ki, kd;
+    float cost;             // 新增益下的误差绝对值积分, 与 EVAL_RESULT 同一口径
+    float overshoot;        // 评估期间的超调 (mm)
+    float settling_time;    // 评估期间的调节时间 (s)
+};
+
+static struct
+{
+    int first;
+    int last;
+    int current;
+    autotune_config_t cfg;
+    autotune_rule_t rule;
+    rt_uint32_t eval_ms;
+    rt_bool_t set_ff;       // 平衡占空比写入同高度的前馈表断点
+    rt_bool_t save;         // 全部完成后保存到参数存储
+} autotune_job;
+
+static struct autotune_result autotune_results[LUT_MAX_POINTS];
+#define AUTOTUNE_RESULT_LEN  256        // 一条结果 JSON 的最大长度, 超过 RT_CONSOLEBUF_SIZE
+
+/* 分段睡眠, 期间收到中止请求时返回 RT_FALSE */
+static rt_bool_t autotune_sleep(rt_uint32_t ms)
+{
+    while (ms > 0 && !autotune_abort) {
+        rt_uint32_t step = ms > 50 ? 50 : ms;
+        rt_thread_mdelay(step);
+        ms -= step;
+    }
+    return !autotune_abort;
+}
+
+/* 等斜坡到达断点高度且高度在稳定带内保持一段时间, 超时后照常开始 */
+static rt_bool_t autotune_settle(float height)
+{
+    struct telemetry t;
+    rt_uint32_t stable = 0;
+
+    for (rt_uint32_t waited = 0; waited < AUTOTUNE_SETTLE_MAX && stable < AUTOTUNE_SETTLE_MS; waited += 50) {
+        if (!autotune_sleep(50)) return RT_FALSE;
+        telemetry_read(&t);
+        if (t.ramped_height == height && FABS(t.current_height - height) < AUTOTUNE_SETTLE_BAND) stable += 50;
+        else stable = 0;
+    }
+    return RT_TRUE;
+}
+
+/* 投递控制请求, 队列满时每个控制周期重试一次, 仍失败时打印并返回错误 */
+static rt_err_t autotune_request(rt_uint16_t type, int index, float v0, float v1, float v2)
+{
+    rt_err_t ret = control_request(type, index, v0, v1, v2);
+
+    for (int n = 0; ret != RT_EOK && n < AUTOTUNE_REQ_RETRIES; n++) {
+        rt_thread_mdelay(1000 / CONTROL_LOOP_RATE_HZ);
+        ret = control_request(type, index, v0, v1, v2);
+    }
+    if (ret != RT_EOK) rt_kprintf("[Autotune] Control request %d dropped (%d).\n", type, (int)ret);
+    return ret;
+}
+
+/**
+ * @brief 等控制线程结束本次继电辨识
+ * 辨识按控制周期的实测时间计时, 超过配置的超时仍未结束说明控制线程没有在运行;
+ * 收到中止请求后控制线程下一周期就会结束辨识, 只再等一小段
+ * @param runs 投递辨识请求前的 autotune_runs
+ * @return RT_FALSE 等待超时
+ */
+static rt_bool_t autotune_wait_relay(rt_uint32_t runs)
+{
+    rt_uint32_t limit = (rt_uint32_t)(autotune_request_cfg.timeout * 1000.0f) + AUTOTUNE_RELAY_MARGIN;
+    rt_uint32_t waited = 0;
+
+    while (autotune_runs == runs) {
+        if (autotune_abort && limit > waited + AUTOTUNE_ABORT_GRACE) limit = waited + AUTOTUNE_ABORT_GRACE;
+        if (waited > limit) return RT_FALSE;
+        rt_thread_mdelay(50);
+        waited += 50;
+    }
+    return RT_TRUE;
+}
+
+static void autotune_format_result(int index, char *buf, rt_size_t size)
+{
+    const struct autotune_result *r = &autotune_results[index];
+
+    rt_snprintf(buf, size, "{\"idx\":%d,\"height\":%.1f,\"status\":\"%s\",\"ku\":%.6f,\"tu\":%.3f,"
+                "\"bias\":%.4f,\"kp\":%.8f,\"ki\":%.8f,\"kd\":%.8f,\"cost\":%.2f,"
+                "\"overshoot\":%.1f,\"settling_time\":%.2f}",
+                index, gain_schedule_table[index].height, autotune_status_names[r->status],
+                r->ku, r->tu, r->bias, r->kp, r->ki, r->kd, r->cost, r->overshoot, r->settling_time);
+}
+
+/**
+ * @brief 整定一个断点: 稳定 -> 继电辨识 -> 写入增益 -> 评估
+ */
+static void autotune_point(int index)
+{
+    struct autotune_result *r = &autotune_results[index];
+    float height = gain_schedule_table[index].height;
+    struct telemetry t;
+
+    if (height < MIN_HEIGHT) {
+        r->status = AUTOTUNE_STATUS_SKIPPED;
+        return;
+    }
+    r->status = AUTOTUNE_STATUS_RUNNING;
+    if (autotune_request(CTRL_REQ_TARGET, 0, height, 0.0f, 0.0f) != RT_EOK) {
+        r->status = AUTOTUNE_STATUS_FAILED;
+        return;
+    }
+    if (!autotune_settle(height)) {
+        r->status = AUTOTUNE_STATUS_ABORTED;
         return;
     }
 
-    if (strcmp(argv[1], "-ff") == 0) {
-        rt_kprintf("--- Feedforward Table ---\n");
-        rt_kprintf("Idx | Height (mm) | Base Speed\n");
-        rt_kprintf("----|-------------|-----------\n");
-        for (int i = 0; i < num_ff_profiles; i++) {
-            rt_kprintf("%-3d | %-11.1f | %.4f\n", i, ff_table[i].height, ff_table[i].base_fan_speed);
-        }
+    /* 稳定后的PID输出作为继电偏置的初值, 不对称修正会把它收敛到平衡占空比 */
+    telemetry_read(&t);
+    autotune_request_cfg = autotune_job.cfg;
+    autotune_request_cfg.bias = t.fan_speed;
+    rt_uint32_t runs = autotune_runs;
+    if (autotune_request(CTRL_REQ_AUTOTUNE, 0, height, 0.0f, 0.0f) != RT_EOK) {
+        r->status = AUTOTUNE_STATUS_FAILED;
+        return;
+    }
+    if (!autotune_wait_relay(runs)) {
+        /* 控制线程停了, 后面的断点也无法进行; 置中止让它恢复后立即结束辨识, 由调用者恢复目标高度 */
+        rt_kprintf("[Autotune] Relay test at %.1f mm did not finish, control loop stalled.\n", height);
+        r->status = autotune_abort ? AUTOTUNE_STATUS_ABORTED : AUTOTUNE_STATUS_FAILED;
+        autotune_abort = RT_TRUE;
+        return;
+    }
+    if (autotune_abort) {
+        r->status = AUTOTUNE_STATUS_ABORTED;
         return;
     }
 
-    if (strcmp(argv[1], "-ff_set") == 0) {
-        if (argc != 5) {
-            rt_kprintf("Error: Incorrect arguments for -ff_set.\n");
-            rt_kprintf("Usage: pid_tune -ff_set <index> <height> <speed>\n");
-            return;
-        }
-        int index = atoi(argv[2]);
-        if (index < 0 || index >= num_ff_profiles) {
-            rt_kprintf("Error: Index %d is out of bounds (0-%d).\n", index, num_ff_profiles - 1);
-            return;
-        }
-        ff_table[index].height = atof(argv[3]);
-        ff_table[index].base_fan_speed = atof(argv[4]);
-        rt_kprintf("Feedforward table entry %d updated to: Height=%.1f, Speed=%.4f\n",
-                   index, ff_table[index].height, ff_table[index].base_fan_speed);
+    r->ku = autotuner.ku;
+    r->tu = autotuner.tu;
+    r->bias = autotuner.bias;
+    if (autotuner.state != AUTOTUNE_DONE) {
+        r->status = AUTOTUNE_STATUS_FAILED;
+        return;
+    }
+
+    float gains[3];
+    autotune_gains(&autotuner, autotune_job.rule, PID_TUNED_DT, &gains[0], &gains[1], &gains[2]);
+    if (gain_schedule_set(index, gains) != RT_EOK) {
+        r->status = AUTOTUNE_STATUS_FAILED;
         return;
     }
+    r->kp = gains[0];
+    r->ki = gains[1];
+    r->kd = gains[2];
 
-    for (int i = 1; i < argc; i += 2) {
-        if (strcmp(argv[i], "-p") == 0) { KP = atof(argv[i+1]); }
-        else if (strcmp(argv[i], "-i") == 0) { KI = atof(argv[i+1]); }
-        else if (strcmp(argv[i], "-d") == 0) { KD = atof(argv[i+1]); }
-        else if (strcmp(argv[i], "-t") == 0) {
-            target_height = atof(argv[i+1]);
-            if (target_height < MIN_HEIGHT) {
-                rt_kprintf("Warning: Target height is below minimum (%f mm). Clamping to %f mm.\n", target_height, MIN_HEIGHT);
-                target_height = MIN_HEIGHT;
+    if (autotune_job.set_ff) {
+        for (int i = 0; i < num_ff_profiles; i++) {
+            if (ff_table[i].height != height) continue;
+            if (autotune_request(CTRL_REQ_FF_POINT, i, height, r->bias, 0.0f) != RT_EOK) {
+                r->status = AUTOTUNE_STATUS_FAILED;
+                return;
             }
         }
-        else { rt_kprintf("Error: Unknown option %s\n", argv[i]); return; }
     }
-    rt_kprintf("Parameters updated. Current status:\n");
-    pid_tune(1, RT_NULL); // 显示更新后的状态
+
+    /* 代价: 新增益从继电振荡中恢复并保持的误差积分, 与 EVAL_RESULT 同一口径 */
+    rt_uint32_t done = eval_start(autotune_job.eval_ms, EVAL_SETTLE_BAND);
+    rt_bool_t finished = autotune_sleep(autotune_job.eval_ms);
+    if (!finished) eval_stop = RT_TRUE;
+    if (!eval_wait(done, autotune_job.eval_ms)) {
+        /* 评估没有完成, 结果区里还是上一次评估的指标, 不能记到这个断点 */
+        rt_kprintf("[Autotune] Evaluation at %.1f mm did not complete.\n", height);
+        r->status = AUTOTUNE_STATUS_FAILED;
+        return;
+    }
+    eval_result_t m;
+    eval_get_result(&m);
+    r->cost = m.iae / PID_TUNED_DT;
+    r->overshoot = m.overshoot;
+    r->settling_time = m.settling_time;
+    r->status = finished ? AUTOTUNE_STATUS_OK : AUTOTUNE_STATUS_ABORTED;
 }
-MSH_CMD_EXPORT(pid_tune, Tune PID and Feedforward parameters);
 
-void pid_eval(int argc, char **argv)
+static void autotune_entry(void *parameter)
 {
-    if (argc != 2) {
-        rt_kprintf("Usage: pid_eval <duration_ms>\n");
-        return;
+    float saved_target = target_height;
+    char buf[AUTOTUNE_RESULT_LEN];
+
+    RT_UNUSED(parameter);
+
+    for (int i = autotune_job.first; i <= autotune_job.last && !autotune_abort; i++) {
+        autotune_job.current = i;
+        autotune_point(i);
+        autotune_format_result(i, buf, sizeof(buf));
+        /* rt_kprintf 经 RT_CONSOLEBUF_SIZE 大小的缓冲格式化, 会截断结果, 分段直接输出 */
+        rt_kputs("AUTOTUNE_RESULT:");
+        rt_kputs(buf);
+        rt_kputs("\n");
     }
- 
-    rt_uint32_t duration = atoi(argv[1]);
-    rt_kprintf("Starting evaluation for %d ms...\n", duration);
- 
-    integral_error = 0;
-    previous_error = 0;
-    total_abs_error = 0;
-    is_evaluating = RT_TRUE;
- 
-    rt_thread_mdelay(duration);
- 
-    is_evaluating = RT_FALSE;
-    rt_kprintf("EVAL_RESULT:%f\n", total_abs_error);
-}
-MSH_CMD_EXPORT(pid_eval, Evaluate current PID performance);
-
-static void get_status(int argc, char **argv)
-{
-    rt_kprintf("--- System Status ---\n");
-    rt_kprintf("Current Height: %d mm\n", current_height);
-    rt_kprintf("Final Target Height: %.2f mm\n", target_height);
-    rt_kprintf("Ramped Target Height: %.2f mm\n", ramped_height);
-    rt_kprintf("PID Gains: Kp=%.6f, Ki=%.6f, Kd=%.6f\n", KP, KI, KD);
-    rt_kprintf("Integral Error: %.4f\n", integral_error);
-    rt_kprintf("Previous Error: %.4f\n", previous_error);
-    rt_kprintf("Feedforward Speed: %.4f\n", get_feedforward_speed(ramped_height));
-    rt_kprintf("PID Evaluation: %s\n", is_evaluating ? "ON" : "OFF");
-    rt_kprintf("Total Abs Error: %.4f\n", total_abs_error);
-}
-MSH_CMD_EXPORT(get_status, Get current ball height for testing);
\ No newline at end of file
+    if (autotune_request(CTRL_REQ_TARGET, 0, saved_target, 0.0f, 0.0f) != RT_EOK) {
+        rt_kprintf("[Autotune] Target height not restored to %.1f mm.\n", saved_target);
+    }
+
+#ifdef APP_USING_PARAM_STORE
+    if (autotune_job.save && !autotune_abort) {
+        rt_err_t ret = params_save();
+        rt_kprintf("[Autotune] Save tables: %s (%d)\n", ret == RT_EOK ? "ok" : "failed", ret);
+    }
+#endif
+    rt_kprintf("[Autotune] %s.\n", autotune_abort ? "Aborted" : "Finished");
+}
+
+/* 静态线程退出后由空闲线程脱离对象再调用 cleanup, 之后才能再次 rt_thread_init */
+static void autotune_cleanup(rt_thread_t thread)
+{
+    RT_UNUSED(thread);
+    autotune_busy = RT_FALSE;
+}
+
+enum
+{
+    AUTOTUNE_OPT_AMP,
+    AUTOTUNE_OPT_HYST,
+    AUTOTUNE_OPT_RULE,
+    AUTOTUNE_OPT_EVAL,
+    AUTOTUNE_OPT_FF,
+    AUTOTUNE_OPT_SAVE,
+    AUTOTUNE_OPT_ABORT,
+};
+
+static const struct cmd_option pid_autotune_options[] =
+{
+    [AUTOTUNE_OPT_AMP]   = { "-amp", "f" },
+    [AUTOTUNE_OPT_HYST]  = { "-hyst", "f" },
+    [AUTOTUNE_OPT_RULE]  = { "-rule", "i" },
+    [AUTOTUNE_OPT_EVAL]  = { "-eval", "i" },
+    [AUTOTUNE_OPT_FF]    = { "-ff", "" },
+    [AUTOTUNE_OPT_SAVE]  = { "-save", "" },
+    [AUTOTUNE_OPT_ABORT] = { "-abort", "" },
+    { RT_NULL, RT_NULL },
+};
+
+/* 整定在独立线程中进行, 命令立即返回; 不带参数时查询进度和各断点的结果 */
+static rt_err_t pid_autotune_cmd(const struct cmd_args *args, struct cmd_reply *reply)
+{
+    char buf[AUTOTUNE_RESULT_LEN];
+
+    if (cmd_has(args, AUTOTUNE_OPT_ABORT)) {
+        if (autotune_busy) autotune_abort = RT_TRUE;
+        cmd_printf(reply, autotune_busy ? "Aborting autotune...\n" : "Autotune is not running.\n");
+        return RT_EOK;
+    }
+
+    if (args->npos == 0) {
+        if (reply->flags & CMD_REPLY_JSON) {
+            cmd_printf(reply, "{\"running\":%s,\"current\":%d,\"results\":[",
+                       autotune_busy ? "true" : "false", autotune_job.current);
+            for (int i = 0; i < num_pid_profiles; i++) {
+                autotune_format_result(i, buf, sizeof(buf));
+                cmd_printf(reply, "%s%s", i ? "," : "", buf);
+            }
+            cmd_printf(reply, "]}");
+            return RT_EOK;
+        }
+        cmd_printf(reply, "--- Autotune: %s ---\n", autotune_busy ? "running" : "idle");
+        cmd_printf(reply, "Idx | Height | Status  | Ku       | Tu (s) | Bias   | Kp         | Ki         | Kd         | Cost\n");
+        for (int i = 0; i < num_pid_profiles; i++) {
+            const struct autotune_result *r = &autotune_results[i];
+            cmd_printf(reply, "%-3d | %-6.1f | %-7s | %-8.5f | %-6.2f | %-6.4f | %-10.8f | %-10.8f | %-10.8f | %.1f\n",
+                       i, gain_schedule_table[i].height, autotune_status_names[r->status],
+                       r->ku, r->tu, r->bias, r->kp, r->ki, r->kd, r->cost);
+        }
+        cmd_printf(reply, "\n--- Usage ---\n");
+        cmd_printf(reply, "  pid_autotune <first> [<last>] [-amp <d>] [-hyst <mm>] [-rule <0-2>] [-eval <ms>] [-ff] [-save]\n");
+        cmd_printf(reply, "    rule: 0 Ziegler-Nichols, 1 some overshoot (default), 2 no overshoot\n");
+        cmd_printf(reply, "  pid_autotune -abort\n");
+        return RT_EOK;
+    }
+
+    if (autotune_busy || is_evaluating || eval_request_ms != 0) {
+        cmd_printf(reply, "Error: Autotune or evaluation already running.\n");
+        return -RT_EBUSY;
+    }
+    int first = args->pos[0].i;
+    int last = args->npos > 1 ? args->pos[1].i : first;
+    if (first < 0 || last < first || last >= num_pid_profiles) {
+        cmd_printf(reply, "Error: Index range %d-%d is out of bounds (0-%d).\n", first, last, num_pid_profiles - 1);
+        return -RT_EINVAL;
+    }
+    int rule = cmd_has(args, AUTOTUNE_OPT_RULE) ? args->opt[AUTOTUNE_OPT_RULE][0].i : AUTOTUNE_RULE_SOME_OVERSHOOT;
+    if (rule < AUTOTUNE_RULE_ZN || rule > AUTOTUNE_RULE_NO_OVERSHOOT) {
+        cmd_printf(reply, "Error: Unknown tuning rule %d.\n", rule);
+        return -RT_EINVAL;
+    }
+
+    autotune_job.first = first;
+    autotune_job.last = last;
+    autotune_job.current = first;
+    autotune_job.rule = (autotune_rule_t)rule;
+    autotune_job.eval_ms = cmd_has(args, AUTOTUNE_OPT_EVAL) ? args->opt[AUTOTUNE_OPT_EVAL][0].i : AUTOTUNE_EVAL_MS;
+    autotune_job.set_ff = cmd_has(args, AUTOTUNE_OPT_FF);
+    autotune_job.save = cmd_has(args, AUTOTUNE_OPT_SAVE);
+    autotune_job.cfg = (autotune_config_t) {
+        .amplitude = cmd_has(args, AUTOTUNE_OPT_AMP) ? args->opt[AUTOTUNE_OPT_AMP][0].f : AUTOTUNE_AMPLITUDE,
+        .hysteresis = cmd_has(args, AUTOTUNE_OPT_HYST) ? args->opt[AUTOTUNE_OPT_HYST][0].f : AUTOTUNE_HYSTERESIS,
+        .out_min = 0.0f, .out_max = 1.0f,
+        .skip_cycles = 2,
+        .cycles = 4,
+        .timeout = AUTOTUNE_TIMEOUT,
+    };
+    for (int i = first; i <= last; i++) {
+        autotune_results[i] = (struct autotune_result){ 0 };
+    }
+
+    autotune_abort = RT_FALSE;
+    autotune_busy = RT_TRUE;
+    if (rt_thread_init(&autotune_thread, "autotune", autotune_entry, RT_NULL,
+                       autotune_thread_stack, sizeof(autotune_thread_stack), 12, 20) != RT_EOK) {
+        autotune_busy = RT_FALSE;
+        cmd_printf(reply, "Error: Failed to create autotune thread.\n");
+        return -RT_ERROR;
+    }
+    autotune_thread.cleanup = autotune_cleanup;
+    rt_thread_startup(&autotune_thread);
+    cmd_printf(reply, "Autotune started for entries %d-%d, results follow as AUTOTUNE_RESULT lines.\n", first, last);
+    return RT_EOK;
+}
+
+static const struct cmd_def app_cmd_defs[] =
+{
+    { "pid_tune", "pid_tune [-t <h>] [-p <kp>] [-i <ki>] [-d <kd>] [-ff] [-ff_set <idx> <h> <spd>] [-gain_set <idx>] [-save]",
+      pid_tune_options, RT_NULL, 0, 0, pid_tune_cmd },
+    { "pid_eval", "pid_eval [<duration_ms>] [-async] [-band <mm>] [-stop]", pid_eval_options, "i", 0, 0, pid_eval_cmd },
+    { "get_status", "get_status", RT_NULL, RT_NULL, 0, 0, get_status_cmd },
+    { "pid_autotune", "pid_autotune [<first> [<last>]] [-amp <d>] [-hyst <mm>] [-rule <0-2>] [-eval <ms>] [-ff] [-save] [-abort]",
+      pid_autotune_options, "ii", 0, 0, pid_autotune_cmd },
+};
+
+static struct cmd_table app_cmds = { app_cmd_defs, sizeof(app_cmd_defs) / sizeof(app_cmd_defs[0]), RT_NULL };
+
+/* 命令表在内核初始化阶段注册, FinSH 和远程服务器启动时已可用 */
+static int app_cmds_init(void)
+{
+    cmd_register(&app_cmds);
+    return 0;
+}
+INIT_APP_EXPORT(app_cmds_init);
+
+CMD_MSH_EXPORT(pid_tune, Tune PID and Feedforward parameters);
+CMD_MSH_EXPORT(pid_eval, Evaluate current PID performance);
+CMD_MSH_EXPORT(get_status, Get current ball height for testing);
+CMD_MSH_EXPORT(pid_autotune, Relay autotune the gain schedule);
@@ -0,0 +1,660 @@
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <string.h>
+#include "cmd.h"
+#include "sysmon.h"
+#ifdef BSP_USING_TICKLESS
+#include "ktime.h"
+#endif
+
+#define SYSMON_OTHER        APP_SYSMON_MAX_THREADS      // 表满或已退出线程的合并项
+
+struct sysmon_entry
+{
+    rt_thread_t thread;                 // RT_NULL 表示空闲
+    char name[RT_NAME_MAX];             // 登记时的线程名, 用于发现指针被新线程复用
+    rt_uint64_t cycles;                 // 累计运行周期 (不含中断)
+    rt_uint32_t switches;               // 累计切入次数
+    rt_uint64_t last_cycles;            // 上一次 top 时的值, 用于计算区间占用率
+    rt_uint32_t last_switches;
+};
+
+struct sysmon_probe
+{
+    rt_thread_t thread;                 // 绑定的线程, RT_NULL 表示还没有运行过
+    rt_uint32_t wake_stamp;             // 唤醒时刻 (周期)
+    rt_bool_t pending;                  // 已唤醒还没有切入
+    struct sysmon_latency lat;          // lat.name 为空表示该项未使用
+};
+
+struct top_row
+{
+    char name[RT_NAME_MAX];
+    rt_uint8_t priority;
+    rt_uint16_t permille;               // 区间CPU占用 (千分比)
+    rt_uint32_t switches;               // 区间切入次数
+};
+
+static struct sysmon_entry entries[APP_SYSMON_MAX_THREADS + 1];
+static rt_uint8_t entries_used;         // 用过的最大下标加一, 查表只扫描到这里
+static struct sysmon_entry *current;    // 正在运行的线程
+static rt_uint32_t slice_start;         // 当前线程本次开始运行的时刻
+static rt_uint32_t slice_irq;           // 当前线程运行期间中断占用的周期
+
+static rt_uint8_t irq_depth;            // 中断嵌套深度, 只在最外层计时
+static rt_uint32_t irq_start;
+static rt_uint64_t irq_cycles;
+static rt_uint64_t irq_last_cycles;
+
+static struct sysmon_probe probes[APP_SYSMON_MAX_PROBES];
+static volatile rt_uint8_t probes_bound; // 已绑定线程的被测项数, 为0时唤醒钩子直接返回
+static rt_uint32_t cycles_per_us;
+
+/* top 的结果表较大, 放在静态区, 控制台和远程服务器并发调用时用互斥量保护 */
+static struct top_row top_rows[APP_SYSMON_MAX_THREADS + 1];
+static struct rt_mutex top_lock;
+static rt_tick_t top_last_tick;
+
+/*
+ * 计时用的时间戳. 打开 tickless 时空闲线程会 WFI 休眠, DWT周期计数器随内核时钟停住,
+ * 休眠时间不会记到空闲线程, 这时改用不停的 ktime cputimer 计数 (分辨率较低)
+ */
+rt_inline rt_uint32_t sysmon_stamp(void)
+{
+#ifdef BSP_USING_TICKLESS
+    return (rt_uint32_t)rt_ktime_cputimer_getcnt();
+#else
+    return (rt_uint32_t)clock_cpu_gettime();
+#endif
+}
+
+static void probe_bind(struct sysmon_probe *p, rt_thread_t thread)
+{
+    p->thread = thread;
+    p->pending = RT_FALSE;
+    probes_bound++;
+}
+
+static void probe_unbind(struct sysmon_probe *p)
+{
+    if (p->thread != RT_NULL) {
+        p->thread = RT_NULL;
+        p->pending = RT_FALSE;
+        probes_bound--;
+    }
+}
+
+/* 按线程指针查表, 第一次见到的线程登记到空项并绑定同名的被测项 (调用时已关中断) */
+static struct sysmon_entry *entry_lookup(rt_thread_t thread)
+{
+    struct sysmon_entry *e, *free_entry = RT_NULL;
+
+    for (int i = 0; i < entries_used; i++) {
+        e = &entries[i];
+        if (e->thread == thread) return e;
+        if (e->thread == RT_NULL && free_entry == RT_NULL) free_entry = e;
+    }
+    if (free_entry == RT_NULL) {
+        if (entries_used >= APP_SYSMON_MAX_THREADS) return &entries[SYSMON_OTHER];
+        free_entry = &entries[entries_used++];
+    }
+
+    e = free_entry;
+    memset(e, 0, sizeof(*e));
+    e->thread = thread;
+    rt_strncpy(e->name, thread->parent.name, RT_NAME_MAX);
+    for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+        struct sysmon_probe *p = &probes[i];
+        if (p->lat.name[0] != '\0' && p->thread == RT_NULL &&
+            rt_strncmp(p->lat.name, e->name, RT_NAME_MAX) == 0) {
+            probe_bind(p, thread);
+        }
+    }
+    return e;
+}
+
+/* 把进行中的中断时间结算到 now, 之后的部分从 now 开始计 */
+rt_inline void irq_flush(rt_uint32_t now)
+{
+    if (irq_depth > 0) {
+        rt_uint32_t d = now - irq_start;
+        irq_cycles += d;
+        slice_irq += d;
+        irq_start = now;
+    }
+}
+
+/* 把当前线程运行到 now 的时间 (扣除中断) 记到它名下 */
+rt_inline void slice_flush(rt_uint32_t now)
+{
+    irq_flush(now);
+    current->cycles += (now - slice_start) - slice_irq;
+    slice_start = now;
+    slice_irq = 0;
+}
+
+static void latency_record(struct sysmon_probe *p, rt_uint32_t now)
+{
+    rt_uint32_t us = (now - p->wake_stamp) / cycles_per_us;
+    int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+
+    if (bucket >= SYSMON_HIST_BUCKETS) bucket = SYSMON_HIST_BUCKETS - 1;
+    p->lat.hist[bucket]++;
+    p->lat.count++;
+    p->lat.sum_us += us;
+    if (us > p->lat.max_us) p->lat.max_us = us;
+    p->pending = RT_FALSE;
+}
+
+static void sysmon_scheduler_hook(struct rt_thread *from, struct rt_thread *to)
+{
+    rt_uint32_t now = sysmon_stamp();
+
+    RT_UNUSED(from);
+    slice_flush(now);
+    current = entry_lookup(to);
+    current->switches++;
+
+    if (probes_bound > 0) {
+        for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+            if (probes[i].thread == to && probes[i].pending) latency_record(&probes[i], now);
+        }
+    }
+}
+
+static void sysmon_irq_enter_hook(void)
+{
+    if (irq_depth++ == 0) irq_start = sysmon_stamp();
+}
+
+static void sysmon_irq_leave_hook(void)
+{
+    if (irq_depth == 0) return;     // 钩子装上之前进入的中断
+    if (--irq_depth == 0) {
+        rt_uint32_t d = sysmon_stamp() - irq_start;
+        irq_cycles += d;
+        slice_irq += d;
+    }
+}
+
+/* 记下被测线程的唤醒时刻, 只记第一次, 切入时才清除 */
+rt_inline void probe_wake(rt_thread_t thread)
+{
+    for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+        struct sysmon_probe *p = &probes[i];
+        if (p->thread == thread && !p->pending) {
+            p->wake_stamp = sysmon_stamp();
+            p->pending = RT_TRUE;
+        }
+    }
+}
+
+/*
+ * IPC 释放钩子在唤醒等待者之前调用, 信号量/互斥量/邮箱/消息队列总是唤醒队首线程
+ * 事件集按标志匹配, 队首线程不一定被唤醒, 不统计
+ * 只比较链表节点地址, 不解引用, 与并发的出队竞争也不会访问无效内存
+ */
+static void sysmon_object_put_hook(struct rt_object *object)
+{
+    if (probes_bound == 0) return;
+
+    rt_uint8_t type = rt_object_get_type(object);
+    if (type != RT_Object_Class_Semaphore && type != RT_Object_Class_Mutex &&
+        type != RT_Object_Class_MailBox && type != RT_Object_Class_MessageQueue) {
+        return;
+    }
+
+    struct rt_ipc_object *ipc = rt_container_of(object, struct rt_ipc_object, parent);
+    rt_list_t *head = ipc->suspend_thread.next;
+    if (head == &ipc->suspend_thread) return;
+
+    for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+        rt_thread_t thread = probes[i].thread;
+        if (thread != RT_NULL && head == &RT_THREAD_LIST_NODE(thread)) probe_wake(thread);
+    }
+}
+
+/* 线程内置定时器到期: 延时结束或等待超时 */
+static void sysmon_timer_enter_hook(struct rt_timer *timer)
+{
+    if (probes_bound == 0) return;
+
+    for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+        rt_thread_t thread = probes[i].thread;
+        if (thread != RT_NULL && timer == &thread->thread_timer) probe_wake(thread);
+    }
+}
+
+static void sysmon_resume_hook(rt_thread_t thread)
+{
+    if (probes_bound > 0) probe_wake(thread);
+}
+
+static struct sysmon_probe *probe_find(const char *name)
+{
+    for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+        if (probes[i].lat.name[0] != '\0' && rt_strncmp(probes[i].lat.name, name, RT_NAME_MAX) == 0) {
+            return &probes[i];
+        }
+    }
+    return RT_NULL;
+}
+
+rt_err_t sysmon_latency_add(const char *name)
+{
+    struct sysmon_probe *p = RT_NULL;
+    rt_err_t err = RT_EOK;
+
+    if (name == RT_NULL || name[0] == '\0') return -RT_EINVAL;
+
+    rt_base_t level = rt_hw_interrupt_disable();
+    if (probe_find(name) == RT_NULL) {
+        for (int i = 0; i < APP_SYSMON_MAX_PROBES && p == RT_NULL; i++) {
+            if (probes[i].lat.name[0] == '\0') p = &probes[i];
+        }
+        if (p == RT_NULL) {
+            err = -RT_EFULL;
+        } else {
+            memset(p, 0, sizeof(*p));
+            rt_strncpy(p->lat.name, name, RT_NAME_MAX);
+            /* 已经运行过的线程直接绑定, 否则在它第一次切入时绑定 */
+            for (int i = 0; i < entries_used; i++) {
+                if (entries[i].thread != RT_NULL && rt_strncmp(entries[i].name, name, RT_NAME_MAX) == 0) {
+                    probe_bind(p, entries[i].thread);
+                    break;
+                }
+            }
+        }
+    }
+    rt_hw_interrupt_enable(level);
+    return err;
+}
+
+rt_err_t sysmon_latency_remove(const char *name)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    struct sysmon_probe *p = probe_find(name);
+    if (p != RT_NULL) {
+        probe_unbind(p);
+        p->lat.name[0] = '\0';
+    }
+    rt_hw_interrupt_enable(level);
+    return p != RT_NULL ? RT_EOK : -RT_EEMPTY;
+}
+
+void sysmon_latency_clear(void)
+{
+    rt_base_t level = rt_hw_interrupt_disable();
+    for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+        struct sysmon_latency *lat = &probes[i].lat;
+        lat->count = 0;
+        lat->max_us = 0;
+        lat->sum_us = 0;
+        memset(lat->hist, 0, sizeof(lat->hist));
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+rt_err_t sysmon_latency_get(int index, struct sysmon_latency *lat)
+{
+    int n = 0;
+
+    for (int i = 0; i < APP_SYSMON_MAX_PROBES; i++) {
+        if (probes[i].lat.name[0] == '\0') continue;
+        if (n++ == index) {
+            rt_base_t level = rt_hw_interrupt_disable();
+            *lat = probes[i].lat;
+            rt_hw_interrupt_enable(level);
+            return RT_EOK;
+        }
+    }
+    return -RT_EEMPTY;
+}
+
+static rt_bool_t thread_alive(rt_thread_t thread, rt_object_t *threads, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if ((rt_thread_t)threads[i] == thread) return RT_TRUE;
+    }
+    return RT_FALSE;
+}
+
+/**
+ * @brief 取上一次调用以来各线程和中断的占用率, 填入 top_rows (调用方持有 top_lock)
+ *        已退出的线程 (或指针已被新线程复用) 的时间并入合并项, 其表项释放
+ * @param irq_permille 输出中断占用 (千分比)
+ * @return 行数
+ */
+static int top_snapshot(rt_uint16_t *irq_permille)
+{
+    rt_object_t threads[APP_SYSMON_MAX_THREADS + 8];
+    rt_uint64_t delta[APP_SYSMON_MAX_THREADS + 1];
+    rt_uint64_t total, irq_delta;
+    int rows = 0;
+
+    /* 关调度器期间线程不会被回收, 表里的线程指针和名字都可以安全比较 */
+    rt_enter_critical();
+    int count = rt_object_get_pointers(RT_Object_Class_Thread, threads, sizeof(threads) / sizeof(threads[0]));
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    slice_flush(sysmon_stamp());
+    for (int i = 0; i < entries_used; i++) {
+        struct sysmon_entry *e = &entries[i];
+        if (e->thread == RT_NULL) continue;
+        if (!thread_alive(e->thread, threads, count) ||
+            rt_strncmp(e->thread->parent.name, e->name, RT_NAME_MAX) != 0) {
+            entries[SYSMON_OTHER].cycles += e->cycles - e->last_cycles;
+            entries[SYSMON_OTHER].switches += e->switches - e->last_switches;
+            for (int k = 0; k < APP_SYSMON_MAX_PROBES; k++) {
+                if (probes[k].thread == e->thread) probe_unbind(&probes[k]);
+            }
+            e->thread = RT_NULL;
+        }
+    }
+
+    irq_delta = irq_cycles - irq_last_cycles;
+    irq_last_cycles = irq_cycles;
+    total = irq_delta;
+    for (int i = 0; i <= APP_SYSMON_MAX_THREADS; i++) {
+        struct sysmon_entry *e = &entries[i];
+        if (i < entries_used ? e->thread == RT_NULL : i != SYSMON_OTHER) continue;
+
+        struct top_row *r = &top_rows[rows];
+        delta[rows] = e->cycles - e->last_cycles;
+        r->switches = e->switches - e->last_switches;
+        if (i == SYSMON_OTHER) {
+            if (delta[rows] == 0 && r->switches == 0) continue;
+            rt_strncpy(r->name, "(other)", RT_NAME_MAX);
+            r->priority = 0;
+        } else {
+            rt_strncpy(r->name, e->name, RT_NAME_MAX);
+            r->priority = RT_SCHED_PRIV(e->thread).current_priority;
+        }
+        e->last_cycles = e->cycles;
+        e->last_switches = e->switches;
+        total += delta[rows];
+        rows++;
+    }
+
+    rt_hw_interrupt_enable(level);
+    rt_exit_critical();
+
+    if (total == 0) total = 1;
+    for (int i = 0; i < rows; i++) {
+        top_rows[i].permille = (rt_uint16_t)(delta[i] * 1000 / total);
+    }
+    *irq_permille = (rt_uint16_t)(irq_delta * 1000 / total);
+
+    /* 按占用率从高到低排序, 行数很少, 插入排序即可 */
+    for (int i = 1; i < rows; i++) {
+        struct top_row r = top_rows[i];
+        int j = i;
+        for (; j > 0 && top_rows[j - 1].permille < r.permille; j--) top_rows[j] = top_rows[j - 1];
+        top_rows[j] = r;
+    }
+    return rows;
+}
+
+static void top_print_latency(struct cmd_reply *reply, rt_bool_t json)
+{
+    struct sysmon_latency lat;
+
+    if (!json) {
+        cmd_printf(reply, "latency(us) <1 <2 <4 <8 <16 <32 <64 <128 <256 <512 <1k >=1k\n");
+    }
+    for (int i = 0; sysmon_latency_get(i, &lat) == RT_EOK; i++) {
+        rt_uint32_t mean = lat.count > 0 ? (rt_uint32_t)(lat.sum_us / lat.count) : 0;
+        if (json) {
+            cmd_printf(reply, "%s{\"name\":\"%.*s\",\"count\":%u,\"mean_us\":%u,\"max_us\":%u,\"hist\":[",
+                       i > 0 ? "," : "", RT_NAME_MAX, lat.name, lat.count, mean, lat.max_us);
+            for (int b = 0; b < SYSMON_HIST_BUCKETS; b++) {
+                cmd_printf(reply, b > 0 ? ",%u" : "%u", lat.hist[b]);
+            }
+            cmd_printf(reply, "]}");
+        } else {
+            cmd_printf(reply, "%-*.*s n=%u mean=%u max=%u:", RT_NAME_MAX, RT_NAME_MAX, lat.name,
+                       lat.count, mean, lat.max_us);
+            for (int b = 0; b < SYSMON_HIST_BUCKETS; b++) {
+                cmd_printf(reply, " %u", lat.hist[b]);
+            }
+            cmd_printf(reply, "\n");
+        }
+    }
+}
+
+enum
+{
+    TOP_HIST,
+    TOP_LAT,
+    TOP_UNLAT,
+    TOP_CLEAR,
+};
+
+static const struct cmd_option top_options[] =
+{
+    [TOP_HIST]  = { "-hist", "" },
+    [TOP_LAT]   = { "-lat", "s" },
+    [TOP_UNLAT] = { "-unlat", "s" },
+    [TOP_CLEAR] = { "-clear", "" },
+    { RT_NULL, RT_NULL },
+};
+
+/*
+ * top                  上一次调用以来各线程/中断的CPU占用率和切入频率
+ * top -hist            被测线程的唤醒延迟直方图
+ * top -lat <thread>    开始统计该线程的唤醒延迟, -unlat 停止
+ * top -clear           清零延迟直方图
+ */
+static rt_err_t top_cmd(const struct cmd_args *args, struct cmd_reply *reply)
+{
+    rt_bool_t json = (reply->flags & CMD_REPLY_JSON) != 0;
+
+    if (cmd_has(args, TOP_LAT)) {
+        rt_err_t err = sysmon_latency_add(args->opt[TOP_LAT][0].s);
+        if (err != RT_EOK) {
+            cmd_printf(reply, "Error: Cannot probe %s, at most %d threads.\n",
+                       args->opt[TOP_LAT][0].s, APP_SYSMON_MAX_PROBES);
+            return err;
+        }
+    }
+    if (cmd_has(args, TOP_UNLAT) && sysmon_latency_remove(args->opt[TOP_UNLAT][0].s) != RT_EOK) {
+        cmd_printf(reply, "Error: %s is not probed.\n", args->opt[TOP_UNLAT][0].s);
+        return -RT_EEMPTY;
+    }
+    if (cmd_has(args, TOP_CLEAR)) {
+        sysmon_latency_clear();
+    }
+    if (cmd_has(args, TOP_HIST)) {
+        if (json) cmd_printf(reply, "{\"latency\":[");
+        top_print_latency(reply, json);
+        if (json) cmd_printf(reply, "]}");
+        return RT_EOK;
+    }
+    if (args->present != 0) {
+        if (!json) cmd_printf(reply, "OK\n");
+        return RT_EOK;
+    }
+
+    rt_uint16_t irq;
+    rt_mutex_take(&top_lock, RT_WAITING_FOREVER);
+    rt_tick_t now = rt_tick_get();
+    rt_uint32_t interval_ms = (now - top_last_tick) * 1000 / RT_TICK_PER_SECOND;
+    top_last_tick = now;
+    int rows = top_snapshot(&irq);
+    if (interval_ms == 0) interval_ms = 1;
+
+    if (json) {
+        cmd_printf(reply, "{\"interval_ms\":%u,\"irq\":%u.%u,\"threads\":[", interval_ms, irq / 10, irq % 10);
+    } else {
+        cmd_printf(reply, "interval %u ms, irq %u.%u%%\n", interval_ms, irq / 10, irq % 10);
+        cmd_printf(reply, "%-*s pri  cpu%%   sw/s\n", RT_NAME_MAX, "thread");
+    }
+    for (int i = 0; i < rows; i++) {
+        const struct top_row *r = &top_rows[i];
+        rt_uint32_t rate = (rt_uint32_t)((rt_uint64_t)r->switches * 1000 / interval_ms);
+        if (json) {
+            cmd_printf(reply, "%s{\"n\":\"%.*s\",\"p\":%u,\"cpu\":%u.%u,\"sw\":%u}", i > 0 ? "," : "",
+                       RT_NAME_MAX, r->name, r->priority, r->permille / 10, r->permille % 10, rate);
+        } else {
+            cmd_printf(reply, "%-*.*s %3u %3u.%u %6u\n", RT_NAME_MAX, RT_NAME_MAX, r->name,
+                       r->priority, r->permille / 10, r->permille % 10, rate);
+        }
+    }
+    rt_mutex_release(&top_lock);
+    if (json) cmd_printf(reply, "]}");
+    return RT_EOK;
+}
+
+#ifdef APP_SYSMON_HEAP_AUDIT
+/* 标记之后的堆操作计数, 在分配器钩子里关中断更新 */
+struct heap_audit
+{
+    rt_tick_t mark_tick;
+    rt_size_t mark_used;                // 标记时的堆用量
+    rt_uint32_t allocs;
+    rt_uint32_t frees;
+    rt_uint32_t failed;                 // 返回 RT_NULL 的分配
+    rt_uint64_t bytes;                  // 标记后申请的总字节数
+    rt_size_t last_size;                // 最后一次分配
+    rt_tick_t last_tick;
+    char last_thread[RT_NAME_MAX];
+};
+static struct heap_audit heap_audit;
+
+static void sysmon_malloc_hook(void **ptr, rt_size_t size)
+{
+    rt_thread_t thread = rt_thread_self();
+    rt_base_t level = rt_hw_interrupt_disable();
+
+    heap_audit.allocs++;
+    heap_audit.bytes += size;
+    if (*ptr == RT_NULL) heap_audit.failed++;
+    heap_audit.last_size = size;
+    heap_audit.last_tick = rt_tick_get();
+    rt_strncpy(heap_audit.last_thread, thread != RT_NULL ? thread->parent.name : "-", RT_NAME_MAX);
+    rt_hw_interrupt_enable(level);
+}
+
+static void sysmon_free_hook(void **ptr)
+{
+    if (*ptr == RT_NULL) return;
+    rt_base_t level = rt_hw_interrupt_disable();
+    heap_audit.frees++;
+    rt_hw_interrupt_enable(level);
+}
+
+void sysmon_heap_mark(void)
+{
+    rt_size_t total, used, max_used;
+
+    rt_memory_info(&total, &used, &max_used);
+    rt_base_t level = rt_hw_interrupt_disable();
+    rt_memset(&heap_audit, 0, sizeof(heap_audit));
+    heap_audit.mark_tick = rt_tick_get();
+    heap_audit.mark_used = used;
+    rt_hw_interrupt_enable(level);
+}
+
+static const struct cmd_option heap_options[] =
+{
+    { "-mark", "" },
+    { RT_NULL, RT_NULL },
+};
+
+/*
+ * heap         堆总量/当前用量/水位线, 以及标记之后的分配次数
+ * heap -mark   重新标记, 例如在联网完成之后
+ * 标记之后 allocs 一直为0, 说明运行期间没有从堆上取过内存
+ */
+static rt_err_t heap_cmd(const struct cmd_args *args, struct cmd_reply *reply)
+{
+    rt_size_t total, used, max_used;
+
+    if (cmd_has(args, 0)) {
+        sysmon_heap_mark();
+    }
+    rt_memory_info(&total, &used, &max_used);
+
+    rt_base_t level = rt_hw_interrupt_disable();
+    struct heap_audit a = heap_audit;
+    rt_hw_interrupt_enable(level);
+    rt_uint32_t since_ms = (rt_tick_get() - a.mark_tick) * 1000 / RT_TICK_PER_SECOND;
+    rt_uint32_t last_ms = (a.last_tick - a.mark_tick) * 1000 / RT_TICK_PER_SECOND;
+
+    if (reply->flags & CMD_REPLY_JSON) {
+        cmd_printf(reply, "{\"total\":%u,\"used\":%u,\"max_used\":%u,\"mark_used\":%u,\"since_ms\":%u,"
+                   "\"allocs\":%u,\"frees\":%u,\"failed\":%u,\"bytes\":%u",
+                   (rt_uint32_t)total, (rt_uint32_t)used, (rt_uint32_t)max_used, (rt_uint32_t)a.mark_used,
+                   since_ms, a.allocs, a.frees, a.failed, (rt_uint32_t)a.bytes);
+        if (a.allocs > 0) {
+            cmd_printf(reply, ",\"last\":{\"size\":%u,\"thread\":\"%.*s\",\"at_ms\":%u}",
+                       (rt_uint32_t)a.last_size, RT_NAME_MAX, a.last_thread, last_ms);
+        }
+        cmd_printf(reply, "}");
+        return RT_EOK;
+    }
+    cmd_printf(reply, "heap total %u, used %u, max used %u\n",
+               (rt_uint32_t)total, (rt_uint32_t)used, (rt_uint32_t)max_used);
+    cmd_printf(reply, "since mark (%u ms, used %u): %u allocs (%u bytes, %u failed), %u frees\n",
+               since_ms, (rt_uint32_t)a.mark_used, a.allocs, (rt_uint32_t)a.bytes, a.failed, a.frees);
+    if (a.allocs > 0) {
+        cmd_printf(reply, "last alloc %u bytes by %.*s at +%u ms\n",
+                   (rt_uint32_t)a.last_size, RT_NAME_MAX, a.last_thread, last_ms);
+    }
+    return RT_EOK;
+}
+#endif /* APP_SYSMON_HEAP_AUDIT */
+
+static const struct cmd_def sysmon_cmd_defs[] =
+{
+    { "top", "top [-hist] [-lat <thread>] [-unlat <thread>] [-clear]", top_options, RT_NULL, 0, 0, top_cmd },
+#ifdef APP_SYSMON_HEAP_AUDIT
+    { "heap", "heap [-mark]", heap_options, RT_NULL, 0, 0, heap_cmd },
+#endif
+};
+
+static struct cmd_table sysmon_cmds = { sysmon_cmd_defs, sizeof(sysmon_cmd_defs) / sizeof(sysmon_cmd_defs[0]), RT_NULL };
+
+/* 在应用初始化阶段装钩子, 此前的运行时间都记在第一个线程 (main) 名下 */
+static int sysmon_init(void)
+{
+#ifdef BSP_USING_TICKLESS
+    cycles_per_us = (rt_uint32_t)(rt_ktime_cputimer_getfrq() / 1000000);
+#else
+    rt_uint64_t us = clock_cpu_microsecond(1000000);
+
+    cycles_per_us = us > 0 ? (rt_uint32_t)(1000000 / us) : 1;
+#endif
+    if (cycles_per_us == 0) cycles_per_us = 1;
+    rt_mutex_init(&top_lock, "top", RT_IPC_FLAG_PRIO);
+
+    rt_base_t level = rt_hw_interrupt_disable();
+    current = entry_lookup(rt_thread_self());
+    slice_start = sysmon_stamp();
+    top_last_tick = rt_tick_get();
+    rt_hw_interrupt_enable(level);
+
+    sysmon_latency_add(APP_SYSMON_LATENCY_THREAD);
+
+    rt_scheduler_sethook(sysmon_scheduler_hook);
+    rt_interrupt_enter_sethook(sysmon_irq_enter_hook);
+    rt_interrupt_leave_sethook(sysmon_irq_leave_hook);
+    rt_object_put_sethook(sysmon_object_put_hook);
+    rt_timer_enter_sethook(sysmon_timer_enter_hook);
+    rt_thread_resume_sethook(sysmon_resume_hook);
+#ifdef APP_SYSMON_HEAP_AUDIT
+    sysmon_heap_mark();
+    rt_malloc_sethook(sysmon_malloc_hook);
+    rt_free_sethook(sysmon_free_hook);
+#endif
+
+    cmd_register(&sysmon_cmds);
+    return 0;
+}
+INIT_APP_EXPORT(sysmon_init);
+
+CMD_MSH_EXPORT(top, Per-thread CPU usage and wakeup latency);
+#ifdef APP_SYSMON_HEAP_AUDIT
+CMD_MSH_EXPORT(heap, Heap watermark and allocations since boot);
+#endif
@@ -0,0 +1,56 @@
+#ifndef __SYSMON_H__
+#define __SYSMON_H__
+
+#include <rtthread.h>
+
+/*
+ * 系统监视: 按线程统计CPU时间, 统计中断时间, 统计指定线程从唤醒到运行的延迟
+ *  - 挂在调度器/中断进出/IPC释放/定时器超时的钩子上, 时间戳取 DWT 周期计数,
+ *    打开 tickless 时取 1MHz 的 ktime cputimer 计数 (WFI 休眠时 DWT 停止)
+ *    每次线程切换只做一次查表和几次加法, 可以在正式固件中一直打开
+ *  - 中断时间单独统计, 不计入被中断的线程
+ *  - 唤醒时刻: 信号量/互斥量/邮箱/消息队列释放时该线程排在等待队列首位,
+ *    或该线程的内置定时器 (rt_thread_mdelay / 等待超时) 到期, 或 rt_thread_resume
+ *    切入该线程时记一次延迟, 按微秒的 log2 分桶计入直方图
+ *  - 统计表和直方图都是静态的, 不分配内存; 线程数超过表长时多出的线程合并为一项
+ * 时间戳为32位, 两次线程切换之间不能超过一个回绕周期 (DWT 96MHz 时约44秒, 1MHz 时约71分钟)
+ */
+
+#define SYSMON_HIST_BUCKETS     12      // [0,1) [1,2) [2,4) ... [512,1024) [1024,∞) us
+
+struct sysmon_latency
+{
+    char name[RT_NAME_MAX];             // 被测线程名
+    rt_uint32_t count;                  // 样本数
+    rt_uint32_t max_us;
+    rt_uint64_t sum_us;
+    rt_uint32_t hist[SYSMON_HIST_BUCKETS];
+};
+
+/**
+ * @brief 开始统计指定线程的唤醒延迟, 线程还不存在时在它第一次运行时开始
+ * @return RT_EOK 成功; -RT_EFULL 被测线程已满; -RT_EINVAL 名字为空
+ */
+rt_err_t sysmon_latency_add(const char *name);
+
+/* 停止统计指定线程的唤醒延迟, 清除其直方图 */
+rt_err_t sysmon_latency_remove(const char *name);
+
+/* 清零所有直方图, 被测线程不变 */
+void sysmon_latency_clear(void);
+
+/**
+ * @brief 取第 index 个被测线程的延迟统计
+ * @return RT_EOK 成功; -RT_EEMPTY 没有这一项
+ */
+rt_err_t sysmon_latency_get(int index, struct sysmon_latency *lat);
+
+#ifdef APP_SYSMON_HEAP_AUDIT
+/*
+ * 堆审计: 记下此刻的堆用量并清零分配计数, 之后的每次 rt_malloc/rt_free 都计数,
+ * 并记住最后一次分配的大小和调用线程; main() 初始化完成时调用一次
+ */
+void sysmon_heap_mark(void);
+#endif
+
+#endif /* __SYSMON_H__ */
@@ -1,35 +1,322 @@
 #include <rtthread.h>
 #include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
 #include <netdb.h>
 #include <string.h>
 #include <sys/errno.h>
 #include <stdio.h>
 #include "system_vars.h"
+#include "cmd.h"
 
 #define SERVER_PORT     5000    // 服务器监听的端口
+#define MAX_CLIENTS     3       // 同时连接的客户端数 (lwIP共4个TCP PCB, 留一个给正在关闭的连接)
 #define RECV_BUFSZ      128     // 接收缓冲区大小
-#define SEND_BUFSZ      512     // 发送缓冲区大小
+#define LINE_BUFSZ      128     // 每个连接的命令行重组缓冲区大小
+#define SEND_BUFSZ      1024    // 发送缓冲区大小
 #define MAX_ARGS        8       // 命令行参数最大数量
+#define REPLY_SEND_TIMEOUT_MS 500 // 文本回复等待发送缓冲区腾出空间的最长时间
+#define SERVER_STACK_SIZE 2560  // 服务器线程栈大小
 
-// 声明在main.c中定义的函数
-extern float get_feedforward_speed(float target_height);
+/*
+ * 流式遥测批格式 (小端序):
+ *   [0xAA][0x55][type=0x01][count]  后接 count 个 struct telemetry_frame
+ * 文本回复总以可打印字符开头、以 \r\n 结尾, 客户端据首字节 0xAA 区分两者
+ */
+#define STREAM_SYNC0        0xAA
+#define STREAM_SYNC1        0x55
+#define STREAM_TYPE_FRAMES  0x01
+#define STREAM_BATCH_FRAMES 16      // 每批最多帧数
+#define STREAM_FLUSH_MS     20      // 打包发送的间隔 (ms)
+
+/*
+ * 每个连接的状态
+ * 背压: 发送缓冲区满 (不可写) 的连接暂停读取命令, 由TCP窗口把压力传回客户端;
+ *       流式遥测帧对这类连接直接丢弃, 不阻塞其他连接
+ */
+struct remote_client
+{
+    int sock;                   // -1 表示空闲
+    rt_bool_t streaming;
+    rt_bool_t overflow;         // 当前行超长, 丢弃到下一个换行为止
+    rt_size_t len;              // 行缓冲中已有的字节数
+    rt_uint32_t stream_dropped; // 因发送缓冲区满而丢弃的遥测帧数
+    char line[LINE_BUFSZ];
+};
+
+struct stream_batch
+{
+    rt_uint8_t sync[2];
+    rt_uint8_t type;
+    rt_uint8_t count;
+    struct telemetry_frame frames[STREAM_BATCH_FRAMES];
+};
+
+/* 线程和缓冲区都放在静态区, 启动服务器不分配堆内存; 服务器线程栈只需容纳局部变量和 fd_set */
+static struct rt_thread server_thread;
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t server_stack[SERVER_STACK_SIZE];
+static rt_bool_t server_started = RT_FALSE;
+static struct remote_client clients[MAX_CLIENTS];
+static struct stream_batch batch;
+static char recv_buf[RECV_BUFSZ];
+static char send_buf[SEND_BUFSZ];
+
+/**
+ * @brief 把一条文本回复完整写入非阻塞套接字
+ *        只写出一部分后接着发流式遥测批会打乱代理端的文本/二进制分帧,
+ *        所以短写和 EAGAIN 时等待可写后继续, 超时或出错返回 -1 由调用者断开连接
+ * @return 0 全部写出, -1 失败
+ */
+static int client_send(struct remote_client *c, const char *data, int len)
+{
+    rt_tick_t deadline = rt_tick_get() + rt_tick_from_millisecond(REPLY_SEND_TIMEOUT_MS);
+
+    while (len > 0)
+    {
+        int sent = send(c->sock, data, len, 0);
+        if (sent > 0) {
+            data += sent;
+            len -= sent;
+            continue;
+        }
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            break;
+        }
+
+        rt_int32_t left = (rt_int32_t)(deadline - rt_tick_get());
+        if (left <= 0) {
+            break;
+        }
+        fd_set writeset;
+        struct timeval timeout = { 0, left * 1000000 / RT_TICK_PER_SECOND };
+        FD_ZERO(&writeset);
+        FD_SET(c->sock, &writeset);
+        if (select(c->sock + 1, RT_NULL, &writeset, RT_NULL, &timeout) <= 0) {
+            break;
+        }
+    }
+
+    if (len > 0) {
+        rt_kprintf("[Remote] Reply send failed, closing client.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int client_send_text(struct remote_client *c, const char *text)
+{
+    return client_send(c, text, strlen(text));
+}
+
+static rt_bool_t stream_has_subscribers(void)
+{
+    for (int n = 0; n < MAX_CLIENTS; n++) {
+        if (clients[n].sock >= 0 && clients[n].streaming) return RT_TRUE;
+    }
+    return RT_FALSE;
+}
+
+/* 订阅/退订流式遥测, 只在第一个订阅者加入或最后一个退出时开关遥测源 */
+static void stream_subscribe(struct remote_client *c, rt_bool_t on)
+{
+    rt_bool_t before = stream_has_subscribers();
+    c->streaming = on;
+    rt_bool_t after = stream_has_subscribers();
+    if (before != after) {
+        telemetry_stream_enable(after);
+    }
+}
+
+static void client_close(struct remote_client *c)
+{
+    if (c->stream_dropped) {
+        rt_kprintf("[Remote] Client dropped %d stream frames due to backpressure.\n", c->stream_dropped);
+    }
+    stream_subscribe(c, RT_FALSE);
+    closesocket(c->sock);
+    c->sock = -1;
+}
+
+/**
+ * @brief 执行一条完整的命令行
+ * @param c    发出命令的连接
+ * @param line 以 '\0' 结尾的命令行, 会被 strtok_r 修改
+ * @return 0 正常, -1 回复发送失败
+ */
+static int client_execute(struct remote_client *c, char *line)
+{
+    char *argv[MAX_ARGS]; // 用于存放分割后的命令参数指针
+    int argc = 0;
+    char *saveptr; // for strtok_r
+    char *ptr = strtok_r(line, " ", &saveptr);
+    while (ptr != NULL && argc < MAX_ARGS) {
+        argv[argc++] = ptr;
+        ptr = strtok_r(NULL, " ", &saveptr);
+    }
+
+    if (argc == 0) {
+        return 0; // 空命令
+    }
+
+    /* stream 只对本连接有效, 其余命令交给与 FinSH 共用的命令表, 回复只发给本客户端 */
+    if (strcmp(argv[0], "stream") == 0)
+    {
+        // stream on|off: 打开后每个控制周期一帧, 按批推送
+        if (argc == 2 && strcmp(argv[1], "on") == 0) {
+            stream_subscribe(c, RT_TRUE);
+        } else if (argc == 2 && strcmp(argv[1], "off") == 0) {
+            stream_subscribe(c, RT_FALSE);
+        } else {
+            return client_send_text(c, "ERROR: Usage: stream on|off\r\n");
+        }
+        snprintf(send_buf, sizeof(send_buf), "OK: stream %s\r\n", c->streaming ? "on" : "off");
+        return client_send_text(c, send_buf);
+    }
+
+    /* 末尾预留 \r\n 的位置 */
+    struct cmd_reply reply = { send_buf, sizeof(send_buf) - 2, 0, CMD_REPLY_JSON };
+    send_buf[0] = '\0';
+    cmd_execute(argc, argv, RT_TRUE, &reply);
+    if (reply.len == 0) {
+        cmd_printf(&reply, "OK");
+    }
+    if (send_buf[reply.len - 1] == '\n') {
+        reply.len--;
+    }
+    send_buf[reply.len++] = '\r';
+    send_buf[reply.len++] = '\n';
+    return client_send(c, send_buf, reply.len);
+}
+
+/**
+ * @brief 读取一次连接上的数据, 按 \r 或 \n 重组成完整的命令行后逐条执行
+ * @return 0 正常, -1 连接已关闭、出错或回复未能完整发出
+ */
+static int client_receive(struct remote_client *c)
+{
+    int bytes_received = recv(c->sock, recv_buf, RECV_BUFSZ, 0);
+    if (bytes_received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if (bytes_received <= 0) {
+        return -1;
+    }
 
-static rt_thread_t server_thread = RT_NULL;
+    for (int n = 0; n < bytes_received; n++)
+    {
+        char ch = recv_buf[n];
+        if (ch == '\r' || ch == '\n')
+        {
+            int err = 0;
+            if (c->overflow) {
+                err = client_send_text(c, "ERROR: Command too long.\r\n");
+            } else if (c->len > 0) {
+                c->line[c->len] = '\0';
+                err = client_execute(c, c->line);
+            }
+            c->len = 0;
+            c->overflow = RT_FALSE;
+            if (err < 0) {
+                return -1;
+            }
+        }
+        else if (c->len < LINE_BUFSZ - 1)
+        {
+            c->line[c->len++] = ch;
+        }
+        else
+        {
+            c->overflow = RT_TRUE;
+        }
+    }
+    return 0;
+}
 
 /**
- * @brief TCP服务器线程入口函数
+ * @brief 把缓冲区中所有待发的遥测帧分批发送给所有订阅的连接
+ * @param writable 本轮可写的连接
+ */
+static void stream_flush(const fd_set *writable)
+{
+    while (1)
+    {
+        rt_size_t count = telemetry_stream_read(batch.frames, STREAM_BATCH_FRAMES);
+        if (count == 0) {
+            return;
+        }
+        batch.sync[0] = STREAM_SYNC0;
+        batch.sync[1] = STREAM_SYNC1;
+        batch.type = STREAM_TYPE_FRAMES;
+        batch.count = (rt_uint8_t)count;
+        int len = 4 + count * sizeof(struct telemetry_frame);
+
+        for (int n = 0; n < MAX_CLIENTS; n++)
+        {
+            struct remote_client *c = &clients[n];
+            if (c->sock < 0 || !c->streaming) continue;
+            if (!FD_ISSET(c->sock, writable)) {
+                c->stream_dropped += count;
+                continue;
+            }
+
+            int sent = send(c->sock, &batch, len, 0);
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                c->stream_dropped += count;
+            } else if (sent != len) {
+                /* 只发出半批会破坏帧边界, 无法恢复, 断开该连接 */
+                rt_kprintf("[Remote] Stream send failed, closing client.\n");
+                client_close(c);
+            }
+        }
+    }
+}
+
+static void server_accept(int sock)
+{
+    struct sockaddr_in client_addr;
+    socklen_t sin_size = sizeof(struct sockaddr_in);
+
+    int connected = accept(sock, (struct sockaddr *)&client_addr, &sin_size);
+    if (connected < 0)
+    {
+        rt_kprintf("[Remote] Accept connection failed! errno = %d\n", errno);
+        return;
+    }
+
+    for (int n = 0; n < MAX_CLIENTS; n++)
+    {
+        struct remote_client *c = &clients[n];
+        if (c->sock >= 0) continue;
+
+        int nonblock = 1;
+        ioctlsocket(connected, FIONBIO, &nonblock);
+        c->sock = connected;
+        c->streaming = RT_FALSE;
+        c->overflow = RT_FALSE;
+        c->len = 0;
+        c->stream_dropped = 0;
+        rt_kprintf("[Remote] Got a connection from (%s, %d), slot %d\n",
+                   inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), n);
+        return;
+    }
+
+    /* 监听套接字只在有空位时加入读集合, 正常不会走到这里 */
+    closesocket(connected);
+}
+
+/**
+ * @brief TCP服务器线程入口函数, 单线程用 select 同时服务多个客户端
  * @param parameter 线程参数 (未使用)
  */
 static void remote_server_thread_entry(void *parameter)
 {
-    int sock, connected;
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t sin_size;
-    
-    char recv_buf[RECV_BUFSZ];
-    char send_buf[SEND_BUFSZ];
-    char *argv[MAX_ARGS]; // 用于存放分割后的命令参数指针
-    int argc;
+    int sock;
+    struct sockaddr_in server_addr;
+    rt_tick_t next_flush = rt_tick_get();
+
+    for (int n = 0; n < MAX_CLIENTS; n++) {
+        clients[n].sock = -1;
+    }
 
     if ((sock = socket(AF_INET, SOCK_STREAM, 0)) == -1)
     {
@@ -48,104 +335,69 @@ static void remote_server_thread_entry(void *parameter)
         goto __exit;
     }
 
-    if (listen(sock, 5) == -1)
+    if (listen(sock, MAX_CLIENTS) == -1)
     {
         rt_kprintf("[Remote] Listen error\n");
         goto __exit;
     }
 
-    rt_kprintf("[Remote] TCP Server waiting for client on port %d...\n", SERVER_PORT);
+    rt_kprintf("[Remote] TCP Server waiting for clients on port %d...\n", SERVER_PORT);
 
     while (1)
     {
-        sin_size = sizeof(struct sockaddr_in);
-        
-        // 接受客户端连接 (阻塞)
-        connected = accept(sock, (struct sockaddr *)&client_addr, &sin_size);
-        if (connected < 0)
+        fd_set readset, writeset;
+        struct timeval timeout = { 0, 0 };
+        int maxfd = sock;
+        rt_bool_t has_free_slot = RT_FALSE;
+
+        /* 先用零超时查询哪些连接可写, 不可写的连接本轮不读取 (背压) */
+        FD_ZERO(&writeset);
+        for (int n = 0; n < MAX_CLIENTS; n++)
         {
-            rt_kprintf("[Remote] Accept connection failed! errno = %d\n", errno);
-            continue;
+            if (clients[n].sock < 0) { has_free_slot = RT_TRUE; continue; }
+            FD_SET(clients[n].sock, &writeset);
+            if (clients[n].sock > maxfd) maxfd = clients[n].sock;
+        }
+        if (maxfd != sock && select(maxfd + 1, RT_NULL, &writeset, RT_NULL, &timeout) < 0) {
+            FD_ZERO(&writeset);
         }
-        rt_kprintf("[Remote] Got a connection from (%s, %d)\n", inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
 
-        // 与客户端交互循环
-        while (1)
+        FD_ZERO(&readset);
+        if (has_free_slot) FD_SET(sock, &readset);
+        for (int n = 0; n < MAX_CLIENTS; n++)
         {
-            int bytes_received = recv(connected, recv_buf, RECV_BUFSZ - 1, 0);
-            if (bytes_received <= 0)
-            {
-                rt_kprintf("[Remote] Client disconnected or recv error.\n");
-                closesocket(connected);
-                break;
+            if (clients[n].sock >= 0 && FD_ISSET(clients[n].sock, &writeset)) {
+                FD_SET(clients[n].sock, &readset);
             }
+        }
 
-            recv_buf[bytes_received] = '\0';
-            char* p = strpbrk(recv_buf, "\r\n");
-            if (p) *p = '\0'; // 去掉换行符
-            // for (int i = 0; i < bytes_received; i++) {
-            //     if (recv_buf[i] == '\r' || recv_buf[i] == '\n') {
-            //         recv_buf[i] = '\0';
-            //     }
-            // }
-            // rt_kprintf("[Remote] Received command: '%s'\n", recv_buf);
-            argc = 0;
-            char *saveptr; // for strtok_r
-            char *ptr = strtok_r(recv_buf, " ", &saveptr);
-            while (ptr != NULL && argc < MAX_ARGS) {
-                argv[argc++] = ptr;
-                ptr = strtok_r(NULL, " ", &saveptr);
-            }
- 
-            if (argc == 0) {
-                continue; // 空命令
+        /* 等待命令, 最迟到下一次遥测打包时刻 */
+        rt_tick_t now = rt_tick_get();
+        rt_tick_t wait = (rt_int32_t)(next_flush - now) > 0 ? next_flush - now : 0;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = wait * 1000000 / RT_TICK_PER_SECOND;
+        int ready = select(maxfd + 1, &readset, RT_NULL, RT_NULL, &timeout);
+
+        if (ready > 0)
+        {
+            if (FD_ISSET(sock, &readset)) {
+                server_accept(sock);
             }
- 
-            // --- 根据第一个参数分发命令 ---
-            if (strcmp(argv[0], "get_status") == 0)
+            for (int n = 0; n < MAX_CLIENTS; n++)
             {
-                // 格式化JSON字符串
-                sprintf(send_buf, "{"
-                    "\"current_height\":%ld,"
-                    "\"target_height\":%.2f,"
-                    "\"ramped_height\":%.2f,"
-                    "\"pid_kp\":%.6f,"
-                    "\"pid_ki\":%.6f,"
-                    "\"pid_kd\":%.6f,"
-                    "\"integral_error\":%.4f,"
-                    "\"previous_error\":%.4f,"
-                    "\"feedforward_speed\":%.4f,"
-                    "\"is_evaluating\":%s,"
-                    "\"total_abs_error\":%.4f"
-                    "}\r\n",
-                    current_height,
-                    target_height, ramped_height,
-                    KP, KI, KD,
-                    integral_error, previous_error,
-                    get_feedforward_speed(ramped_height),
-                    is_evaluating ? "true" : "false",
-                    total_abs_error);
-                // 发送响应
-                if (send(connected, send_buf, strlen(send_buf), 0) < 0) {
-                    rt_kprintf("[Remote] Send response failed.\n");
-                    closesocket(connected);
-                    break;
+                struct remote_client *c = &clients[n];
+                if (c->sock < 0 || !FD_ISSET(c->sock, &readset)) continue;
+                if (client_receive(c) < 0) {
+                    rt_kprintf("[Remote] Client %d disconnected or recv error.\n", n);
+                    client_close(c);
                 }
             }
-            else if (strcmp(argv[0], "pid_tune") == 0)
-            {         
-                pid_tune(argc, argv);
- 
-                char ok_msg[100];
-                sprintf(ok_msg, "OK: '%s' command executed.\r\n", argv);
-                send(connected, ok_msg, strlen(ok_msg), 0);
-            }
-            else
-            {
-                // 对于未知命令，发送错误信息
-                sprintf(send_buf, "ERROR: Unknown command '%s'.\r\n", argv[0]);
-                send(connected, send_buf, strlen(send_buf), 0);
-            }
+        }
+
+        if ((rt_int32_t)(rt_tick_get() - next_flush) >= 0)
+        {
+            next_flush = rt_tick_get() + rt_tick_from_millisecond(STREAM_FLUSH_MS);
+            stream_flush(&writeset);
         }
     }
 
@@ -159,28 +411,22 @@ __exit:
  */
 static void remote_start(int argc, char **argv)
 {
-    if (server_thread != RT_NULL)
+    if (server_started)
     {
         rt_kprintf("[Remote] Server is already running.\n");
         return;
     }
 
-    server_thread = rt_thread_create("RemoteTCPSrv",
-                                     remote_server_thread_entry,
-                                     RT_NULL,
-                                     2560,
-                                     12,
-                                     20);
-
-    if (server_thread != RT_NULL)
+    if (rt_thread_init(&server_thread, "RemoteTCPSrv", remote_server_thread_entry, RT_NULL,
+                       server_stack, sizeof(server_stack), 12, 20) == RT_EOK)
     {
-        rt_thread_startup(server_thread);
+        server_started = RT_TRUE;
+        rt_thread_startup(&server_thread);
         rt_kprintf("[Remote] TCP server started successfully.\n");
     }
     else
     {
-        rt_kprintf("[Remote] Failed to create TCP server thread.\n");
+        rt_kprintf("[Remote] Failed to init TCP server thread.\n");
     }
 }
 MSH_CMD_EXPORT(remote_start, Start the remote control TCP server);
-
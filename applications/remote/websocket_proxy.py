@@ -1,5 +1,6 @@
 import asyncio
 import json
+import struct
 import websockets
 
 # 板子的TCP服务器地址和端口
@@ -10,51 +11,93 @@ TCP_SERVER_PORT = 5000
 WS_SERVER_IP = "0.0.0.0"
 WS_SERVER_PORT = 8765
 
+# 流式遥测: 批头 [0xAA][0x55][type][count] + count 个帧, 帧布局见 telemetry.h 中的 struct telemetry_frame
+STREAM_SYNC = b"\xaa\x55"
+STREAM_TYPE_FRAMES = 0x01
+STREAM_HEADER_SIZE = 4
+FRAME = struct.Struct("<IIi6f")
+FRAME_FIELDS = ("seq", "tick", "height", "setpoint", "p", "i", "d", "ff", "duty")
+
+# 打开流式遥测后 get_status 只用来刷新增益、误差等低频字段
+STATUS_POLL_INTERVAL = 1.0
+
 # 全局共享资源
 clients = set()
 tcp_writer = None
 
+async def broadcast(message):
+    if clients:
+        await asyncio.gather(
+            *[client.send(message) for client in clients if client.open]
+        )
+
+
+def parse_messages(buffer):
+    """
+    从接收缓冲区中切出所有完整的消息
+    返回 (消息列表, 剩余缓冲区), 消息为 ("stream", 帧列表) 或 ("text", 字符串)
+    """
+    messages = []
+    while buffer:
+        if buffer[0] == STREAM_SYNC[0]:
+            if len(buffer) < STREAM_HEADER_SIZE:
+                break
+            if buffer[1] != STREAM_SYNC[1] or buffer[2] != STREAM_TYPE_FRAMES:
+                buffer = buffer[1:]     # 失步, 丢弃一个字节重新同步
+                continue
+            size = STREAM_HEADER_SIZE + buffer[3] * FRAME.size
+            if len(buffer) < size:
+                break
+            frames = [dict(zip(FRAME_FIELDS, FRAME.unpack_from(buffer, STREAM_HEADER_SIZE + n * FRAME.size)))
+                      for n in range(buffer[3])]
+            messages.append(("stream", frames))
+            buffer = buffer[size:]
+        else:
+            end = buffer.find(b"\r\n")
+            if end == -1:
+                break
+            messages.append(("text", buffer[:end].decode("utf-8", errors="ignore")))
+            buffer = buffer[end + 2:]
+    return messages, buffer
+
+
 async def tcp_communication_manager():
     """
     维持一个到TCP服务器的持久连接
     """
     global tcp_writer
-    buffer = ""
     while True:
+        buffer = b""
         try:
             reader, writer = await asyncio.open_connection(TCP_SERVER_IP, TCP_SERVER_PORT)
             tcp_writer = writer
             print(f"Successfully connected to TCP server at {TCP_SERVER_IP}:{TCP_SERVER_PORT}")
 
-            # 启动一个独立的任务来定期请求状态
+            # 打开逐周期的二进制遥测, 再启动一个独立的任务低频请求完整状态
+            writer.write(b"stream on\r\n")
+            await writer.drain()
             asyncio.create_task(request_status_periodically())
 
             while True:
-                data = await reader.read(1024)
+                data = await reader.read(4096)
                 if not data:
                     print("TCP server closed the connection. Reconnecting...")
                     tcp_writer = None
                     break
-                
-                buffer += data.decode('utf-8', errors='ignore')
 
-                # 处理缓冲区中所有完整的消息
-                while '\r\n' in buffer:
-                    message, buffer = buffer.split('\r\n', 1)
+                messages, buffer = parse_messages(buffer + data)
+                for kind, payload in messages:
+                    if kind == "stream":
+                        await broadcast(json.dumps({"type": "stream", "frames": payload}))
+                        continue
                     try:
-                        json_start = message.find('{')
+                        json_start = payload.find('{')
                         if json_start != -1:
-                            json_message = message[json_start:]
-                            status = json.loads(json_message)
-                            
-                            if status and clients:
-                                broadcast_message = json.dumps(status)
-                                await asyncio.gather(
-                                    *[client.send(broadcast_message) for client in clients if client.open]
-                                )
+                            status = json.loads(payload[json_start:])
+                            if status:
+                                await broadcast(json.dumps(status))
                     except json.JSONDecodeError:
                         # 忽略无法解析的行，因为它们可能是命令的响应而不是状态JSON
-                        # print(f"Ignoring non-JSON message or parse error: {e}, Message: '{message}'")
                         pass
 
         except (ConnectionRefusedError, OSError) as e:
@@ -77,7 +120,7 @@ async def request_status_periodically():
                 print(f"Error sending get_status: {e}")
                 # 连接可能已损坏，等待主循环处理重连
                 break 
-        await asyncio.sleep(0.1)
+        await asyncio.sleep(STATUS_POLL_INTERVAL)
 
 
 async def handle_websocket_client(websocket):
@@ -0,0 +1,387 @@
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <string.h>
+#include "kvstore.h"
+
+#define KV_PHRASE           16                      // Flash最小编程单位 (字节), 所有写入按此对齐
+#define KV_SECTOR_MAGIC     0x3153564BUL            // "KVS1"
+#define KV_RECORD_MAGIC     0xA55A
+#define KV_ERASED16         0xFFFF
+
+/* 扇区头, 占扇区开头的一个编程单位, 整理完成后最后写入 */
+struct kv_sector_hdr
+{
+    rt_uint32_t magic;
+    rt_uint32_t seq;
+    rt_uint32_t seq_inv;            // ~seq, 与 magic 一起判断扇区头是否完整
+    rt_uint32_t reserved;
+};
+
+/* 记录头, 后面紧跟键和值, 整条记录补齐到编程单位 */
+struct kv_record_hdr
+{
+    rt_uint16_t magic;
+    rt_uint8_t  key_len;
+    rt_uint8_t  reserved0;
+    rt_uint16_t value_len;
+    rt_uint16_t reserved1;
+    rt_uint32_t crc;                // CRC32, 覆盖 key_len, value_len, 键和值
+};
+
+#define KV_RECORD_SIZE(klen, vlen)  RT_ALIGN(sizeof(struct kv_record_hdr) + (klen) + (vlen), KV_PHRASE)
+#define KV_RECORD_MAX               KV_RECORD_SIZE(KV_MAX_KEY_LEN, KV_MAX_VALUE_LEN)
+
+enum kv_record_state
+{
+    KV_REC_OK,                      // 完整记录
+    KV_REC_TORN,                    // 长度合法但CRC错误, 写到一半掉电, 跳过
+    KV_REC_END,                     // 已擦除, 日志结束
+    KV_REC_BAD,                     // 记录头损坏, 无法得知长度, 扇区后面不再使用
+};
+
+struct kv_entry
+{
+    char key[KV_MAX_KEY_LEN + 1];
+    rt_uint32_t offset;             // 最新记录在扇区内的偏移
+    rt_uint16_t len;                // 值的长度
+};
+
+static struct rt_mtd_nor_device *kv_mtd = RT_NULL;
+static struct rt_mutex kv_lock;
+static rt_uint32_t kv_sector_size;
+static int kv_active;               // 活动扇区 (0/1)
+static rt_uint32_t kv_seq;
+static rt_uint32_t kv_write_off;    // 活动扇区下一条记录的偏移
+static rt_uint32_t kv_torn;
+static struct kv_entry kv_index[KV_MAX_KEYS];
+static int kv_count;
+static void (*kv_gate)(void) = RT_NULL;
+
+/* 记录在这里组装/校验, 编程接口要求源数据字对齐 */
+rt_align(4) static rt_uint8_t kv_buf[KV_RECORD_MAX];
+
+/* 半字节查表的 CRC32 (多项式 0xEDB88320), 表只有64字节 */
+static rt_uint32_t kv_crc32(rt_uint32_t crc, const void *data, rt_size_t len)
+{
+    static const rt_uint32_t table[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const rt_uint8_t *p = data;
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc = table[(crc ^ *p) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (*p >> 4)) & 0x0F] ^ (crc >> 4);
+        p++;
+    }
+    return ~crc;
+}
+
+static rt_uint32_t kv_record_crc(const struct kv_record_hdr *hdr, const rt_uint8_t *payload)
+{
+    rt_uint8_t lens[3] = { hdr->key_len, (rt_uint8_t)hdr->value_len, (rt_uint8_t)(hdr->value_len >> 8) };
+    rt_uint32_t crc = kv_crc32(0, lens, sizeof(lens));
+    return kv_crc32(crc, payload, hdr->key_len + hdr->value_len);
+}
+
+static rt_off_t kv_sector_base(int sector)
+{
+    return (rt_off_t)sector * kv_sector_size;
+}
+
+static rt_err_t kv_flash_erase(int sector)
+{
+    if (kv_gate) kv_gate();
+    return rt_mtd_nor_erase_block(kv_mtd, kv_sector_base(sector), kv_sector_size);
+}
+
+static rt_err_t kv_flash_write(rt_off_t offset, const rt_uint8_t *data, rt_size_t len)
+{
+    if (kv_gate) kv_gate();
+    return rt_mtd_nor_write(kv_mtd, offset, data, len) == (rt_ssize_t)len ? RT_EOK : -RT_EIO;
+}
+
+static rt_bool_t kv_read_sector_hdr(int sector, rt_uint32_t *seq)
+{
+    struct kv_sector_hdr hdr;
+
+    rt_mtd_nor_read(kv_mtd, kv_sector_base(sector), (rt_uint8_t *)&hdr, sizeof(hdr));
+    if (hdr.magic != KV_SECTOR_MAGIC || hdr.seq_inv != ~hdr.seq) {
+        return RT_FALSE;
+    }
+    *seq = hdr.seq;
+    return RT_TRUE;
+}
+
+static rt_err_t kv_write_sector_hdr(int sector, rt_uint32_t seq)
+{
+    struct kv_sector_hdr *hdr = (struct kv_sector_hdr *)kv_buf;
+
+    hdr->magic = KV_SECTOR_MAGIC;
+    hdr->seq = seq;
+    hdr->seq_inv = ~seq;
+    hdr->reserved = 0xFFFFFFFF;
+    return kv_flash_write(kv_sector_base(sector), kv_buf, sizeof(*hdr));
+}
+
+/**
+ * @brief 把扇区内 offset 处的记录读到 kv_buf 并校验
+ * @param size 输出整条记录占用的字节数 (KV_REC_OK / KV_REC_TORN 时有效)
+ */
+static enum kv_record_state kv_read_record(int sector, rt_uint32_t offset, rt_uint32_t *size)
+{
+    struct kv_record_hdr *hdr = (struct kv_record_hdr *)kv_buf;
+
+    if (offset + sizeof(*hdr) > kv_sector_size) return KV_REC_END;
+    rt_mtd_nor_read(kv_mtd, kv_sector_base(sector) + offset, kv_buf, sizeof(*hdr));
+    if (hdr->magic == KV_ERASED16) return KV_REC_END;
+    if (hdr->magic != KV_RECORD_MAGIC || hdr->key_len == 0 || hdr->key_len > KV_MAX_KEY_LEN ||
+        hdr->value_len > KV_MAX_VALUE_LEN) {
+        return KV_REC_BAD;
+    }
+
+    *size = KV_RECORD_SIZE(hdr->key_len, hdr->value_len);
+    if (offset + *size > kv_sector_size) return KV_REC_BAD;
+    rt_mtd_nor_read(kv_mtd, kv_sector_base(sector) + offset + sizeof(*hdr),
+                    kv_buf + sizeof(*hdr), hdr->key_len + hdr->value_len);
+    if (kv_record_crc(hdr, kv_buf + sizeof(*hdr)) != hdr->crc) return KV_REC_TORN;
+    return KV_REC_OK;
+}
+
+static struct kv_entry *kv_find(const char *key)
+{
+    for (int n = 0; n < kv_count; n++) {
+        if (strcmp(kv_index[n].key, key) == 0) return &kv_index[n];
+    }
+    return RT_NULL;
+}
+
+static rt_err_t kv_index_update(const char *key, rt_size_t key_len, rt_uint32_t offset, rt_uint16_t len)
+{
+    char name[KV_MAX_KEY_LEN + 1];
+
+    memcpy(name, key, key_len);
+    name[key_len] = '\0';
+
+    struct kv_entry *entry = kv_find(name);
+    if (entry == RT_NULL) {
+        if (kv_count >= KV_MAX_KEYS) return -RT_EFULL;
+        entry = &kv_index[kv_count++];
+        strcpy(entry->key, name);
+    }
+    entry->offset = offset;
+    entry->len = len;
+    return RT_EOK;
+}
+
+/**
+ * @brief 扫描活动扇区, 建立每个键最新记录的索引并找到日志末尾
+ */
+static void kv_scan(void)
+{
+    rt_uint32_t offset = sizeof(struct kv_sector_hdr);
+    rt_uint32_t size;
+
+    kv_count = 0;
+    kv_torn = 0;
+    while (1)
+    {
+        enum kv_record_state state = kv_read_record(kv_active, offset, &size);
+        if (state == KV_REC_END) break;
+        if (state == KV_REC_BAD) {
+            /* 后面的内容不可信, 下次写入时直接整理到另一个扇区 */
+            rt_kprintf("[KV] Corrupt record at 0x%x, sector will be compacted.\n", offset);
+            offset = kv_sector_size;
+            break;
+        }
+        if (state == KV_REC_TORN) {
+            kv_torn++;
+        } else {
+            struct kv_record_hdr *hdr = (struct kv_record_hdr *)kv_buf;
+            if (kv_index_update((const char *)(hdr + 1), hdr->key_len, offset, hdr->value_len) != RT_EOK) {
+                kv_torn++;
+            }
+        }
+        offset += size;
+    }
+    kv_write_off = offset;
+}
+
+/**
+ * @brief 把所有键的最新记录搬到另一个扇区, 最后写扇区头提交
+ * 提交之前掉电, 新扇区没有有效的头, 旧扇区仍然完整
+ */
+static rt_err_t kv_compact(void)
+{
+    int target = !kv_active;
+    rt_uint32_t offsets[KV_MAX_KEYS];
+    rt_uint32_t offset = sizeof(struct kv_sector_hdr);
+    rt_uint32_t size;
+    int count = 0;
+
+    if (kv_flash_erase(target) != RT_EOK) return -RT_EIO;
+
+    for (int n = 0; n < kv_count; n++)
+    {
+        /* 索引中的记录挂载/写入时已校验过, 这里再校验一次, 损坏的键直接丢弃 */
+        if (kv_read_record(kv_active, kv_index[n].offset, &size) != KV_REC_OK) {
+            rt_kprintf("[KV] Dropping damaged key '%s'.\n", kv_index[n].key);
+            continue;
+        }
+        if (kv_flash_write(kv_sector_base(target) + offset, kv_buf, size) != RT_EOK) return -RT_EIO;
+        kv_index[count] = kv_index[n];
+        offsets[count++] = offset;
+        offset += size;
+    }
+
+    if (kv_write_sector_hdr(target, kv_seq + 1) != RT_EOK) return -RT_EIO;
+
+    for (int n = 0; n < count; n++) {
+        kv_index[n].offset = offsets[n];
+    }
+    kv_count = count;
+    kv_active = target;
+    kv_seq++;
+    kv_write_off = offset;
+    return RT_EOK;
+}
+
+rt_err_t kv_init(const char *mtd_name)
+{
+    rt_uint32_t seq[2];
+    rt_bool_t valid[2];
+
+    kv_mtd = (struct rt_mtd_nor_device *)rt_device_find(mtd_name);
+    if (kv_mtd == RT_NULL || kv_mtd->block_end - kv_mtd->block_start < 2) {
+        rt_kprintf("[KV] MTD device '%s' not found or smaller than 2 sectors.\n", mtd_name);
+        kv_mtd = RT_NULL;
+        return -RT_ERROR;
+    }
+    kv_sector_size = kv_mtd->block_size;
+    rt_mutex_init(&kv_lock, "kv", RT_IPC_FLAG_PRIO);
+
+    valid[0] = kv_read_sector_hdr(0, &seq[0]);
+    valid[1] = kv_read_sector_hdr(1, &seq[1]);
+    if (valid[0] && valid[1]) {
+        /* 序号按差值比较, 回绕后仍能分出新旧 */
+        kv_active = (rt_int32_t)(seq[1] - seq[0]) > 0;
+    } else if (valid[0] || valid[1]) {
+        kv_active = valid[1];
+    } else {
+        /* 两个扇区都没有有效数据, 格式化扇区0 */
+        rt_kprintf("[KV] No valid sector, formatting.\n");
+        kv_active = 0;
+        seq[0] = 1;
+        if (kv_flash_erase(0) != RT_EOK || kv_write_sector_hdr(0, seq[0]) != RT_EOK) {
+            kv_mtd = RT_NULL;
+            return -RT_ERROR;
+        }
+    }
+    kv_seq = seq[kv_active];
+    kv_scan();
+
+    rt_kprintf("[KV] Mounted sector %d (seq %u): %d keys, %u/%u bytes used, %u torn records.\n",
+               kv_active, kv_seq, kv_count, kv_write_off, kv_sector_size, kv_torn);
+    return RT_EOK;
+}
+
+rt_err_t kv_get(const char *key, void *buf, rt_size_t size, rt_size_t *len)
+{
+    rt_err_t ret = RT_EOK;
+
+    if (kv_mtd == RT_NULL) return -RT_EEMPTY;
+
+    rt_mutex_take(&kv_lock, RT_WAITING_FOREVER);
+    struct kv_entry *entry = kv_find(key);
+    if (entry == RT_NULL) {
+        ret = -RT_EEMPTY;
+    } else if (entry->len > size) {
+        ret = -RT_EFULL;
+    } else {
+        rt_off_t data = kv_sector_base(kv_active) + entry->offset + sizeof(struct kv_record_hdr) + strlen(entry->key);
+        rt_mtd_nor_read(kv_mtd, data, buf, entry->len);
+        if (len) *len = entry->len;
+    }
+    rt_mutex_release(&kv_lock);
+    return ret;
+}
+
+rt_err_t kv_set(const char *key, const void *value, rt_size_t len)
+{
+    struct kv_record_hdr *hdr = (struct kv_record_hdr *)kv_buf;
+    rt_size_t key_len = strlen(key);
+    rt_uint32_t size;
+    rt_err_t ret = RT_EOK;
+
+    if (kv_mtd == RT_NULL) return -RT_ERROR;
+    if (key_len == 0 || key_len > KV_MAX_KEY_LEN || len > KV_MAX_VALUE_LEN) return -RT_EINVAL;
+
+    rt_mutex_take(&kv_lock, RT_WAITING_FOREVER);
+
+    /* 值没有变化时不写, 减少擦写次数 */
+    struct kv_entry *entry = kv_find(key);
+    if (entry != RT_NULL && entry->len == len &&
+        kv_read_record(kv_active, entry->offset, &size) == KV_REC_OK &&
+        memcmp(kv_buf + sizeof(*hdr) + key_len, value, len) == 0) {
+        goto _exit;
+    }
+    if (entry == RT_NULL && kv_count >= KV_MAX_KEYS) {
+        ret = -RT_EFULL;
+        goto _exit;
+    }
+
+    size = KV_RECORD_SIZE(key_len, len);
+    if (kv_write_off + size > kv_sector_size) {
+        ret = kv_compact();
+        if (ret != RT_EOK) goto _exit;
+        if (kv_write_off + size > kv_sector_size) {
+            ret = -RT_EFULL;
+            goto _exit;
+        }
+    }
+
+    /* 补齐部分保持擦除态 */
+    memset(kv_buf, 0xFF, size);
+    hdr->magic = KV_RECORD_MAGIC;
+    hdr->key_len = (rt_uint8_t)key_len;
+    hdr->value_len = (rt_uint16_t)len;
+    memcpy(kv_buf + sizeof(*hdr), key, key_len);
+    memcpy(kv_buf + sizeof(*hdr) + key_len, value, len);
+    hdr->crc = kv_record_crc(hdr, kv_buf + sizeof(*hdr));
+
+    rt_uint32_t offset = kv_write_off;
+    /* 无论成败这段空间都可能已被编程过, 不再使用 */
+    kv_write_off += size;
+    if (kv_flash_write(kv_sector_base(kv_active) + offset, kv_buf, size) != RT_EOK ||
+        kv_read_record(kv_active, offset, &size) != KV_REC_OK) {
+        ret = -RT_EIO;
+        goto _exit;
+    }
+    ret = kv_index_update(key, key_len, offset, (rt_uint16_t)len);
+
+_exit:
+    rt_mutex_release(&kv_lock);
+    return ret;
+}
+
+void kv_set_flash_gate(void (*gate)(void))
+{
+    kv_gate = gate;
+}
+
+void kv_get_stats(struct kv_stats *stats)
+{
+    rt_memset(stats, 0, sizeof(*stats));
+    if (kv_mtd == RT_NULL) return;
+
+    rt_mutex_take(&kv_lock, RT_WAITING_FOREVER);
+    stats->seq = kv_seq;
+    stats->sector_size = kv_sector_size;
+    stats->used = kv_write_off;
+    stats->keys = kv_count;
+    stats->torn = kv_torn;
+    rt_mutex_release(&kv_lock);
+}
@@ -0,0 +1,60 @@
+#ifndef __KVSTORE_H__
+#define __KVSTORE_H__
+
+#include <rtthread.h>
+
+/*
+ * 片上Flash上的日志结构键值存储, 用于保存增益调度表/前馈表等参数
+ *  - 使用 MTD NOR 设备的前两个扇区, 两个扇区轮流作为活动扇区 (双缓冲)
+ *  - 每次写入都在活动扇区末尾追加一条带CRC32的新记录, 同一个键以最后一条有效记录为准
+ *    写到一半掉电的记录CRC校验失败, 读取时忽略, 旧值仍然有效, 因此每次提交都是原子的
+ *  - 活动扇区写满时把所有键的最新记录搬到另一个扇区, 最后写扇区头 (序号加一) 作为提交点
+ *    搬移过程中掉电, 新扇区没有有效的头, 下次启动仍使用旧扇区
+ *  - 两个扇区轮流擦除, 擦写次数平均分摊 (磨损均衡)
+ *  - 挂载时扫描一次建立内存索引, 之后读取直接按索引从Flash映射地址拷贝, 不需要再扫描
+ */
+
+#define KV_MAX_KEYS         8       // 最多的键个数
+#define KV_MAX_KEY_LEN      15      // 键的最大长度 (不含结尾 '\0')
+#define KV_MAX_VALUE_LEN    256     // 值的最大长度 (字节)
+
+struct kv_stats
+{
+    rt_uint32_t seq;                // 活动扇区的序号, 每次整理加一
+    rt_uint32_t sector_size;        // 扇区大小 (字节)
+    rt_uint32_t used;               // 活动扇区已用字节数
+    rt_uint32_t keys;               // 当前有效的键个数
+    rt_uint32_t torn;               // 挂载时发现的CRC错误记录数
+};
+
+/**
+ * @brief 挂载键值存储, 两个扇区都没有有效数据时格式化
+ * @param mtd_name MTD NOR 设备名
+ * @return RT_EOK 成功, -RT_ERROR 找不到设备或擦写失败
+ */
+rt_err_t kv_init(const char *mtd_name);
+
+/**
+ * @brief 读取一个键的值
+ * @param buf  输出缓冲区
+ * @param size 输出缓冲区大小, 值比缓冲区长时返回 -RT_EFULL 且不拷贝
+ * @param len  输出值的实际长度, 可为 RT_NULL
+ * @return RT_EOK 成功, -RT_EEMPTY 键不存在
+ */
+rt_err_t kv_get(const char *key, void *buf, rt_size_t size, rt_size_t *len);
+
+/**
+ * @brief 写入一个键的值, 与Flash中的最新值相同时不写入
+ * @return RT_EOK 成功, -RT_EINVAL 键或值过长, -RT_EFULL 空间不足, -RT_EIO 写入校验失败
+ */
+rt_err_t kv_set(const char *key, const void *value, rt_size_t len);
+
+/**
+ * @brief 设置擦写前的等待钩子
+ * 擦写期间从同一块Flash取指会停顿, 钩子用于等到控制周期刚结束的空闲时刻再擦写
+ */
+void kv_set_flash_gate(void (*gate)(void));
+
+void kv_get_stats(struct kv_stats *stats);
+
+#endif /* __KVSTORE_H__ */
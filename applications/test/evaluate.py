@@ -19,6 +19,17 @@ TOTAL_CALLS_PER_PROFILE = 60 # 每个高度配置的总优化迭代次数
 RESET_DURATION_S = 3      # 两次测试之间，风扇停机的复位时间（秒）
 RESULTS_FILE = "./gain_scheduling_results.json" # 上次优化结果
 
+# --- 目标函数权重 ---
+# pid_eval 在 EVAL_RESULT 之后还会输出一行 EVAL_METRICS:{json}，包含 iae/ise/itae/overshoot/
+# settling_time/ss_var/effort/effort_tv/saturated 等指标。得分 = EVAL_RESULT + Σ 权重 * 指标，
+# 权重全为0时与原来只用误差绝对值积分的得分相同。
+OBJECTIVE_WEIGHTS = {
+    "overshoot": 0.0,      # 每mm超调
+    "settling_time": 0.0,  # 每秒调节时间
+    "ss_var": 0.0,         # 每mm²稳态方差
+    "saturated": 0.0,      # 每个输出限幅的样本
+}
+
 # --- 增益调度目标配置 (Gain Scheduling Profiles) ---
 # 这是核心配置。脚本会为列表中的每个字典（代表一个高度）运行一次完整的优化。
 # "initial_params" 现在将作为找不到历史结果时的后备默认值。
@@ -156,6 +167,17 @@ def reset_system():
     time.sleep(RESET_DURATION_S)
     print("--- Reset complete, ready for next test ---")
 
+def read_eval_metrics(deadline):
+    """读取 EVAL_RESULT 之后紧跟的 EVAL_METRICS 行, 没有时返回空字典。"""
+    while time.time() < deadline:
+        line = ser.readline().decode('ascii', errors='ignore').strip()
+        if line.startswith("EVAL_METRICS:"):
+            try:
+                return json.loads(line[len("EVAL_METRICS:"):])
+            except json.JSONDecodeError:
+                return {}
+    return {}
+
 def objective_function(params):
     global current_target_height
     kp, ki, kd = params
@@ -193,6 +215,10 @@ def objective_function(params):
                 try:
                     score = float(line.split(':')[1])
                     if score > 1.0:
+                        metrics = read_eval_metrics(time.time() + 1.0)
+                        if metrics:
+                            print(f"<-- EVAL_METRICS: {metrics}")
+                        score += sum(w * float(metrics.get(k, 0.0)) for k, w in OBJECTIVE_WEIGHTS.items())
                         print(f"Score received: {score}")
                         return score
                     else:
@@ -0,0 +1,6 @@
+#ifndef __SIM_DRV_PIN_H__
+#define __SIM_DRV_PIN_H__
+
+#include <rtdevice.h>
+
+#endif /* __SIM_DRV_PIN_H__ */
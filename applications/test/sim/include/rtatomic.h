@@ -0,0 +1,38 @@
+#ifndef __SIM_RTATOMIC_H__
+#define __SIM_RTATOMIC_H__
+
+/* 仿真是单线程的, 普通读写即可 */
+typedef long rt_atomic_t;
+
+#define rt_atomic_load(ptr)         (*(ptr))
+#define rt_atomic_store(ptr, v)     (*(ptr) = (v))
+#define rt_atomic_add(ptr, v)       sim_atomic_add((ptr), (v))
+#define rt_atomic_exchange(ptr, v)  sim_atomic_exchange((ptr), (v))
+#define rt_atomic_compare_exchange_strong(ptr, expected, desired) \
+    sim_atomic_cas((ptr), (expected), (desired))
+
+static inline rt_atomic_t sim_atomic_add(volatile rt_atomic_t *ptr, rt_atomic_t v)
+{
+    rt_atomic_t old = *ptr;
+    *ptr = old + v;
+    return old;
+}
+
+static inline rt_atomic_t sim_atomic_exchange(volatile rt_atomic_t *ptr, rt_atomic_t v)
+{
+    rt_atomic_t old = *ptr;
+    *ptr = v;
+    return old;
+}
+
+static inline int sim_atomic_cas(volatile rt_atomic_t *ptr, rt_atomic_t *expected, rt_atomic_t desired)
+{
+    if (*ptr != *expected) {
+        *expected = *ptr;
+        return 0;
+    }
+    *ptr = desired;
+    return 1;
+}
+
+#endif /* __SIM_RTATOMIC_H__ */
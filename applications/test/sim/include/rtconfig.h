@@ -0,0 +1,19 @@
+#ifndef RT_CONFIG_H__
+#define RT_CONFIG_H__
+
+/*
+ * 主机仿真用的配置, 取值与板上 rtconfig.h 相同
+ * 可在编译命令中用 -D 覆盖, 例如 -DAPP_CONTROL_LOOP_RATE_HZ=200 或 -DAPP_HEIGHT_ESTIMATOR_NONE
+ */
+#define RT_NAME_MAX 16
+#define RT_TICK_PER_SECOND 1000
+#define RT_CONSOLEBUF_SIZE 128
+
+#ifndef APP_CONTROL_LOOP_RATE_HZ
+#define APP_CONTROL_LOOP_RATE_HZ 50
+#endif
+#if !defined(APP_HEIGHT_ESTIMATOR_NONE) && !defined(APP_HEIGHT_ESTIMATOR_ALPHA_BETA)
+#define APP_HEIGHT_ESTIMATOR_KALMAN
+#endif
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef __SIM_RTDEVICE_H__
+#define __SIM_RTDEVICE_H__
+
+#include <rtthread.h>
+
+#define PIN_LOW                 0x00
+#define PIN_HIGH                0x01
+#define PIN_MODE_OUTPUT         0x00
+#define PIN_MODE_INPUT          0x01
+
+/* 只作为风扇配置里的句柄类型出现 */
+struct rt_device_pwm;
+
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode);
+void rt_pin_write(rt_base_t pin, rt_ssize_t value);
+
+#endif /* __SIM_RTDEVICE_H__ */
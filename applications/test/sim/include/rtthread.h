@@ -0,0 +1,99 @@
+#ifndef __SIM_RTTHREAD_H__
+#define __SIM_RTTHREAD_H__
+
+/*
+ * 主机仿真用的 RT-Thread 替身, 只提供 applications 下控制代码用到的类型、宏和函数
+ * 线程、延时、tick 的实现见 ../sim_rt.c, 时间全部是仿真时间
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <rtconfig.h>
+
+typedef int8_t          rt_int8_t;
+typedef int16_t         rt_int16_t;
+typedef int32_t         rt_int32_t;
+typedef int64_t         rt_int64_t;
+typedef uint8_t         rt_uint8_t;
+typedef uint16_t        rt_uint16_t;
+typedef uint32_t        rt_uint32_t;
+typedef uint64_t        rt_uint64_t;
+typedef int             rt_bool_t;
+typedef long            rt_base_t;
+typedef unsigned long   rt_ubase_t;
+typedef rt_base_t       rt_err_t;
+typedef rt_ubase_t      rt_size_t;
+typedef rt_base_t       rt_ssize_t;
+typedef rt_uint32_t     rt_tick_t;
+
+#define RT_TRUE         1
+#define RT_FALSE        0
+#define RT_NULL         0
+
+/* 与 klibc/kerrno.h 中不使用 libc errno 时的取值一致 */
+#define RT_EOK          0
+#define RT_ERROR        1
+#define RT_ETIMEOUT     2
+#define RT_EFULL        3
+#define RT_EEMPTY       4
+#define RT_ENOMEM       5
+#define RT_ENOSYS       6
+#define RT_EBUSY        7
+#define RT_EIO          8
+#define RT_EINTR        9
+#define RT_EINVAL       10
+#define RT_ENOENT       11
+#define RT_ENOSPC       12
+#define RT_EPERM        13
+
+#define rt_inline               static __inline
+#define RT_UNUSED(x)            ((void)(x))
+#define RT_ALIGN(size, align)   (((size) + (align) - 1) & ~((align) - 1))
+
+/* 自动初始化在 main 之前按声明顺序执行, 与板上在调度器启动前执行的效果相同 */
+#define INIT_EXPORT(fn)         static void __attribute__((constructor)) fn##_sim_init(void) { fn(); }
+#define INIT_BOARD_EXPORT(fn)   INIT_EXPORT(fn)
+#define INIT_DEVICE_EXPORT(fn)  INIT_EXPORT(fn)
+#define INIT_COMPONENT_EXPORT(fn) INIT_EXPORT(fn)
+#define INIT_ENV_EXPORT(fn)     INIT_EXPORT(fn)
+#define INIT_APP_EXPORT(fn)     INIT_EXPORT(fn)
+
+/* 没有 FinSH, 命令通过 cmd_execute() 执行, 导出的函数只保留引用 */
+#define MSH_CMD_EXPORT_ALIAS(command, alias, desc) \
+    static int (* const alias##_sim_msh)(int, char **) __attribute__((used)) = command;
+#define MSH_CMD_EXPORT(command, desc) MSH_CMD_EXPORT_ALIAS(command, command, desc)
+
+#define RT_ALIGN_SIZE           8
+#define rt_align(n)             __attribute__((aligned(n)))
+
+struct rt_thread
+{
+    char name[RT_NAME_MAX];
+    void (*entry)(void *parameter);
+    void *parameter;
+    void (*cleanup)(struct rt_thread *tid);
+    rt_bool_t is_static;
+};
+typedef struct rt_thread *rt_thread_t;
+
+rt_err_t rt_thread_init(struct rt_thread *thread, const char *name, void (*entry)(void *parameter),
+                        void *parameter, void *stack_start, rt_uint32_t stack_size,
+                        rt_uint8_t priority, rt_uint32_t tick);
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_err_t rt_thread_mdelay(rt_int32_t ms);
+rt_err_t rt_thread_delay(rt_tick_t tick);
+rt_err_t rt_thread_yield(void);
+rt_tick_t rt_tick_get(void);
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms);
+void rt_enter_critical(void);
+void rt_exit_critical(void);
+
+int rt_kprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void rt_kputs(const char *str);
+#define rt_snprintf     snprintf
+#define rt_vsnprintf    vsnprintf
+
+#endif /* __SIM_RTTHREAD_H__ */
@@ -0,0 +1,104 @@
+#include <math.h>
+#include "plant.h"
+
+#define GRAVITY     9810.0f     // mm/s²
+
+void plant_default_params(struct plant_params *p)
+{
+    p->dt = 0.001f;
+    p->fan_deadband = 0.05f;
+    p->fan_tau = 0.15f;
+    p->air_speed = 1900.0f;
+    p->air_decay = 2500.0f;
+    p->leak_speed = 500.0f;
+    p->floor = 20.0f;
+    p->ceiling = 520.0f;
+    p->tof_period = 0.033f;
+    p->tof_latency = 0.030f;
+    p->tof_noise = 3.0f;
+    p->tof_outlier = 0.002f;
+}
+
+/* xorshift32, 返回 [0, 1) */
+static float plant_rand(struct plant *pl)
+{
+    uint32_t x = pl->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pl->rng = x;
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+/* Box-Muller, 标准正态分布 */
+static float plant_gauss(struct plant *pl)
+{
+    float u1 = plant_rand(pl);
+    float u2 = plant_rand(pl);
+    if (u1 < 1e-7f) u1 = 1e-7f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+void plant_init(struct plant *pl, const struct plant_params *p, uint32_t seed)
+{
+    pl->p = *p;
+    pl->fan = 0.0f;
+    pl->height = p->floor;
+    pl->velocity = 0.0f;
+    pl->step = 0;
+    pl->rng = seed != 0 ? seed : 0x9E3779B9u;
+    for (int i = 0; i < PLANT_HISTORY; i++) {
+        pl->history[i] = p->floor;
+    }
+}
+
+/* 小球所在高度的管内风速 (mm/s) */
+static float plant_air(const struct plant *pl, float fan, float height)
+{
+    return pl->p.air_speed * fan * expf(-height / pl->p.air_decay);
+}
+
+void plant_step(struct plant *pl, float duty)
+{
+    const struct plant_params *p = &pl->p;
+
+    float drive = (duty - p->fan_deadband) / (1.0f - p->fan_deadband);
+    if (drive < 0.0f) drive = 0.0f;
+    if (drive > 1.0f) drive = 1.0f;
+    pl->fan += (drive - pl->fan) * p->dt / (p->fan_tau + p->dt);
+
+    float rel = (plant_air(pl, pl->fan, pl->height) - pl->velocity) / p->leak_speed;
+    float accel = GRAVITY * (rel * fabsf(rel) - 1.0f);
+    pl->velocity += accel * p->dt;
+    pl->height += pl->velocity * p->dt;
+
+    if (pl->height <= p->floor) {
+        pl->height = p->floor;
+        if (pl->velocity < 0.0f) pl->velocity = 0.0f;
+    } else if (pl->height >= p->ceiling) {
+        pl->height = p->ceiling;
+        if (pl->velocity > 0.0f) pl->velocity = 0.0f;
+    }
+
+    pl->history[++pl->step % PLANT_HISTORY] = pl->height;
+}
+
+int32_t plant_measure(struct plant *pl)
+{
+    const struct plant_params *p = &pl->p;
+    uint32_t lag = (uint32_t)(p->tof_latency / p->dt + 0.5f);
+
+    if (lag >= PLANT_HISTORY) lag = PLANT_HISTORY - 1;
+    if (lag > pl->step) lag = pl->step;
+    if (plant_rand(pl) < p->tof_outlier) return 8190;
+
+    float h = pl->history[(pl->step - lag) % PLANT_HISTORY] + p->tof_noise * plant_gauss(pl);
+    return (int32_t)lrintf(h < 0.0f ? 0.0f : h);
+}
+
+float plant_hover_duty(const struct plant *pl, float height)
+{
+    const struct plant_params *p = &pl->p;
+    float fan = p->leak_speed / plant_air(pl, 1.0f, height);
+    return p->fan_deadband + fan * (1.0f - p->fan_deadband);
+}
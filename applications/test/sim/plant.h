@@ -0,0 +1,61 @@
+#ifndef __PLANT_H__
+#define __PLANT_H__
+
+#include <stdint.h>
+
+/*
+ * 风洞对象模型: 风扇 -> 管内气流 -> 小球 -> ToF测距
+ *  - 风扇: 占空比低于死区时不转, 转速对占空比为一阶滞后
+ *  - 气流: 管内风速与转速成正比, 随高度按指数衰减 (管壁漏气)
+ *  - 小球: 几乎堵住管道, 托举力与从球边缝隙流过的相对风速的平方成正比,
+ *          相对风速等于 leak_speed 时托举力等于重力; 所以球速趋向 "管内风速 - leak_speed",
+ *          占空比略高于悬停值时小球缓慢上升; 在管底和管顶处停住
+ *  - ToF: 按固定间隔出样本, 样本反映 latency 之前的高度, 叠加高斯噪声并量化到1mm,
+ *         偶尔给出 8190 的超量程读数 (VL53L0X 丢失目标时的行为)
+ * 所有随机量来自带种子的伪随机数, 同样的种子和输入得到完全相同的结果
+ */
+
+#define PLANT_HISTORY   256             // 高度历史 (积分步数), 决定最大测距延迟
+
+struct plant_params
+{
+    float dt;               // 积分步长 (s)
+    float fan_deadband;     // 风扇启动占空比
+    float fan_tau;          // 风扇转速时间常数 (s)
+    float air_speed;        // 满转时管底风速 (mm/s)
+    float air_decay;        // 风速衰减长度 (mm)
+    float leak_speed;       // 托举力等于重力时的相对风速 (mm/s)
+    float floor;            // 小球静止在管底时的读数 (mm)
+    float ceiling;          // 管顶 (mm)
+    float tof_period;       // 测距间隔 (s)
+    float tof_latency;      // 测距延迟 (s)
+    float tof_noise;        // 测距噪声标准差 (mm)
+    float tof_outlier;      // 超量程读数的概率
+};
+
+struct plant
+{
+    struct plant_params p;
+    float fan;              // 归一化转速 0..1
+    float height;           // mm
+    float velocity;         // mm/s
+    uint32_t step;          // 已积分的步数
+    uint32_t rng;
+    float history[PLANT_HISTORY];
+};
+
+/* 默认参数, 悬停占空比在 250mm 附近约为 0.33 */
+void plant_default_params(struct plant_params *p);
+
+void plant_init(struct plant *pl, const struct plant_params *p, uint32_t seed);
+
+/* 以占空比 duty 积分一个步长 */
+void plant_step(struct plant *pl, float duty);
+
+/* 取一个测距读数 (mm), 反映 tof_latency 之前的高度 */
+int32_t plant_measure(struct plant *pl);
+
+/* 维持 height 悬停所需的占空比, 用于对照前馈表 */
+float plant_hover_duty(const struct plant *pl, float height);
+
+#endif /* __PLANT_H__ */
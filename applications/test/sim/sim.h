@@ -0,0 +1,29 @@
+#ifndef __SIM_H__
+#define __SIM_H__
+
+#include <stdint.h>
+#include "plant.h"
+
+/*
+ * 仿真运行时: 用仿真时间实现 RT-Thread 的 tick/延时/线程, 并替代风扇、ToF和控制定时器驱动
+ *  - 时间只在 rt_thread_mdelay() 或 sim_run() 中按对象积分步长推进, 单线程执行
+ *  - 推进期间按仿真时间触发ToF采样和控制周期, 控制周期直接调用 control_loop_start() 注册的函数
+ *  - rt_thread_startup() 同步执行线程入口 (如自整定线程), 只有永不退出的显示类线程被忽略
+ */
+
+void sim_init(const struct plant_params *params, uint32_t seed);
+
+/* 推进仿真时间 ms 毫秒 */
+void sim_run(uint32_t ms);
+
+uint64_t sim_time_ms(void);
+
+/* 关闭后 rt_kprintf/rt_kputs 不输出, 命令回复仍可由调用方自行打印 */
+void sim_set_console(int enable);
+
+struct plant *sim_plant(void);
+
+/* 当前输出到风扇的占空比 */
+float sim_fan_duty(void);
+
+#endif /* __SIM_H__ */
@@ -0,0 +1,203 @@
+/*
+ * 风洞闭环仿真: main.c 的控制代码 (斜坡、增益调度、前馈、估计器、PID、限幅、评估、自整定)
+ * 不做修改地在主机上编译, 接上 plant.c 的风扇/小球/ToF模型, 用仿真时间运行
+ *
+ * 编译 (在仓库根目录, main.c 用 -Dmain=app_main 改名, 本文件再取消这个宏):
+ *   gcc -O2 -Wall -Wextra -Dmain=app_main -Iapplications/test/sim/include -Iapplications/test/sim \
+ *       -Iapplications -Iapplications/control -Iapplications/cmd -Iapplications/fan \
+ *       applications/test/sim/sim_main.c applications/test/sim/sim_rt.c applications/test/sim/plant.c \
+ *       applications/main.c applications/cmd/cmd.c \
+ *       applications/control/pid.c applications/control/lut.c applications/control/autotune.c \
+ *       applications/control/eval_metrics.c applications/control/estimator.c \
+ *       applications/control/telemetry.c applications/control/ctrl_queue.c -lm -o wt_sim
+ *
+ * 运行:
+ *   ./wt_sim                                          默认回归: 依次阶跃到几个高度并评估
+ *   ./wt_sim "pid_tune -t 300" "sleep 8000" "pid_eval 10000" "get_status"
+ *   ./wt_sim -seed 7 -noise 5 -max-cost 3000          扰动对象参数, 任一阶跃超过代价上限时返回1
+ *
+ * 不带命令时每个阶跃输出一行 SIM_STEP:{json}, 最后输出 SIM_SUMMARY:{json}
+ * 带命令时按顺序执行, 打印每条命令的回复; "sleep <ms>" 推进仿真时间
+ * 同样的种子和参数每次得到完全相同的结果
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <rtthread.h>
+#include "cmd.h"
+#include "sim.h"
+
+#undef main
+int app_main(void);
+
+#define SIM_MAX_ARGS        16
+#define SIM_REPLY_SIZE      4096
+#define SIM_BOOT_MS         10000       // 启动后先在默认目标高度稳定的时间
+#define SIM_STEP_EVAL_MS    15000       // 每个阶跃的评估时长
+
+/* 默认回归的阶跃序列, 覆盖增益调度表的大部分断点, 上下交替 */
+static const float regression_targets[] = { 150.0f, 350.0f, 200.0f, 450.0f, 300.0f, 100.0f, 250.0f };
+
+static char reply_buf[SIM_REPLY_SIZE];
+
+static double wall_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 执行一行命令, 回复留在 reply_buf; "sleep <ms>" 只推进仿真时间 */
+static rt_err_t sim_command(const char *line)
+{
+    char copy[256];
+    char *argv[SIM_MAX_ARGS];
+    int argc = 0;
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+    for (char *tok = strtok(copy, " \t"); tok != NULL && argc < SIM_MAX_ARGS; tok = strtok(NULL, " \t")) {
+        argv[argc++] = tok;
+    }
+    reply_buf[0] = '\0';
+    if (argc == 0) return RT_EOK;
+
+    if (strcmp(argv[0], "sleep") == 0) {
+        sim_run(argc > 1 ? (uint32_t)atoi(argv[1]) : 1000);
+        return RT_EOK;
+    }
+
+    struct cmd_reply reply = { reply_buf, sizeof(reply_buf), 0, 0 };
+    return cmd_execute(argc, argv, RT_FALSE, &reply);
+}
+
+/* 从回复中取 key 之后的一行 */
+static const char *reply_line(const char *key, char *out, size_t size)
+{
+    const char *p = strstr(reply_buf, key);
+    if (p == NULL) return NULL;
+    p += strlen(key);
+    size_t n = strcspn(p, "\r\n");
+    if (n >= size) n = size - 1;
+    memcpy(out, p, n);
+    out[n] = '\0';
+    return out;
+}
+
+/* 取扁平JSON对象中的数值字段 */
+static float json_number(const char *json, const char *name)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "\"%s\":", name);
+    const char *p = strstr(json, key);
+    return p != NULL ? strtof(p + strlen(key), NULL) : 0.0f;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options] [\"<command>\" ...]\n", prog);
+    printf("  -seed <n>         random seed (default 1)\n");
+    printf("  -noise <mm>       ToF noise standard deviation\n");
+    printf("  -latency <ms>     ToF latency\n");
+    printf("  -tof-period <ms>  ToF sample interval\n");
+    printf("  -outlier <p>      probability of an out-of-range reading\n");
+    printf("  -fan-tau <s>      fan time constant\n");
+    printf("  -air <mm/s>       tube air speed at full duty\n");
+    printf("  -max-cost <x>     fail if any step's EVAL_RESULT exceeds x\n");
+    printf("  -max-overshoot <mm> fail if any step overshoots more than mm\n");
+    printf("  -v                show the firmware console output\n");
+    printf("Commands are firmware commands (pid_tune, pid_eval, get_status, pid_autotune)\n");
+    printf("or \"sleep <ms>\". Without commands a step regression is run.\n");
+}
+
+/* 默认回归: 依次阶跃, 每个阶跃评估一次; 返回超出上限的阶跃数 */
+static int run_regression(float max_cost, float max_overshoot)
+{
+    char cmd[64], metrics[512], result[32];
+    float total_cost = 0.0f, worst_overshoot = 0.0f;
+    int failed = 0;
+
+    sim_run(SIM_BOOT_MS);
+    for (size_t i = 0; i < sizeof(regression_targets) / sizeof(regression_targets[0]); i++) {
+        snprintf(cmd, sizeof(cmd), "pid_tune -t %.0f", regression_targets[i]);
+        sim_command(cmd);
+        snprintf(cmd, sizeof(cmd), "pid_eval %d", SIM_STEP_EVAL_MS);
+        if (sim_command(cmd) != RT_EOK || reply_line("EVAL_METRICS:", metrics, sizeof(metrics)) == NULL) {
+            printf("SIM_STEP:{\"target\":%.1f,\"error\":\"evaluation failed\"}\n", regression_targets[i]);
+            failed++;
+            continue;
+        }
+        reply_line("EVAL_RESULT:", result, sizeof(result));
+        float cost = strtof(result, NULL);
+        float overshoot = json_number(metrics, "overshoot");
+        rt_bool_t pass = (max_cost <= 0.0f || cost <= max_cost) &&
+                         (max_overshoot <= 0.0f || overshoot <= max_overshoot);
+
+        printf("SIM_STEP:{\"target\":%.1f,\"cost\":%.1f,\"pass\":%s,\"metrics\":%s}\n",
+               regression_targets[i], cost, pass ? "true" : "false", metrics);
+        total_cost += cost;
+        if (overshoot > worst_overshoot) worst_overshoot = overshoot;
+        if (!pass) failed++;
+    }
+    printf("SIM_SUMMARY:{\"steps\":%d,\"failed\":%d,\"total_cost\":%.1f,\"max_overshoot\":%.2f,",
+           (int)(sizeof(regression_targets) / sizeof(regression_targets[0])), failed, total_cost, worst_overshoot);
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    struct plant_params params;
+    uint32_t seed = 1;
+    float max_cost = 0.0f, max_overshoot = 0.0f;
+    int verbose = 0, first_cmd = argc;
+
+    plant_default_params(&params);
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        if (opt[0] != '-') { first_cmd = i; break; }
+        if (strcmp(opt, "-v") == 0) { verbose = 1; continue; }
+        if (strcmp(opt, "-h") == 0 || i + 1 >= argc) { usage(argv[0]); return 2; }
+
+        float value = strtof(argv[++i], NULL);
+        if (strcmp(opt, "-seed") == 0) seed = (uint32_t)strtoul(argv[i], NULL, 0);
+        else if (strcmp(opt, "-noise") == 0) params.tof_noise = value;
+        else if (strcmp(opt, "-latency") == 0) params.tof_latency = value / 1000.0f;
+        else if (strcmp(opt, "-tof-period") == 0) params.tof_period = value / 1000.0f;
+        else if (strcmp(opt, "-outlier") == 0) params.tof_outlier = value;
+        else if (strcmp(opt, "-fan-tau") == 0) params.fan_tau = value;
+        else if (strcmp(opt, "-air") == 0) params.air_speed = value;
+        else if (strcmp(opt, "-max-cost") == 0) max_cost = value;
+        else if (strcmp(opt, "-max-overshoot") == 0) max_overshoot = value;
+        else { usage(argv[0]); return 2; }
+    }
+
+    sim_init(&params, seed);
+    sim_set_console(verbose);
+    if (app_main() != 0) {
+        fprintf(stderr, "Firmware main() failed.\n");
+        return 1;
+    }
+
+    double start = wall_seconds();
+    uint64_t sim_start = sim_time_ms();
+    int failed = 0;
+
+    if (first_cmd < argc) {
+        sim_set_console(1);
+        for (int i = first_cmd; i < argc; i++) {
+            rt_err_t err = sim_command(argv[i]);
+            fputs(reply_buf, stdout);
+            if (err != RT_EOK) failed++;
+        }
+        printf("SIM_SUMMARY:{\"commands\":%d,\"failed\":%d,", argc - first_cmd, failed);
+    } else {
+        failed = run_regression(max_cost, max_overshoot);
+    }
+
+    double wall = wall_seconds() - start;
+    double sim = (sim_time_ms() - sim_start) / 1000.0;
+    printf("\"seed\":%u,\"sim_seconds\":%.1f,\"wall_seconds\":%.3f,\"speedup\":%.0f}\n",
+           seed, sim, wall, wall > 0.0 ? sim / wall : 0.0);
+    return failed != 0;
+}
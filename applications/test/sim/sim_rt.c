@@ -0,0 +1,273 @@
+#include <stdlib.h>
+#include <string.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "YS4028B12H.h"
+#include "control_loop.h"
+#include "tof.h"
+#include "sim.h"
+
+#define SIM_TOF_RING_SIZE   8       // 与 tof.c 的环形缓冲区长度相同
+
+static struct plant plant;
+static uint64_t sim_us;             // 仿真时间 (us)
+static uint64_t next_tof_us;
+static uint64_t next_control_us;
+static int console_enabled = 1;
+static float fan_duty;
+
+static control_loop_step_t control_step_fn;
+static struct control_loop_stats loop_stats;
+
+static struct tof_sample tof_ring[SIM_TOF_RING_SIZE];
+static uint32_t tof_head, tof_tail;
+static struct tof_stats tof_stat;
+
+/* 板上永不退出的线程, 仿真里不运行 */
+static const char *const sim_ignored_threads[] = { "WorkingIndicate", "ScreenUpdate" };
+
+ys4028b12h_cfg my_ys4028b12h_config = { 0 };
+
+void sim_init(const struct plant_params *params, uint32_t seed)
+{
+    plant_init(&plant, params, seed);
+    sim_us = 0;
+    next_tof_us = (uint64_t)(params->tof_period * 1e6f);
+    next_control_us = CONTROL_LOOP_PERIOD_US;
+}
+
+void sim_set_console(int enable)
+{
+    console_enabled = enable;
+}
+
+struct plant *sim_plant(void)
+{
+    return &plant;
+}
+
+float sim_fan_duty(void)
+{
+    return fan_duty;
+}
+
+uint64_t sim_time_ms(void)
+{
+    return sim_us / 1000;
+}
+
+static void sim_tof_sample(void)
+{
+    struct tof_sample *slot = &tof_ring[tof_head % SIM_TOF_RING_SIZE];
+
+    if (tof_head - tof_tail == SIM_TOF_RING_SIZE) {
+        tof_tail++;
+        tof_stat.dropped++;
+    }
+    slot->timestamp = rt_tick_get();
+    slot->height = plant_measure(&plant);
+    tof_head++;
+    tof_stat.samples++;
+}
+
+void sim_run(uint32_t ms)
+{
+    uint64_t step_us = (uint64_t)(plant.p.dt * 1e6f + 0.5f);
+    uint64_t end = sim_us + (uint64_t)ms * 1000;
+
+    while (sim_us + step_us <= end) {
+        plant_step(&plant, fan_duty);
+        sim_us += step_us;
+
+        if (sim_us >= next_tof_us) {
+            next_tof_us += (uint64_t)(plant.p.tof_period * 1e6f);
+            sim_tof_sample();
+        }
+        if (sim_us >= next_control_us) {
+            next_control_us += CONTROL_LOOP_PERIOD_US;
+            if (control_step_fn != RT_NULL) {
+                loop_stats.cycles++;
+                loop_stats.period_us = CONTROL_LOOP_PERIOD_US;
+                control_step_fn(CONTROL_LOOP_PERIOD_US / 1e6f);
+            }
+        }
+    }
+    sim_us = end;
+}
+
+/*******************************************************************************
+ * RT-Thread
+ ******************************************************************************/
+
+rt_tick_t rt_tick_get(void)
+{
+    return (rt_tick_t)(sim_us * RT_TICK_PER_SECOND / 1000000);
+}
+
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    return (rt_tick_t)ms * RT_TICK_PER_SECOND / 1000;
+}
+
+rt_err_t rt_thread_mdelay(rt_int32_t ms)
+{
+    if (ms > 0) sim_run((uint32_t)ms);
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    return rt_thread_mdelay((rt_int32_t)(tick * 1000 / RT_TICK_PER_SECOND));
+}
+
+rt_err_t rt_thread_yield(void)
+{
+    return RT_EOK;
+}
+
+void rt_enter_critical(void)
+{
+}
+
+void rt_exit_critical(void)
+{
+}
+
+rt_err_t rt_thread_init(struct rt_thread *thread, const char *name, void (*entry)(void *parameter),
+                        void *parameter, void *stack_start, rt_uint32_t stack_size,
+                        rt_uint8_t priority, rt_uint32_t tick)
+{
+    RT_UNUSED(stack_start);
+    RT_UNUSED(stack_size);
+    RT_UNUSED(priority);
+    RT_UNUSED(tick);
+    memset(thread, 0, sizeof(*thread));
+    strncpy(thread->name, name, RT_NAME_MAX - 1);
+    thread->entry = entry;
+    thread->parameter = parameter;
+    thread->is_static = RT_TRUE;
+    return RT_EOK;
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t thread = calloc(1, sizeof(*thread));
+
+    RT_UNUSED(stack_size);
+    RT_UNUSED(priority);
+    RT_UNUSED(tick);
+    if (thread == RT_NULL) return RT_NULL;
+    strncpy(thread->name, name, RT_NAME_MAX - 1);
+    thread->entry = entry;
+    thread->parameter = parameter;
+    return thread;
+}
+
+/* 同步执行线程入口, 入口返回即线程结束, 和内核一样随后调用 cleanup */
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    for (size_t i = 0; i < sizeof(sim_ignored_threads) / sizeof(sim_ignored_threads[0]); i++) {
+        if (strcmp(thread->name, sim_ignored_threads[i]) == 0) return RT_EOK;
+    }
+    thread->entry(thread->parameter);
+    if (thread->cleanup != RT_NULL) thread->cleanup(thread);
+    if (!thread->is_static) free(thread);
+    return RT_EOK;
+}
+
+/* 与内核一样先格式化到 RT_CONSOLEBUF_SIZE 的缓冲, 超长的输出被截断 */
+int rt_kprintf(const char *fmt, ...)
+{
+    char buf[RT_CONSOLEBUF_SIZE];
+    va_list args;
+    int n;
+
+    if (!console_enabled) return 0;
+    va_start(args, fmt);
+    n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > (int)sizeof(buf) - 1) n = sizeof(buf) - 1;
+    fputs(buf, stdout);
+    return n;
+}
+
+void rt_kputs(const char *str)
+{
+    if (console_enabled) fputs(str, stdout);
+}
+
+void rt_pin_mode(rt_base_t pin, rt_uint8_t mode)
+{
+    RT_UNUSED(pin);
+    RT_UNUSED(mode);
+}
+
+void rt_pin_write(rt_base_t pin, rt_ssize_t value)
+{
+    RT_UNUSED(pin);
+    RT_UNUSED(value);
+}
+
+/*******************************************************************************
+ * 驱动替身: 风扇、ToF、控制定时器、OLED
+ ******************************************************************************/
+
+rt_err_t ys4028b12h_init(ys4028b12h_cfg_t cfg)
+{
+    static int pwm_handle;
+
+    cfg->name = (struct rt_device_pwm *)&pwm_handle;
+    return RT_EOK;
+}
+
+rt_err_t ys4028b12h_set_speed(ys4028b12h_cfg_t cfg, float speed)
+{
+    RT_UNUSED(cfg);
+    if (speed < 0.0f) speed = 0.0f;
+    if (speed > 1.0f) speed = 1.0f;
+    fan_duty = speed;
+    return RT_EOK;
+}
+
+rt_err_t tof_start(void)
+{
+    tof_stat.irq_mode = RT_TRUE;
+    return RT_EOK;
+}
+
+rt_bool_t tof_read(struct tof_sample *sample)
+{
+    if (tof_tail == tof_head) return RT_FALSE;
+    *sample = tof_ring[tof_tail++ % SIM_TOF_RING_SIZE];
+    return RT_TRUE;
+}
+
+rt_bool_t tof_read_latest(struct tof_sample *sample)
+{
+    if (tof_tail == tof_head) return RT_FALSE;
+    *sample = tof_ring[(tof_head - 1) % SIM_TOF_RING_SIZE];
+    tof_tail = tof_head;
+    return RT_TRUE;
+}
+
+void tof_get_stats(struct tof_stats *stats)
+{
+    *stats = tof_stat;
+}
+
+rt_err_t control_loop_start(control_loop_step_t step)
+{
+    control_step_fn = step;
+    rt_kprintf("[Control] Control loop running at %d Hz.\n", CONTROL_LOOP_RATE_HZ);
+    return RT_EOK;
+}
+
+void control_loop_get_stats(struct control_loop_stats *stats)
+{
+    *stats = loop_stats;
+}
+
+void screen_on()
+{
+}
@@ -319,7 +319,7 @@ void BOARD_InitPins(void)
                      | PORT_PCR_IBE(PCR_IBE_ibe1));
 #ifdef BSP_USING_I2C3
     /* LPI2C3 peripheral is released from reset */
-    RESET_ReleasePeripheralReset(kLPI2C0_RST_SHIFT_RSTn);
+    RESET_ReleasePeripheralReset(kLPI2C3_RST_SHIFT_RSTn);
     const port_pin_config_t port3_28_pin51_config = {/* Internal pull-up resistor is enabled */
                                                      .pullSelect = kPORT_PullUp,
                                                      /* Low internal pull resistor value is selected. */
@@ -342,7 +342,7 @@ void BOARD_InitPins(void)
                                                      .invertInput = kPORT_InputNormal,
                                                      /* Pin Control Register fields [15:0] are not locked */
                                                      .lockRegister = kPORT_UnlockRegister};
-    /* PORT3_28 (pin 51) is configured as LPI2C3_SCL */
+    /* PORT3_28 (pin 51) is configured as LPI2C3_SDA */
     PORT_SetPinConfig(PORT3, 28U, &port3_28_pin51_config);
     const port_pin_config_t port3_27_pin52_config = {/* Internal pull-up resistor is enabled */
                                                      .pullSelect = kPORT_PullUp,
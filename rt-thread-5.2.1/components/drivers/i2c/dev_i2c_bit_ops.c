@@ -384,6 +384,16 @@ static rt_ssize_t i2c_bit_xfer(struct rt_i2c_bus_device *bus,
 
     if (num == 0) return 0;
 
+    if (ops->xfer != RT_NULL)
+    {
+        ret = ops->xfer(ops->data, msgs, num);
+        if (ret != -RT_ENOSYS)
+        {
+            return ret;
+        }
+        LOG_D("engine declined, bit-banging %d msgs", num);
+    }
+
     for (i = 0; i < num; i++)
     {
         msg = &msgs[i];
@@ -30,6 +30,15 @@ struct rt_i2c_bit_ops
 
     void (*pin_init)(void);
     rt_bool_t i2c_pin_init_flag;
+
+    /*
+     * Optional hardware-timed engine (timer or FlexIO generated edges).
+     * When set, i2c_bit_xfer() hands the whole message sequence to it and
+     * the caller sleeps until the engine completes. It returns the number
+     * of messages transferred, or -RT_ENOSYS for a sequence it cannot
+     * generate, which is then bit-banged with the routines above.
+     */
+    rt_ssize_t (*xfer)(void *data, struct rt_i2c_msg msgs[], rt_uint32_t num);
 };
 
 rt_err_t rt_i2c_bit_add_bus(struct rt_i2c_bus_device *bus,
@@ -120,8 +120,8 @@ extern "C" {
 
 #define  RT_SENSOR_MODE_NONE           (0)
 #define  RT_SENSOR_MODE_POLLING        (1)  /* One shot only read a data */
-#define  RT_SENSOR_MODE_INT            (2)  /* TODO: One shot interrupt only read a data */
-#define  RT_SENSOR_MODE_FIFO           (3)  /* TODO: One shot interrupt read all fifo data */
+#define  RT_SENSOR_MODE_INT            (2)  /* Data-ready interrupt, read one data per interrupt */
+#define  RT_SENSOR_MODE_FIFO           (3)  /* Fifo watermark interrupt, read all fifo data per interrupt */
 
 /* Sensor control cmd types */
 
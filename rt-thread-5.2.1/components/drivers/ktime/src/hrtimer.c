@@ -105,7 +105,8 @@ static void _insert_timer_to_list_locked(rt_ktime_hrtimer_t timer)
 
     rt_list_for_each_entry(iter, &_timer_list, node)
     {
-        if (iter->timeout_cnt > timer->timeout_cnt)
+        /* signed difference, the counter may wrap on 32-bit targets */
+        if ((long)(iter->timeout_cnt - timer->timeout_cnt) > 0)
         {
             break;
         }
@@ -120,7 +121,7 @@ static void _hrtimer_process_locked(void)
     rt_ktime_hrtimer_t timer;
 
     for (timer = _first_hrtimer();
-        (timer != RT_NULL) && (timer->timeout_cnt <= rt_ktime_cputimer_getcnt());
+        (timer != RT_NULL) && ((long)(timer->timeout_cnt - rt_ktime_cputimer_getcnt()) <= 0);
         timer = _first_hrtimer())
     {
         rt_list_remove(&(timer->node));
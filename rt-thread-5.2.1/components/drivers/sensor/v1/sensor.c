@@ -101,31 +101,101 @@ static void irq_callback(void *args)
 /* Sensor interrupt initialization function */
 static rt_err_t rt_sensor_irq_init(rt_sensor_t sensor)
 {
+    rt_uint8_t irq_mode;
+    rt_err_t result;
+
     if (sensor->config.irq_pin.pin == RT_PIN_NONE)
     {
         return -RT_EINVAL;
     }
 
-    rt_pin_mode(sensor->config.irq_pin.pin, sensor->config.irq_pin.mode);
-
     if (sensor->config.irq_pin.mode == PIN_MODE_INPUT_PULLDOWN)
     {
-        rt_pin_attach_irq(sensor->config.irq_pin.pin, PIN_IRQ_MODE_RISING, irq_callback, (void *)sensor);
+        irq_mode = PIN_IRQ_MODE_RISING;
     }
     else if (sensor->config.irq_pin.mode == PIN_MODE_INPUT_PULLUP)
     {
-        rt_pin_attach_irq(sensor->config.irq_pin.pin, PIN_IRQ_MODE_FALLING, irq_callback, (void *)sensor);
+        irq_mode = PIN_IRQ_MODE_FALLING;
     }
     else if (sensor->config.irq_pin.mode == PIN_MODE_INPUT)
     {
-        rt_pin_attach_irq(sensor->config.irq_pin.pin, PIN_IRQ_MODE_RISING_FALLING, irq_callback, (void *)sensor);
+        irq_mode = PIN_IRQ_MODE_RISING_FALLING;
+    }
+    else
+    {
+        return -RT_EINVAL;
+    }
+
+    rt_pin_mode(sensor->config.irq_pin.pin, sensor->config.irq_pin.mode);
+
+    result = rt_pin_attach_irq(sensor->config.irq_pin.pin, irq_mode, irq_callback, (void *)sensor);
+    if (result != RT_EOK)
+    {
+        LOG_E("interrupt attach failed: %d", result);
+        return result;
     }
 
-    rt_pin_irq_enable(sensor->config.irq_pin.pin, RT_TRUE);
+    result = rt_pin_irq_enable(sensor->config.irq_pin.pin, RT_TRUE);
+    if (result != RT_EOK)
+    {
+        rt_pin_detach_irq(sensor->config.irq_pin.pin);
+        LOG_E("interrupt enable failed: %d", result);
+        return result;
+    }
 
     LOG_I("interrupt init success");
 
-    return 0;
+    return RT_EOK;
+}
+
+/* Sensor interrupt de-initialization function */
+static void rt_sensor_irq_deinit(rt_sensor_t sensor)
+{
+    if (sensor->config.irq_pin.pin == RT_PIN_NONE)
+    {
+        return;
+    }
+
+    rt_pin_irq_enable(sensor->config.irq_pin.pin, RT_FALSE);
+    rt_pin_detach_irq(sensor->config.irq_pin.pin);
+}
+
+/* Switch the sensor to interrupt or fifo mode and hook up its data-ready pin */
+static rt_err_t rt_sensor_irq_mode_init(rt_sensor_t sensor, rt_uint8_t mode,
+                                        rt_err_t (*local_ctrl)(struct rt_sensor_device *sensor, int cmd, void *arg))
+{
+    rt_err_t result;
+
+    if (mode == RT_SENSOR_MODE_FIFO && sensor->info.fifo_max > 0 && sensor->data_buf == RT_NULL)
+    {
+        /* Allocate memory for the fifo buffer of a standalone sensor */
+        sensor->data_buf = rt_malloc(sizeof(struct rt_sensor_data) * sensor->info.fifo_max);
+        if (sensor->data_buf == RT_NULL)
+        {
+            return -RT_ENOMEM;
+        }
+    }
+
+    result = local_ctrl(sensor, RT_SENSOR_CTRL_SET_MODE, (void *)(rt_ubase_t)mode);
+    if (result != RT_EOK)
+    {
+        LOG_W("mode %d is not supported by the driver", mode);
+        return -RT_ENOSYS;
+    }
+
+    /* Initialization sensor interrupt */
+    result = rt_sensor_irq_init(sensor);
+    if (result != RT_EOK)
+    {
+        /* Without a data-ready interrupt the sensor can only be polled */
+        local_ctrl(sensor, RT_SENSOR_CTRL_SET_MODE, (void *)RT_SENSOR_MODE_POLLING);
+        return result;
+    }
+
+    sensor->data_len = 0;
+    sensor->config.mode = mode;
+
+    return RT_EOK;
 }
 
 // local rt_sensor_ops
@@ -184,21 +254,19 @@ static rt_err_t rt_sensor_open(rt_device_t dev, rt_uint16_t oflag)
     else if (oflag & RT_DEVICE_FLAG_INT_RX && dev->flag & RT_DEVICE_FLAG_INT_RX)
     {
         /* If interrupt mode is supported, configure it to interrupt mode */
-        if (local_ctrl(sensor, RT_SENSOR_CTRL_SET_MODE, (void *)RT_SENSOR_MODE_INT) == RT_EOK)
+        res = rt_sensor_irq_mode_init(sensor, RT_SENSOR_MODE_INT, local_ctrl);
+        if (res != RT_EOK)
         {
-            /* Initialization sensor interrupt */
-            rt_sensor_irq_init(sensor);
-            sensor->config.mode = RT_SENSOR_MODE_INT;
+            goto __exit;
         }
     }
     else if (oflag & RT_DEVICE_FLAG_FIFO_RX && dev->flag & RT_DEVICE_FLAG_FIFO_RX)
     {
         /* If fifo mode is supported, configure it to fifo mode */
-        if (local_ctrl(sensor, RT_SENSOR_CTRL_SET_MODE, (void *)RT_SENSOR_MODE_FIFO) == RT_EOK)
+        res = rt_sensor_irq_mode_init(sensor, RT_SENSOR_MODE_FIFO, local_ctrl);
+        if (res != RT_EOK)
         {
-            /* Initialization sensor interrupt */
-            rt_sensor_irq_init(sensor);
-            sensor->config.mode = RT_SENSOR_MODE_FIFO;
+            goto __exit;
         }
     }
     else
@@ -266,11 +334,17 @@ static rt_err_t rt_sensor_close(rt_device_t dev)
     }
     if (sensor->config.mode != RT_SENSOR_MODE_POLLING)
     {
-        /* Sensor disable interrupt */
-        if (sensor->config.irq_pin.pin != RT_PIN_NONE)
+        /* Sensor disable interrupt, so that it can be attached again on the next open */
+        rt_sensor_irq_deinit(sensor);
+
+        if (sensor->module == RT_NULL && sensor->data_buf != RT_NULL)
         {
-            rt_pin_irq_enable(sensor->config.irq_pin.pin, RT_FALSE);
+            /* Free the fifo buffer of a standalone sensor */
+            rt_free(sensor->data_buf);
+            sensor->data_buf = RT_NULL;
         }
+        sensor->data_len = 0;
+        sensor->config.mode = RT_SENSOR_MODE_POLLING;
     }
 
 __exit:
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2006-2024 RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * lwIP is built without its own mem.c, so every mem_malloc() (PBUF_RAM pbufs,
+ * DHCP/DNS state) used to go straight to rt_malloc(), i.e. a first-fit walk of
+ * the small-mem heap under the heap lock. This front-end serves those requests
+ * from three fixed-size rt_mempool classes placed at link time:
+ *
+ *   small   header-only segments (ACK/SYN/FIN), ARP, ICMP, DHCP state
+ *   medium  short command replies and DNS/DHCP messages
+ *   large   one full TCP_MSS segment including all headers
+ *
+ * Allocation takes the smallest class whose block fits and never blocks; an
+ * exhausted class spills into the next larger one. When every fitting class
+ * is empty, or the request is larger than the large class, the block comes
+ * from rt_malloc() as before, so behaviour is unchanged under overload. mem_free() tells the two apart by the pool address ranges.
+ */
+
+#include <rtthread.h>
+
+#ifdef RT_LWIP_USING_MEMPOOL_HEAP
+
+#include <lwip/opt.h>
+#include <lwip/mem.h>
+#include <lwip/pbuf.h>
+
+/* block sizes and counts, any of them can be overridden from rtconfig.h */
+#ifndef RT_LWIP_MP_SMALL_SIZE
+#define RT_LWIP_MP_SMALL_SIZE   128
+#endif
+#ifndef RT_LWIP_MP_SMALL_NUM
+#define RT_LWIP_MP_SMALL_NUM    (RT_LWIP_TCP_SEG_NUM / 2)
+#endif
+#ifndef RT_LWIP_MP_MEDIUM_SIZE
+#define RT_LWIP_MP_MEDIUM_SIZE  512
+#endif
+#ifndef RT_LWIP_MP_MEDIUM_NUM
+#define RT_LWIP_MP_MEDIUM_NUM   (RT_LWIP_PBUF_NUM / 2)
+#endif
+#ifndef RT_LWIP_MP_LARGE_SIZE
+#define RT_LWIP_MP_LARGE_SIZE   (LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf)) + \
+                                 LWIP_MEM_ALIGN_SIZE(PBUF_LINK_ENCAPSULATION_HLEN + \
+                                                     PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN) + \
+                                 LWIP_MEM_ALIGN_SIZE(TCP_MSS))
+#endif
+#ifndef RT_LWIP_MP_LARGE_NUM
+#define RT_LWIP_MP_LARGE_NUM    (TCP_SND_BUF / TCP_MSS + 1)
+#endif
+
+/*
+ * rt_mempool keeps one pointer in front of every block, so the stride is only
+ * pointer aligned; rt_mp_init() aligns the pool size down to RT_ALIGN_SIZE,
+ * which would drop the last block of an odd count unless the size is rounded up.
+ */
+#define MP_STORAGE_SIZE(size, num)  RT_ALIGN((RT_ALIGN((size), RT_ALIGN_SIZE) + sizeof(rt_uint8_t *)) * (num), \
+                                             RT_ALIGN_SIZE)
+
+struct mem_pool_class
+{
+    struct rt_mempool mp;
+    rt_uint8_t *storage;
+    rt_size_t storage_size;
+    rt_size_t block_size;
+    rt_size_t min_free;                 /* low watermark of free blocks */
+    rt_atomic_t hits;                   /* served from this class */
+    rt_atomic_t misses;                 /* request fitted but the class was empty */
+};
+
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t small_storage[MP_STORAGE_SIZE(RT_LWIP_MP_SMALL_SIZE, RT_LWIP_MP_SMALL_NUM)];
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t medium_storage[MP_STORAGE_SIZE(RT_LWIP_MP_MEDIUM_SIZE, RT_LWIP_MP_MEDIUM_NUM)];
+rt_align(RT_ALIGN_SIZE) static rt_uint8_t large_storage[MP_STORAGE_SIZE(RT_LWIP_MP_LARGE_SIZE, RT_LWIP_MP_LARGE_NUM)];
+
+static struct mem_pool_class classes[] =
+{
+    { .storage = small_storage,  .storage_size = sizeof(small_storage),  .block_size = RT_LWIP_MP_SMALL_SIZE },
+    { .storage = medium_storage, .storage_size = sizeof(medium_storage), .block_size = RT_LWIP_MP_MEDIUM_SIZE },
+    { .storage = large_storage,  .storage_size = sizeof(large_storage),  .block_size = RT_LWIP_MP_LARGE_SIZE },
+};
+#define CLASS_COUNT (sizeof(classes) / sizeof(classes[0]))
+
+static rt_bool_t pools_ready = RT_FALSE;
+static rt_atomic_t oversize;            /* larger than the large class */
+static rt_atomic_t heap_frees;
+
+void mem_init(void)
+{
+    static const char *const names[CLASS_COUNT] = { "lwip_s", "lwip_m", "lwip_l" };
+    rt_size_t i;
+
+    if (pools_ready)
+    {
+        return;
+    }
+
+    for (i = 0; i < CLASS_COUNT; i++)
+    {
+        struct mem_pool_class *c = &classes[i];
+
+        rt_mp_init(&c->mp, names[i], c->storage, c->storage_size, c->block_size);
+        c->min_free = c->mp.block_total_count;
+    }
+    pools_ready = RT_TRUE;
+}
+
+void *mem_malloc(mem_size_t size)
+{
+    rt_size_t i;
+
+    if (pools_ready)
+    {
+        for (i = 0; i < CLASS_COUNT; i++)
+        {
+            struct mem_pool_class *c = &classes[i];
+            void *mem;
+
+            if (size > c->block_size)
+            {
+                continue;
+            }
+
+            mem = rt_mp_alloc(&c->mp, RT_WAITING_NO);
+            if (mem != RT_NULL)
+            {
+                rt_atomic_add(&c->hits, 1);
+                /* racy but only used for reporting */
+                if (c->mp.block_free_count < c->min_free)
+                {
+                    c->min_free = c->mp.block_free_count;
+                }
+                return mem;
+            }
+            /* this class is exhausted, a larger block is still cheaper than the heap */
+            rt_atomic_add(&c->misses, 1);
+        }
+        if (size > classes[CLASS_COUNT - 1].block_size)
+        {
+            rt_atomic_add(&oversize, 1);
+        }
+    }
+
+    return rt_malloc(size);
+}
+
+void *mem_calloc(mem_size_t count, mem_size_t size)
+{
+    rt_size_t total = (rt_size_t)count * size;
+    void *mem;
+
+    if (total > (mem_size_t)-1)
+    {
+        return rt_calloc(count, size);
+    }
+
+    mem = mem_malloc((mem_size_t)total);
+    if (mem != RT_NULL)
+    {
+        rt_memset(mem, 0, total);
+    }
+    return mem;
+}
+
+void mem_free(void *mem)
+{
+    rt_size_t i;
+
+    if (mem == RT_NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < CLASS_COUNT; i++)
+    {
+        const struct mem_pool_class *c = &classes[i];
+
+        if ((rt_uint8_t *)mem >= c->storage && (rt_uint8_t *)mem < c->storage + c->storage_size)
+        {
+            rt_mp_free(mem);
+            return;
+        }
+    }
+
+    rt_atomic_add(&heap_frees, 1);
+    rt_free(mem);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int list_lwip_mem(int argc, char **argv)
+{
+    rt_size_t i;
+
+    rt_kprintf("class  block total free  min     hits   misses  hit%%\n");
+    rt_kprintf("------ ----- ----- ---- ---- -------- -------- -----\n");
+    for (i = 0; i < CLASS_COUNT; i++)
+    {
+        const struct mem_pool_class *c = &classes[i];
+        rt_uint32_t hits = (rt_uint32_t)rt_atomic_load((rt_atomic_t *)&c->hits);
+        rt_uint32_t misses = (rt_uint32_t)rt_atomic_load((rt_atomic_t *)&c->misses);
+        rt_uint32_t total = hits + misses;
+        rt_uint32_t permille = total > 0 ? (rt_uint32_t)((rt_uint64_t)hits * 1000 / total) : 1000;
+
+        rt_kprintf("%-6.*s %5u %5u %4u %4u %8u %8u %3u.%u\n",
+                   RT_NAME_MAX, c->mp.parent.name, (rt_uint32_t)c->block_size,
+                   (rt_uint32_t)c->mp.block_total_count, (rt_uint32_t)c->mp.block_free_count,
+                   (rt_uint32_t)c->min_free, hits, misses, permille / 10, permille % 10);
+    }
+    rt_kprintf("oversize %u, heap frees %u, pool memory %u bytes\n",
+               (rt_uint32_t)rt_atomic_load(&oversize), (rt_uint32_t)rt_atomic_load(&heap_frees),
+               (rt_uint32_t)(sizeof(small_storage) + sizeof(medium_storage) + sizeof(large_storage)));
+    return 0;
+}
+MSH_CMD_EXPORT(list_lwip_mem, list lwIP size-class memory pools);
+#endif /* RT_USING_FINSH */
+
+#endif /* RT_LWIP_USING_MEMPOOL_HEAP */
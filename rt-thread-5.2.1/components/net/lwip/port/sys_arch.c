@@ -560,20 +560,21 @@ u32_t sys_now(void)
     return rt_tick_get_millisecond();
 }
 
-rt_weak void mem_init(void)
+void *mem_trim(void *mem, mem_size_t size)
 {
+    // return rt_realloc(mem, size);
+    /* not support trim yet */
+    return mem;
 }
 
-void *mem_calloc(mem_size_t count, mem_size_t size)
+#ifndef RT_LWIP_USING_MEMPOOL_HEAP
+rt_weak void mem_init(void)
 {
-    return rt_calloc(count, size);
 }
 
-void *mem_trim(void *mem, mem_size_t size)
+void *mem_calloc(mem_size_t count, mem_size_t size)
 {
-    // return rt_realloc(mem, size);
-    /* not support trim yet */
-    return mem;
+    return rt_calloc(count, size);
 }
 
 void *mem_malloc(mem_size_t size)
@@ -585,6 +586,7 @@ void  mem_free(void *mem)
 {
     rt_free(mem);
 }
+#endif /* RT_LWIP_USING_MEMPOOL_HEAP */
 
 #ifdef RT_LWIP_PPP
 u32_t sio_read(sio_fd_t fd, u8_t *buf, u32_t size)
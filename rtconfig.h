@@ -151,6 +151,13 @@
 
 /* DFS: device virtual file system */
 
+#define RT_USING_DFS
+#define DFS_USING_POSIX
+#define DFS_USING_WORKDIR
+#define DFS_FD_MAX 16
+#define RT_USING_DFS_V1
+#define DFS_FILESYSTEMS_MAX 4
+#define DFS_FILESYSTEM_TYPES_MAX 4
 /* end of DFS: device virtual file system */
 
 /* Device Drivers */
@@ -164,17 +171,14 @@
 #define RT_USING_SERIAL_V1
 #define RT_SERIAL_USING_DMA
 #define RT_SERIAL_RB_BUFSZ 64
+#define RT_USING_CPUTIME
+#define RT_USING_CPUTIME_CORTEXM
+#define CPUTIME_TIMER_FREQ 0
 #define RT_USING_I2C
 #define RT_I2C_DEBUG
 #define RT_USING_I2C_BITOPS
-#define RT_USING_SOFT_I2C
-#define RT_USING_SOFT_I2C1
-#define RT_SOFT_I2C1_SCL_PIN 22
-#define RT_SOFT_I2C1_SDA_PIN 23
-#define RT_SOFT_I2C1_BUS_NAME "i2c1"
-#define RT_SOFT_I2C1_TIMING_DELAY 10
-#define RT_SOFT_I2C1_TIMING_TIMEOUT 10
 #define RT_USING_PWM
+#define RT_USING_MTD_NOR
 #define RT_USING_SPI
 #define RT_USING_SENSOR
 #define RT_USING_SENSOR_CMD
@@ -205,6 +209,7 @@
 #define RT_WLAN_WORKQUEUE_THREAD_SIZE 2048
 #define RT_WLAN_WORKQUEUE_THREAD_PRIO 15
 #define RT_USING_PIN
+#define RT_USING_KTIME
 #define RT_USING_HWTIMER
 /* end of Device Drivers */
 
@@ -223,6 +228,9 @@
 
 /* POSIX (Portable Operating System Interface) layer */
 
+#define RT_USING_POSIX_FS
+#define RT_USING_POSIX_POLL
+#define RT_USING_POSIX_SELECT
 
 /* Interprocess Communication (IPC) */
 
@@ -242,7 +250,7 @@
 
 #define SAL_USING_LWIP
 /* end of Docking with protocol stacks */
-#define SAL_SOCKETS_NUM 16
+#define SAL_USING_POSIX
 #define RT_USING_NETDEV
 #define NETDEV_USING_IFCONFIG
 #define NETDEV_USING_PING
@@ -278,6 +286,7 @@
 #define RT_LWIP_TCP_SEG_NUM 40
 #define RT_LWIP_TCP_SND_BUF 8196
 #define RT_LWIP_TCP_WND 8196
+#define RT_LWIP_USING_MEMPOOL_HEAP
 #define RT_LWIP_TCPTHREAD_PRIORITY 10
 #define RT_LWIP_TCPTHREAD_MBOX_SIZE 8
 #define RT_LWIP_TCPTHREAD_STACKSIZE 4096
@@ -479,7 +488,6 @@
 
 #define PKG_USING_VL53L0X
 #define PKG_VL53L0X_USING_SENSOR_V1
-#define PKG_VL53L0X_USING_SENSOR_V1_SAMPLE
 #define PKG_USING_VL53L0X_LATEST_VERSION
 /* end of sensors drivers */
 
@@ -575,13 +583,22 @@
 /* On-chip Peripheral Drivers */
 
 #define BSP_USING_PIN
+#define BSP_USING_FLASH
 #define BSP_USING_UART
 #define BSP_USING_UART0
+#define BSP_UART_TX_BUFSZ 512
 #define BSP_USING_I2C
 #define BSP_USING_I2C2
+#define BSP_I2C2_BAUDRATE 400000
 #define BSP_USING_I2C3
+#define BSP_I2C3_BAUDRATE 400000
 #define BSP_USING_SPI
 #define BSP_USING_SPI1
+#define BSP_USING_HWTIMER
+#define BSP_USING_CTIMER0
+#define BSP_USING_KTIME
+#define BSP_USING_TICKLESS
+#define BSP_TICKLESS_THRESHOLD 2
 #define BSP_USING_PWM
 #define BSP_USING_PWM0
 /* end of On-chip Peripheral Drivers */
@@ -606,6 +623,35 @@
 #define PKG_USING_YS4028B12H_PERIOD 40000
 #define PKG_USING_YS4028B12H_DEFAULT_PAULSE 10000
 /* end of Fan Configuration */
+
+/* Control Loop Configuration */
+
+#define APP_CONTROL_TIMER_KTIME
+#define APP_CONTROL_LOOP_RATE_50HZ
+#define APP_CONTROL_LOOP_RATE_HZ 50
+#define APP_CONTROL_THREAD_PRIORITY 3
+#define APP_HEIGHT_ESTIMATOR_KALMAN
+#define APP_TOF_DEV_NAME "tof_vl53l0x"
+#define APP_TOF_I2C_BUS_NAME "i2c3"
+#define APP_TOF_XSHUT_PIN 57
+#define APP_TOF_INT_PIN 24
+#define APP_TOF_THREAD_PRIORITY 8
+/* end of Control Loop Configuration */
+
+/* Parameter Store Configuration */
+
+#define APP_USING_PARAM_STORE
+#define APP_PARAM_STORE_DEV_NAME "mflash"
+/* end of Parameter Store Configuration */
+
+/* System Monitor Configuration */
+
+#define APP_USING_SYSMON
+#define APP_SYSMON_MAX_THREADS 24
+#define APP_SYSMON_MAX_PROBES 4
+#define APP_SYSMON_LATENCY_THREAD "Control"
+#define APP_SYSMON_HEAP_AUDIT
+/* end of System Monitor Configuration */
 /* end of Application Configuration */
 
 #endif